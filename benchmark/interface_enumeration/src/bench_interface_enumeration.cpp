@@ -0,0 +1,241 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+
+/*
+ * Compares the enumeration of the IPv4 interface addresses:
+ *   SIOCGIFCONF : the former implementation with a 2048 byte buffer, addresses beyond
+ *                 the buffer are silently lost
+ *   lssdpcpp    : lssdp::updateNetworkInterfaces (RTM_GETADDR dump on Linux, getifaddrs
+ *                 on the other POSIX platforms)
+ *
+ * On Linux and with CAP_NET_ADMIN the benchmark adds /32 addresses in 10.200.0.0/16 to
+ * the loopback interface for each address count and removes them afterwards. Reported
+ * are the enumerated addresses and the time for each enumeration.
+ *
+ * usage: bench_interface_enumeration [iterations]
+ */
+
+#include <lssdpcpp/lssdpcpp.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+#ifndef _SIZEOF_ADDR_IFREQ
+#define _SIZEOF_ADDR_IFREQ sizeof
+#endif
+
+/**
+ * the enumeration before the RTM_GETADDR/getifaddrs enumerator, returns the address count
+ */
+size_t enumerateSIOCGIFCONF()
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    char buffer[2048];
+    struct ifconf ifc;
+    ifc.ifc_len = sizeof(buffer);
+    ifc.ifc_buf = buffer;
+    if (ioctl(fd, SIOCGIFCONF, &ifc) < 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    struct LegacyInterface
+    {
+        std::string _name;
+        uint32_t    _address;
+        uint32_t    _netmask;
+    };
+    std::vector<LegacyInterface> interfaces;
+    struct ifreq* ifr;
+    for (int i = 0; i < ifc.ifc_len; i += _SIZEOF_ADDR_IFREQ(*ifr))
+    {
+        ifr = reinterpret_cast<struct ifreq*>(buffer + i);
+        if (ifr->ifr_addr.sa_family != AF_INET)
+        {
+            continue;
+        }
+        struct sockaddr_in* addr = reinterpret_cast<struct sockaddr_in*>(&ifr->ifr_addr);
+        struct ifreq netmask = {};
+        strcpy(netmask.ifr_name, ifr->ifr_name);
+        if (ioctl(fd, SIOCGIFNETMASK, &netmask) != 0)
+        {
+            continue;
+        }
+        struct sockaddr_in* netmask_addr = reinterpret_cast<struct sockaddr_in*>(&netmask.ifr_addr);
+        interfaces.push_back({ ifr->ifr_name, addr->sin_addr.s_addr, netmask_addr->sin_addr.s_addr });
+    }
+    close(fd);
+    return interfaces.size();
+}
+#endif //_WIN32
+
+#ifdef __linux__
+/**
+ * adds (RTM_NEWADDR) or removes (RTM_DELADDR) the addresses 10.200.0.1 ... on the
+ * loopback interface, returns false without CAP_NET_ADMIN
+ */
+bool changeLoopbackAddresses(uint16_t type, size_t count)
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0)
+    {
+        return false;
+    }
+    unsigned int loopback_index = if_nametoindex("lo");
+    bool success = true;
+    for (size_t index = 0; index < count && success; ++index)
+    {
+        struct
+        {
+            struct nlmsghdr  _header;
+            struct ifaddrmsg _message;
+            struct rtattr    _attribute;
+            uint32_t         _address;
+        } request;
+        memset(&request, 0, sizeof(request));
+        request._header.nlmsg_len = sizeof(request);
+        request._header.nlmsg_type = type;
+        request._header.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK
+            | (type == RTM_NEWADDR ? NLM_F_CREATE | NLM_F_EXCL : 0);
+        request._header.nlmsg_seq = static_cast<uint32_t>(index + 1);
+        request._message.ifa_family = AF_INET;
+        request._message.ifa_prefixlen = 32;
+        request._message.ifa_index = loopback_index;
+        request._attribute.rta_type = IFA_LOCAL;
+        request._attribute.rta_len = RTA_LENGTH(sizeof(uint32_t));
+        request._address = htonl((10u << 24) | (200u << 16) | static_cast<uint32_t>(index + 1));
+
+        alignas(struct nlmsghdr) char answer[256];
+        success = send(fd, &request, sizeof(request), 0) == sizeof(request)
+            && recv(fd, answer, sizeof(answer), 0) > 0;
+        const struct nlmsghdr* header = reinterpret_cast<const struct nlmsghdr*>(answer);
+        if (success && header->nlmsg_type == NLMSG_ERROR)
+        {
+            const struct nlmsgerr* error = reinterpret_cast<const struct nlmsgerr*>(NLMSG_DATA(header));
+            success = error->error == 0;
+        }
+    }
+    close(fd);
+    return success;
+}
+#endif //__linux__
+
+void runEnumeration(const char* added, size_t iterations)
+{
+    using namespace std::chrono;
+    std::vector<lssdp::NetworkInterface> interfaces;
+
+    size_t count = 0;
+    auto begin_time = steady_clock::now();
+    for (size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        // from an empty vector, like the first enumeration of a Service
+        interfaces.clear();
+        lssdp::updateNetworkInterfaces(interfaces);
+        count = interfaces.size();
+    }
+    auto lssdp_time = (steady_clock::now() - begin_time) / iterations;
+
+    // the same without a change, the usual case of the periodic check
+    begin_time = steady_clock::now();
+    for (size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        lssdp::updateNetworkInterfaces(interfaces);
+    }
+    auto unchanged_time = (steady_clock::now() - begin_time) / iterations;
+
+    std::cout << "added: " << std::left << std::setw(6) << added
+              << " lssdpcpp: " << std::setw(6) << count
+              << " addresses " << std::setw(10) << duration_cast<nanoseconds>(lssdp_time).count()
+              << " ns, unchanged " << std::setw(10) << duration_cast<nanoseconds>(unchanged_time).count()
+              << " ns";
+#ifndef _WIN32
+    size_t legacy_count = 0;
+    begin_time = steady_clock::now();
+    for (size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        legacy_count = enumerateSIOCGIFCONF();
+    }
+    auto legacy_time = (steady_clock::now() - begin_time) / iterations;
+    std::cout << " SIOCGIFCONF: " << std::setw(6) << legacy_count
+              << " addresses " << std::setw(10) << duration_cast<nanoseconds>(legacy_time).count()
+              << " ns";
+#endif //_WIN32
+    std::cout << std::endl;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    size_t iterations = 200;
+    if (argc > 1)
+    {
+        iterations = std::stoull(argv[1]);
+    }
+
+    runEnumeration("0", iterations);
+#ifdef __linux__
+    const size_t counts[] = { 16, 64, 256, 1024, 4096 };
+    for (size_t count : counts)
+    {
+        bool added = changeLoopbackAddresses(RTM_NEWADDR, count);
+        if (added)
+        {
+            runEnumeration(std::to_string(count).c_str(), iterations);
+        }
+        changeLoopbackAddresses(RTM_DELADDR, count);
+        if (!added)
+        {
+            std::cout << "adding addresses to lo failed (CAP_NET_ADMIN required)" << std::endl;
+            break;
+        }
+    }
+#endif //__linux__
+    return 0;
+}
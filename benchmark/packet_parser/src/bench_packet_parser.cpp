@@ -0,0 +1,647 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+
+/*
+ * Compares the SSDP packet parsers:
+ *   char arrays : the former LSSDPPacket, memset of about 1 KB fixed char arrays on
+ *                 construction and a copy of each value into them
+ *   string refs : LSSDPPacket of lssdppacket.h, the fields refer to the receive buffer
+ *
+ * "parse" only parses, "parse + read" also does what the library does with the packet:
+ * a Service compares the ST of an M-SEARCH, a ServiceFinder copies the fields of a
+ * NOTIFY or response OK into std::strings for its ServiceDescription.
+ *
+ * The corpora measure the parse throughput of the receive path on realistic traffic:
+ * many devices, the header case, spacing and order and the optional UDA 1.1 headers
+ * vary like between vendors.
+ *   zeroed + strlen : the former receive path, a zeroed 2 KB buffer for each datagram
+ *                     and a strlen over the payload to validate its length
+ *   length-driven   : a reused buffer which is never zeroed, the parse is driven by
+ *                     the received length
+ *   vector scan     : the CRLF and colon positions of 64 bytes at once (AVX2 if the
+ *                     library is compiled for it, SSE2 or scalar otherwise) and the header
+ *                     names matched by a perfect hash
+ * Both copy the datagram into the buffer like the kernel does, the former two parse
+ * byte by byte and match the header names by a chain of strncasecmp.
+ * The vector scan is checked to yield the same fields as the byte by byte parse.
+ *
+ * usage: bench_packet_parser [iterations]
+ */
+
+#include <lssdpcpp/lssdppacket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+#ifdef WIN32
+inline int strncasecmp(const char* left, const char* right, size_t size)
+{
+    return _strnicmp(left, right, size);
+}
+#endif
+
+constexpr size_t LEGACY_FIELD_LEN = 128;
+constexpr size_t LEGACY_LOCATION_LEN = 256;
+
+/**
+ * the parser before the string refs (without the fields it never had)
+ */
+struct LegacyPacket
+{
+    char _method[LEGACY_FIELD_LEN];
+    char _st[LEGACY_FIELD_LEN];
+    char _usn[LEGACY_FIELD_LEN];
+    char _location[LEGACY_LOCATION_LEN];
+    char _nts[LEGACY_FIELD_LEN];
+    char _sm_id[LEGACY_FIELD_LEN];
+    char _device_type[LEGACY_FIELD_LEN];
+
+    LegacyPacket()
+    {
+        memset(_method, 0, sizeof(_method));
+        memset(_st, 0, sizeof(_st));
+        memset(_usn, 0, sizeof(_usn));
+        memset(_location, 0, sizeof(_location));
+        memset(_sm_id, 0, sizeof(_sm_id));
+        memset(_device_type, 0, sizeof(_device_type));
+        memset(_nts, 0, sizeof(_nts));
+    }
+
+    bool parse(const char* data, size_t data_len)
+    {
+        if (data_len != strlen(data))
+        {
+            return false;
+        }
+        size_t i;
+        if ((i = strlen(LSSDP_HEADER_MSEARCH)) < data_len && memcmp(data, LSSDP_HEADER_MSEARCH, i) == 0)
+        {
+            strncpy(_method, "M-SEARCH", sizeof(_method) - 1);
+        }
+        else if ((i = strlen(LSSDP_HEADER_NOTIFY)) < data_len && memcmp(data, LSSDP_HEADER_NOTIFY, i) == 0)
+        {
+            strncpy(_method, "NOTIFY", sizeof(_method) - 1);
+        }
+        else if ((i = strlen(LSSDP_HEADER_RESPONSE)) < data_len && memcmp(data, LSSDP_HEADER_RESPONSE, i) == 0)
+        {
+            strncpy(_method, "OK", sizeof(_method) - 1);
+        }
+        else
+        {
+            return false;
+        }
+        size_t start = i;
+        for (i = start; i < data_len; i++)
+        {
+            if (data[i] == '\n' && i - 1 > start && data[i - 1] == '\r')
+            {
+                parseFieldLine(data, start, i - 2);
+                start = i + 1;
+            }
+        }
+        return true;
+    }
+
+    void parseFieldLine(const char* data, size_t start, size_t end)
+    {
+        if (data[start] == ':')
+        {
+            return;
+        }
+        size_t colon = start + 1;
+        while (colon <= end && data[colon] != ':')
+        {
+            ++colon;
+        }
+        if (colon > end || colon == end)
+        {
+            return;
+        }
+        size_t i = start;
+        size_t j = colon - 1;
+        if (!trimSpaces(data, i, j))
+        {
+            return;
+        }
+        const char* field = &data[i];
+        size_t field_len = j - i + 1;
+        i = colon + 1;
+        j = end;
+        if (!trimSpaces(data, i, j))
+        {
+            return;
+        }
+        const char* value = &data[i];
+        size_t value_len = j - i + 1;
+
+        struct Target
+        {
+            const char* _name;
+            char*       _field;
+            size_t      _len;
+        };
+        const Target targets[] = {
+            { "st", _st, LEGACY_FIELD_LEN },
+            { "nt", _st, LEGACY_FIELD_LEN },
+            { "usn", _usn, LEGACY_FIELD_LEN },
+            { "location", _location, LEGACY_LOCATION_LEN },
+            { "sm_id", _sm_id, LEGACY_FIELD_LEN },
+            { "dev_type", _device_type, LEGACY_FIELD_LEN },
+            { "nts", _nts, LEGACY_FIELD_LEN },
+        };
+        for (const auto& target : targets)
+        {
+            if (field_len == strlen(target._name) && strncasecmp(field, target._name, field_len) == 0)
+            {
+                memcpy(target._field, value, value_len < target._len ? value_len : target._len - 1);
+                return;
+            }
+        }
+    }
+
+    static bool trimSpaces(const char* string, size_t& start, size_t& end)
+    {
+        int i = static_cast<int>(start);
+        int j = static_cast<int>(end);
+        while (i <= static_cast<int>(end) && (!isprint(string[i]) || isspace(string[i]))) i++;
+        while (j >= static_cast<int>(start) && (!isprint(string[j]) || isspace(string[j]))) j--;
+        if (i > j)
+        {
+            return false;
+        }
+        start = i;
+        end = j;
+        return true;
+    }
+};
+
+/**
+ * the string ref parser before the vector scan: byte by byte to each CRLF,
+ * memchr for the colon and a chain of strncasecmp for the header name
+ */
+struct BytewisePacket
+{
+    lssdp::StringRef _st;
+    lssdp::StringRef _usn;
+    lssdp::StringRef _location;
+    lssdp::StringRef _nts;
+    lssdp::StringRef _sm_id;
+    lssdp::StringRef _device_type;
+
+    bool parse(const char* data, size_t data_len)
+    {
+        size_t i;
+        if (!((i = strlen(LSSDP_HEADER_MSEARCH)) < data_len && memcmp(data, LSSDP_HEADER_MSEARCH, i) == 0)
+            && !((i = strlen(LSSDP_HEADER_NOTIFY)) < data_len && memcmp(data, LSSDP_HEADER_NOTIFY, i) == 0)
+            && !((i = strlen(LSSDP_HEADER_RESPONSE)) < data_len && memcmp(data, LSSDP_HEADER_RESPONSE, i) == 0))
+        {
+            return false;
+        }
+        size_t start = i;
+        for (i = start; i < data_len; i++)
+        {
+            if (data[i] == '\n' && i - 1 > start && data[i - 1] == '\r')
+            {
+                parseFieldLine(data, start, i - 2);
+                start = i + 1;
+            }
+        }
+        return true;
+    }
+
+    void parseFieldLine(const char* data, size_t start, size_t end)
+    {
+        if (data[start] == ':')
+        {
+            return;
+        }
+        const char* colon_position = static_cast<const char*>(memchr(&data[start + 1], ':', end - start));
+        if (colon_position == NULL)
+        {
+            return;
+        }
+        size_t colon = static_cast<size_t>(colon_position - data);
+        if (colon == end)
+        {
+            return;
+        }
+        size_t i = start;
+        size_t j = colon - 1;
+        if (!LegacyPacket::trimSpaces(data, i, j))
+        {
+            return;
+        }
+        const char* field = &data[i];
+        size_t field_len = j - i + 1;
+        i = colon + 1;
+        j = end;
+        if (!LegacyPacket::trimSpaces(data, i, j))
+        {
+            return;
+        }
+        lssdp::StringRef value(&data[i], j - i + 1);
+
+        struct Target
+        {
+            const char*       _name;
+            lssdp::StringRef* _field;
+        };
+        const Target targets[] = {
+            { "st", &_st },
+            { "nt", &_st },
+            { "usn", &_usn },
+            { "location", &_location },
+            { "sm_id", &_sm_id },
+            { "dev_type", &_device_type },
+            { "nts", &_nts },
+        };
+        for (const auto& target : targets)
+        {
+            if (field_len == strlen(target._name) && strncasecmp(field, target._name, field_len) == 0)
+            {
+                *target._field = value;
+                return;
+            }
+        }
+    }
+};
+
+struct Message
+{
+    const char* _name;
+    std::string _data;
+};
+
+std::vector<Message> createMessages()
+{
+    return {
+        { "M-SEARCH",
+          "M-SEARCH * HTTP/1.1\r\n"
+          "HOST:239.255.255.250:1900\r\n"
+          "MAN:\"ssdp:discover\"\r\n"
+          "MX:5\r\n"
+          "ST:urn:schemas-upnp-org:device:MediaRenderer:1\r\n"
+          "USER-AGENT:Linux/6.1 MyProduct/1.1\r\n"
+          "\r\n" },
+        { "NOTIFY",
+          "NOTIFY * HTTP/1.1\r\n"
+          "HOST:239.255.255.250:1900\r\n"
+          "CACHE-CONTROL:max-age=1800\r\n"
+          "LOCATION:http://192.168.1.23:49152/description.xml\r\n"
+          "SERVER:Linux/6.1 UPnP/1.1 MyProduct/1.1\r\n"
+          "NT:urn:schemas-upnp-org:device:MediaRenderer:1\r\n"
+          "NTS:ssdp:alive\r\n"
+          "USN:uuid:2fac1234-31f8-11b4-a222-08002b34c003::urn:schemas-upnp-org:device:MediaRenderer:1\r\n"
+          "SM_ID:device_4711\r\n"
+          "DEV_TYPE:renderer\r\n"
+          "\r\n" },
+        { "200 OK",
+          "HTTP/1.1 200 OK\r\n"
+          "CACHE-CONTROL:max-age=1800\r\n"
+          "DATE:\r\n"
+          "EXT:\r\n"
+          "LOCATION:http://192.168.1.23:49152/description.xml\r\n"
+          "SERVER:Linux/6.1 UPnP/1.1 MyProduct/1.1\r\n"
+          "ST:urn:schemas-upnp-org:device:MediaRenderer:1\r\n"
+          "USN:uuid:2fac1234-31f8-11b4-a222-08002b34c003::urn:schemas-upnp-org:device:MediaRenderer:1\r\n"
+          "\r\n" },
+    };
+}
+
+// what the library reads of a packet, the sum keeps the compiler from dropping it
+size_t readLegacy(const LegacyPacket& packet)
+{
+    if (strcmp(packet._method, "M-SEARCH") == 0)
+    {
+        return strcmp(packet._st, "ssdp:all") == 0 ? 1 : 2;
+    }
+    std::string location(packet._location);
+    std::string usn(packet._usn);
+    std::string st(packet._st);
+    std::string sm_id(packet._sm_id);
+    std::string device_type(packet._device_type);
+    return location.size() + usn.size() + st.size() + sm_id.size() + device_type.size();
+}
+
+size_t readStringRefs(const lssdp::LSSDPPacket& packet)
+{
+    if (packet._method == lssdp::LSSDPPacket::msearch)
+    {
+        return packet._st == "ssdp:all" ? 1 : 2;
+    }
+    std::string location = packet._location.str();
+    std::string usn = packet._usn.str();
+    std::string st = packet._st.str();
+    std::string sm_id = packet._sm_id.str();
+    std::string device_type = packet._device_type.str();
+    return location.size() + usn.size() + st.size() + sm_id.size() + device_type.size();
+}
+
+template <typename Packet, typename Read>
+double measure(const Message& message, size_t iterations, bool read_fields, Read read)
+{
+    using namespace std::chrono;
+    size_t checksum = 0;
+    auto begin_time = steady_clock::now();
+    for (size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        Packet packet;
+        if (packet.parse(message._data.c_str(), message._data.size()))
+        {
+            checksum += read_fields ? read(packet) : 1;
+        }
+    }
+    auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - begin_time).count();
+    if (checksum == 0)
+    {
+        std::cout << "parse failed" << std::endl;
+    }
+    return static_cast<double>(elapsed) / static_cast<double>(iterations);
+}
+
+constexpr size_t CORPUS_SIZE = 512;
+constexpr size_t RECEIVE_BUFFER_LEN = 2048;
+
+std::string pick(std::mt19937& random, const std::vector<std::string>& choices)
+{
+    return choices[random() % choices.size()];
+}
+
+// the header name as different vendors write it
+std::string header(std::mt19937& random, const std::string& name)
+{
+    std::string written = name;
+    switch (random() % 3)
+    {
+    case 0:
+        for (auto& current : written)
+        {
+            current = static_cast<char>(tolower(static_cast<unsigned char>(current)));
+        }
+        break;
+    case 1:
+        for (size_t index = 1; index < written.size(); ++index)
+        {
+            if (isalpha(static_cast<unsigned char>(written[index - 1])))
+            {
+                written[index] = static_cast<char>(tolower(static_cast<unsigned char>(written[index])));
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    return written + (random() % 2 == 0 ? ":" : ": ");
+}
+
+std::string createUuid(std::mt19937& random)
+{
+    char uuid[40];
+    snprintf(uuid, sizeof(uuid), "%08x-%04x-%04x-%04x-%08x%04x",
+             static_cast<unsigned int>(random()), static_cast<unsigned int>(random() & 0xFFFF),
+             static_cast<unsigned int>(random() & 0xFFFF), static_cast<unsigned int>(random() & 0xFFFF),
+             static_cast<unsigned int>(random()), static_cast<unsigned int>(random() & 0xFFFF));
+    return uuid;
+}
+
+std::string createLocation(std::mt19937& random)
+{
+    return "http://192.168." + std::to_string(random() % 256) + "." + std::to_string(1 + random() % 254)
+        + ":" + std::to_string(1024 + random() % 60000)
+        + pick(random, { "/description.xml", "/rootDesc.xml", "/upnp/dev/desc", "/dmr/SamsungMRDesc.xml" });
+}
+
+std::vector<std::string> createCorpus(const std::string& kind)
+{
+    const std::vector<std::string> device_types = {
+        "upnp:rootdevice",
+        "urn:schemas-upnp-org:device:MediaRenderer:1",
+        "urn:schemas-upnp-org:device:MediaServer:1",
+        "urn:schemas-upnp-org:device:InternetGatewayDevice:1",
+        "urn:schemas-upnp-org:service:ContentDirectory:1",
+        "urn:schemas-upnp-org:service:WANIPConnection:2",
+        "urn:dial-multiscreen-org:service:dial:1",
+    };
+    const std::vector<std::string> servers = {
+        "Linux/5.10 UPnP/1.0 MiniUPnPd/2.2",
+        "Linux/3.14 UPnP/1.1 Portable SDK for UPnP devices/1.14.0",
+        "Microsoft-Windows/10.0 UPnP/1.0 UPnP-Device-Host/1.0",
+        "FreeRTOS/10 UPnP/1.1 Sonos/70.3-35220",
+    };
+    std::mt19937 random(4711);
+    std::vector<std::string> corpus;
+    for (size_t index = 0; index < CORPUS_SIZE; ++index)
+    {
+        std::string device_type = pick(random, device_types);
+        std::string uuid = "uuid:" + createUuid(random);
+        std::string usn = (device_type == "upnp:rootdevice" || random() % 4 == 0) ? uuid : uuid + "::" + device_type;
+        std::string message;
+        if (kind == "M-SEARCH")
+        {
+            message = std::string(LSSDP_HEADER_MSEARCH)
+                + header(random, "HOST") + "239.255.255.250:1900\r\n"
+                + header(random, "MAN") + "\"ssdp:discover\"\r\n"
+                + header(random, "MX") + std::to_string(1 + random() % 5) + "\r\n"
+                + header(random, "ST") + (random() % 3 == 0 ? std::string("ssdp:all") : device_type) + "\r\n";
+            if (random() % 2 == 0)
+            {
+                message += header(random, "USER-AGENT") + pick(random, servers) + "\r\n";
+            }
+            if (random() % 3 == 0)
+            {
+                message += header(random, "CPFN.UPNP.ORG") + "Living Room Remote\r\n";
+            }
+        }
+        else
+        {
+            bool is_notify = (kind == "NOTIFY");
+            std::vector<std::string> lines = {
+                header(random, "CACHE-CONTROL") + "max-age=" + std::to_string(120 + random() % 1800),
+                header(random, "LOCATION") + createLocation(random),
+                header(random, "SERVER") + pick(random, servers),
+                header(random, is_notify ? "NT" : "ST") + device_type,
+                header(random, "USN") + usn,
+            };
+            if (is_notify)
+            {
+                lines.push_back(header(random, "HOST") + "239.255.255.250:1900");
+                lines.push_back(header(random, "NTS") + (random() % 8 == 0 ? "ssdp:byebye" : "ssdp:alive"));
+            }
+            else
+            {
+                lines.push_back(header(random, "DATE") + "Fri, 16 Oct 2026 08:49:37 GMT");
+                lines.push_back(header(random, "EXT"));
+            }
+            if (random() % 2 == 0)
+            {
+                lines.push_back(header(random, "BOOTID.UPNP.ORG") + std::to_string(random() % 1000));
+                lines.push_back(header(random, "CONFIGID.UPNP.ORG") + std::to_string(random() % 100));
+            }
+            if (random() % 3 == 0)
+            {
+                lines.push_back(header(random, "OPT") + "\"http://schemas.upnp.org/upnp/1/0/\"; ns=01");
+                lines.push_back(header(random, "01-NLS") + createUuid(random));
+            }
+            if (random() % 4 == 0)
+            {
+                lines.push_back(header(random, "X-User-Agent") + "redsonic");
+            }
+            if (random() % 4 == 0)
+            {
+                lines.push_back(header(random, "SM_ID") + "device_" + std::to_string(random() % 10000));
+                lines.push_back(header(random, "DEV_TYPE") + "renderer");
+            }
+            // the header order differs between the vendors
+            std::shuffle(lines.begin(), lines.end(), random);
+            message = is_notify ? LSSDP_HEADER_NOTIFY : LSSDP_HEADER_RESPONSE;
+            for (const auto& line : lines)
+            {
+                message += line + "\r\n";
+            }
+        }
+        message += "\r\n";
+        corpus.push_back(message);
+    }
+    return corpus;
+}
+
+void measureCorpus(const std::string& kind, size_t iterations)
+{
+    using namespace std::chrono;
+    std::vector<std::string> corpus = createCorpus(kind);
+    size_t corpus_bytes = 0;
+    for (const auto& datagram : corpus)
+    {
+        corpus_bytes += datagram.size();
+    }
+    size_t passes = std::max<size_t>(1, iterations / corpus.size());
+
+    std::cout << std::left << std::setw(9) << kind
+              << " corpus: " << corpus.size() << " datagrams, "
+              << corpus_bytes / corpus.size() << " bytes average";
+    static char buffer[RECEIVE_BUFFER_LEN];
+    for (const auto& datagram : corpus)
+    {
+        BytewisePacket bytewise;
+        lssdp::LSSDPPacket scanned;
+        if (bytewise.parse(datagram.data(), datagram.size()) != scanned.parse(datagram.data(), datagram.size())
+            || bytewise._st._data != scanned._st._data || bytewise._st._size != scanned._st._size
+            || bytewise._usn._data != scanned._usn._data || bytewise._usn._size != scanned._usn._size
+            || bytewise._location._data != scanned._location._data || bytewise._location._size != scanned._location._size
+            || bytewise._nts._data != scanned._nts._data || bytewise._nts._size != scanned._nts._size)
+        {
+            std::cout << std::endl << "the vector scan differs from the byte by byte parse:" << std::endl << datagram << std::endl;
+            exit(1);
+        }
+    }
+    enum Mode
+    {
+        zeroed,
+        length_driven,
+        vector_scan
+    };
+    for (Mode mode : { zeroed, length_driven, vector_scan })
+    {
+        size_t parsed = 0;
+        auto begin_time = steady_clock::now();
+        for (size_t pass = 0; pass < passes; ++pass)
+        {
+            for (const auto& datagram : corpus)
+            {
+                if (mode == zeroed)
+                {
+                    memset(buffer, 0, sizeof(buffer));
+                }
+                memcpy(buffer, datagram.data(), datagram.size());
+                if (mode == zeroed && strlen(buffer) != datagram.size())
+                {
+                    continue;
+                }
+                if (mode == vector_scan)
+                {
+                    lssdp::LSSDPPacket packet;
+                    if (packet.parse(buffer, datagram.size()) && !packet._st.empty())
+                    {
+                        ++parsed;
+                    }
+                }
+                else
+                {
+                    BytewisePacket packet;
+                    if (packet.parse(buffer, datagram.size()) && !packet._st.empty())
+                    {
+                        ++parsed;
+                    }
+                }
+            }
+        }
+        double elapsed = static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - begin_time).count());
+        double packets = static_cast<double>(passes * corpus.size());
+        std::cout << (mode == zeroed ? "  zeroed + strlen: " : mode == length_driven ? "  length-driven: " : "  vector scan: ")
+                  << std::setw(7) << std::setprecision(4) << elapsed / packets << " ns/packet "
+                  << std::setw(7) << std::setprecision(4) << (packets * corpus_bytes / corpus.size()) / (elapsed / 1e9) / 1e6
+                  << " MB/s";
+        if (parsed != passes * corpus.size())
+        {
+            std::cout << " (" << passes * corpus.size() - parsed << " not parsed)";
+        }
+    }
+    std::cout << std::endl;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    size_t iterations = 1000000;
+    if (argc > 1)
+    {
+        iterations = std::stoull(argv[1]);
+    }
+
+    for (const auto& message : createMessages())
+    {
+        for (bool read_fields : { false, true })
+        {
+            double legacy = measure<LegacyPacket>(message, iterations, read_fields, readLegacy);
+            double string_refs = measure<lssdp::LSSDPPacket>(message, iterations, read_fields, readStringRefs);
+            std::cout << std::left << std::setw(9) << message._name
+                      << std::setw(13) << (read_fields ? "parse + read" : "parse")
+                      << " char arrays ns/packet: " << std::setw(8) << std::setprecision(4) << legacy
+                      << " string refs ns/packet: " << std::setw(8) << std::setprecision(4) << string_refs
+                      << std::endl;
+        }
+    }
+    for (const char* kind : { "M-SEARCH", "NOTIFY", "200 OK" })
+    {
+        measureCorpus(kind, iterations);
+    }
+    return 0;
+}
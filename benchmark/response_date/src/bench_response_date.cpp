@@ -0,0 +1,197 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+
+/*
+ * Compares the cost of assembling a response OK with and without a DATE:
+ *   fixed string  : the former prepared std::string with an empty DATE, copied as one buffer
+ *   empty DATE    : the message template of lssdpmessage.h with an empty DATE slot
+ *   cached DATE   : the template with the RFC 1123 date of HttpDate::now(), formatted at most
+ *                   once per second and thread
+ *   batch DATE    : the cached date taken once for a batch of 64 responses, like the
+ *                   ServiceHost does for the responses sent in one wakeup
+ *   strftime DATE : the template with the date formatted by gmtime and strftime for each response
+ *
+ * Reported are the ns for each response to point the segments (iovecs) at the message and,
+ * separately, including to gather them into a send buffer like the kernel does.
+ *
+ * usage: bench_response_date [responses]
+ */
+
+#include <lssdpcpp/lssdpmessage.h>
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+constexpr size_t BENCH_BUFFER_LEN = 2048;
+constexpr size_t BENCH_BATCH = 64;
+constexpr const char* const BENCH_SERVER = "Linux/5.15 MyProduct/1.1";
+constexpr const char* const BENCH_LOCATION = "http://192.168.1.34:9092/description.xml";
+constexpr const char* const BENCH_SEARCH_TARGET = "urn:schemas-upnp-org:device:MediaServer:1";
+constexpr const char* const BENCH_USN = "uuid:4d696e69-444c-164e-9d41-b827eb54e0a1::urn:schemas-upnp-org:device:MediaServer:1";
+
+std::string createFixedResponse()
+{
+    return std::string(LSSDP_HEADER_RESPONSE)
+        + "CACHE-CONTROL:max-age=1800\r\n"
+        + "DATE:\r\n"
+        + "EXT:\r\n"
+        + "LOCATION:" + BENCH_LOCATION + "\r\n"
+        + "SERVER:" + BENCH_SERVER + "\r\n"
+        + "ST:" + BENCH_SEARCH_TARGET + "\r\n"
+        + "USN:" + BENCH_USN + "\r\n"
+        + "\r\n";
+}
+
+lssdp::MessageTemplate createResponseTemplate()
+{
+    lssdp::MessageTemplate response;
+    response.add(LSSDP_HEADER_RESPONSE)
+            .addHeader("CACHE-CONTROL:", "max-age=1800")
+            .add("DATE:").addSlot(lssdp::MessageTemplate::slot_date).add("\r\n")
+            .add("EXT:\r\n")
+            .add("LOCATION:").addSlot(lssdp::MessageTemplate::slot_location).add("\r\n")
+            .addHeader("SERVER:", BENCH_SERVER)
+            .addHeader("ST:", BENCH_SEARCH_TARGET)
+            .addHeader("USN:", BENCH_USN)
+            .addSlot(lssdp::MessageTemplate::slot_boot_id).add("\r\n");
+    return response;
+}
+
+/**
+ * copies the segments into @p buffer, the work of the kernel for the iovecs
+ */
+size_t gather(const lssdp::StringRef* segments, size_t segment_count, char* buffer)
+{
+    size_t size = 0;
+    for (size_t index = 0; index < segment_count; ++index)
+    {
+        memcpy(&buffer[size], segments[index]._data, segments[index]._size);
+        size += segments[index]._size;
+    }
+    return size;
+}
+
+/**
+ * ns for each response to point the segments at the message by @p assemble,
+ * with @p with_gather also to gather them into a send buffer
+ */
+template <typename Assemble>
+double measure(size_t responses, bool with_gather, Assemble assemble)
+{
+    using namespace std::chrono;
+    char buffer[BENCH_BUFFER_LEN];
+    lssdp::StringRef segments[LSSDP_MAX_SEGMENTS];
+    size_t segment_count = 0;
+    size_t checksum = 0;
+    auto begin_time = steady_clock::now();
+    for (size_t response = 0; response < responses; ++response)
+    {
+        assemble(segments, segment_count);
+        if (with_gather)
+        {
+            checksum += gather(segments, segment_count, buffer);
+            checksum += static_cast<unsigned char>(buffer[checksum % 64]);
+        }
+        else
+        {
+            checksum += segments[segment_count - 1]._size + static_cast<unsigned char>(segments[0]._data[0]);
+        }
+    }
+    auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - begin_time).count();
+    if (checksum == 0)
+    {
+        std::cout << "nothing assembled" << std::endl;
+    }
+    return static_cast<double>(elapsed) / static_cast<double>(responses);
+}
+
+template <typename Assemble>
+void report(const char* name, size_t responses, Assemble assemble)
+{
+    double assembled = measure(responses, false, assemble);
+    double gathered = measure(responses, true, assemble);
+    std::cout << std::left << std::setw(14) << name
+              << " assemble ns/response: " << std::setw(6) << std::fixed << std::setprecision(1) << assembled
+              << " + gather ns/response: " << gathered << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t responses = 10000000;
+    if (argc > 1)
+    {
+        responses = std::stoull(argv[1]);
+    }
+
+    const std::string fixed_response = createFixedResponse();
+    const lssdp::MessageTemplate response_template = createResponseTemplate();
+    const std::string location = BENCH_LOCATION;
+    lssdp::StringRef slot_values[lssdp::MessageTemplate::slot_count];
+    slot_values[lssdp::MessageTemplate::slot_location] = lssdp::StringRef(location.data(), location.size());
+
+    report("fixed string", responses, [&](lssdp::StringRef* segments, size_t& segment_count)
+    {
+        segments[0] = lssdp::StringRef(fixed_response.data(), fixed_response.size());
+        segment_count = 1;
+    });
+
+    report("empty DATE", responses, [&](lssdp::StringRef* segments, size_t& segment_count)
+    {
+        slot_values[lssdp::MessageTemplate::slot_date] = lssdp::StringRef();
+        response_template.fill(slot_values, segments, segment_count);
+    });
+
+    report("cached DATE", responses, [&](lssdp::StringRef* segments, size_t& segment_count)
+    {
+        slot_values[lssdp::MessageTemplate::slot_date] = lssdp::HttpDate::now();
+        response_template.fill(slot_values, segments, segment_count);
+    });
+
+    size_t batch_count = 0;
+    report("batch DATE", responses, [&](lssdp::StringRef* segments, size_t& segment_count)
+    {
+        if (batch_count++ % BENCH_BATCH == 0)
+        {
+            slot_values[lssdp::MessageTemplate::slot_date] = lssdp::HttpDate::now();
+        }
+        response_template.fill(slot_values, segments, segment_count);
+    });
+
+    char date[64];
+    report("strftime DATE", responses, [&](lssdp::StringRef* segments, size_t& segment_count)
+    {
+        std::time_t now = std::time(nullptr);
+        size_t date_size = std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", std::gmtime(&now));
+        slot_values[lssdp::MessageTemplate::slot_date] = lssdp::StringRef(date, date_size);
+        response_template.fill(slot_values, segments, segment_count);
+    });
+    return 0;
+}
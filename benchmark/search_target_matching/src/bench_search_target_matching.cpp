@@ -0,0 +1,201 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+
+/*
+ * Compares the search target matching of a ServiceHost with many services:
+ *   linear scan : each service compared to the ST of the M-SEARCH by the matching rules
+ *   index       : SearchTargetIndex of lssdpsearchtarget.h, one hash lookup for each M-SEARCH
+ *                 and a binary search over the versions of a urn type
+ *
+ * The services are those a UPnP device advertises: its uuid, its device type and
+ * service types (urn:...:ver) and every tenth device is a root device.
+ * The M-SEARCH of each kind (ssdp:all, upnp:rootdevice, uuid:, urn with version,
+ * one with DEV_TYPE and an unknown ST) are measured with 100, 1000 and 10000 services.
+ * Both are checked to yield the same services.
+ *
+ * usage: bench_search_target_matching [searches]
+ */
+
+#include <lssdpcpp/lssdpsearchtarget.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Target
+{
+    std::string _search_target;
+    std::string _unique_service_name;
+    std::string _device_type;
+};
+
+struct Search
+{
+    const char* _name;
+    std::string _search_target;
+    std::string _device_type;
+};
+
+/**
+ * the services advertised by devices until there are @p count of them
+ */
+std::vector<Target> createTargets(size_t count)
+{
+    std::vector<Target> targets;
+    for (size_t device = 0; targets.size() < count; ++device)
+    {
+        const std::string uuid = "uuid:device-" + std::to_string(device);
+        const std::string device_type = "Type" + std::to_string(device % 20);
+        const std::string device_urn = "urn:schemas-upnp-org:device:" + device_type + ":" + std::to_string(device % 3 + 1);
+        if (device % 10 == 0)
+        {
+            targets.push_back({ LSSDP_SEARCH_TARGET_ROOT_DEVICE, uuid + LSSDP_USN_ROOT_DEVICE_SUFFIX, device_type });
+        }
+        targets.push_back({ uuid, uuid, device_type });
+        targets.push_back({ device_urn, uuid + "::" + device_urn, device_type });
+        for (size_t service = 0; service < 2; ++service)
+        {
+            const std::string service_urn = "urn:schemas-upnp-org:service:Service" + std::to_string((device + service) % 50)
+                                            + ":" + std::to_string(service + 1);
+            targets.push_back({ service_urn, uuid + "::" + service_urn, device_type });
+        }
+    }
+    targets.resize(count);
+    return targets;
+}
+
+std::vector<Search> createSearches(size_t count)
+{
+    return {
+        { "ssdp:all", LSSDP_SEARCH_TARGET_ALL, "" },
+        { "upnp:rootdevice", LSSDP_SEARCH_TARGET_ROOT_DEVICE, "" },
+        { "uuid:", "uuid:device-" + std::to_string(count / 8), "" },
+        { "urn:device:1", "urn:schemas-upnp-org:device:Type7:1", "" },
+        { "urn:service:2", "urn:schemas-upnp-org:service:Service7:2", "" },
+        { "DEV_TYPE", "urn:schemas-upnp-org:service:Service7:1", "Type7" },
+        { "unknown", "urn:schemas-upnp-org:service:Unknown:1", "" }
+    };
+}
+
+void matchLinear(const std::vector<Target>& targets, const Search& search, std::vector<uint32_t>& matching)
+{
+    for (size_t index = 0; index < targets.size(); ++index)
+    {
+        const auto& target = targets[index];
+        if (lssdp::matchesSearchTarget(search._search_target,
+                                       lssdp::StringRef(target._search_target.data(), target._search_target.size()),
+                                       lssdp::StringRef(target._unique_service_name.data(), target._unique_service_name.size()))
+            && (search._device_type.empty() || search._device_type == target._device_type))
+        {
+            matching.push_back(static_cast<uint32_t>(index));
+        }
+    }
+}
+
+void matchIndex(lssdp::SearchTargetIndex& index, const Search& search, std::vector<uint32_t>& matching)
+{
+    index.match(lssdp::StringRef(search._search_target.data(), search._search_target.size()),
+                lssdp::StringRef(search._device_type.data(), search._device_type.size()),
+                matching);
+}
+
+template <typename Match>
+double measure(size_t searches, size_t& matched, Match match)
+{
+    using namespace std::chrono;
+    std::vector<uint32_t> matching;
+    matched = 0;
+    auto begin_time = steady_clock::now();
+    for (size_t search = 0; search < searches; ++search)
+    {
+        matching.clear();
+        match(matching);
+        matched += matching.size();
+    }
+    auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - begin_time).count();
+    return static_cast<double>(elapsed) / static_cast<double>(searches);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t searches = 20000;
+    if (argc > 1)
+    {
+        searches = std::stoull(argv[1]);
+    }
+
+    for (size_t count : { 100, 1000, 10000 })
+    {
+        auto targets = createTargets(count);
+        lssdp::SearchTargetIndex index;
+        for (size_t service = 0; service < targets.size(); ++service)
+        {
+            index.add(static_cast<uint32_t>(service),
+                      targets[service]._search_target,
+                      targets[service]._unique_service_name,
+                      targets[service]._device_type);
+        }
+
+        for (const auto& search : createSearches(count))
+        {
+            std::vector<uint32_t> expected;
+            std::vector<uint32_t> found;
+            matchLinear(targets, search, expected);
+            matchIndex(index, search, found);
+            std::sort(found.begin(), found.end());
+            if (found != expected)
+            {
+                std::cout << "the index does not match the linear scan for " << search._name << std::endl;
+                return 1;
+            }
+
+            size_t linear_matched = 0;
+            size_t index_matched = 0;
+            double linear = measure(std::max<size_t>(searches * 100 / count, 10), linear_matched,
+                                    [&](std::vector<uint32_t>& matching)
+                                    {
+                                        matchLinear(targets, search, matching);
+                                    });
+            double indexed = measure(searches, index_matched,
+                                     [&](std::vector<uint32_t>& matching)
+                                     {
+                                         matchIndex(index, search, matching);
+                                     });
+            std::cout << std::left << std::setw(6) << count << " services "
+                      << std::setw(16) << search._name
+                      << " matches: " << std::setw(6) << expected.size()
+                      << " linear scan ns/search: " << std::setw(10) << std::fixed << std::setprecision(1) << linear
+                      << " index ns/search: " << std::setw(8) << indexed
+                      << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+
+/*
+ * Compares the receive paths of the multicast socket:
+ *   select path : one datagram for each wakeup (batch size 1), no io_uring
+ *   recvmmsg    : a batch of datagrams for each wakeup, no io_uring
+ *   io_uring    : multishot receive with provided buffers (cmake option lssdpcpp_enable_io_uring)
+ *
+ * A service sends bursts of NOTIFY on all interfaces from a second thread while a
+ * ServiceFinder receives them. Reported are the wakeups and the CPU time of the
+ * receiving thread for each datagram.
+ *
+ * usage: bench_socket_backend [datagrams]
+ */
+
+#include <lssdpcpp/lssdpcpp.h>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+
+namespace
+{
+constexpr const char* const BENCH_URL = "udp://239.255.255.250:1911";
+constexpr size_t BENCH_BURST = 16;
+
+struct Backend
+{
+    const char* _name;
+    bool        _disable_io_uring;
+    size_t      _receive_batch_size;
+};
+
+void setIoUringDisabled(bool disabled)
+{
+#ifdef _WIN32
+    _putenv_s("LSSDP_DISABLE_IO_URING", disabled ? "1" : "");
+#else
+    if (disabled)
+    {
+        setenv("LSSDP_DISABLE_IO_URING", "1", 1);
+    }
+    else
+    {
+        unsetenv("LSSDP_DISABLE_IO_URING");
+    }
+#endif
+}
+
+std::chrono::nanoseconds getThreadCpuTime()
+{
+#ifdef __linux__
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+#else
+    // process time, the sending thread is included
+    return std::chrono::nanoseconds(static_cast<int64_t>(std::clock() * (1e9 / CLOCKS_PER_SEC)));
+#endif
+}
+
+void runBackend(const Backend& backend, uint64_t datagrams)
+{
+    using namespace std::chrono;
+    setIoUringDisabled(backend._disable_io_uring);
+
+    // sockets are opened (and io_uring is set up) in the constructors
+    lssdp::ServiceFinder finder(BENCH_URL, "bench", "1.0", "bench_target");
+    finder.setReceiveBatchSize(backend._receive_batch_size);
+    lssdp::Service service(BENCH_URL, seconds(1800), "http://localhost:9090", "bench_service",
+                           "bench_target", "bench", "1.0");
+
+    std::atomic<bool> sender_done(false);
+    std::thread sender([&]() {
+        while (service.getStatistics()._notify._datagrams_sent < datagrams)
+        {
+            for (size_t burst = 0; burst < BENCH_BURST; ++burst)
+            {
+                service.sendNotifyAlive();
+            }
+            std::this_thread::sleep_for(microseconds(500));
+        }
+        sender_done = true;
+    });
+
+    uint64_t events = 0;
+    auto callback = [&events](const lssdp::ServiceFinder::ServiceUpdateEvent&) { ++events; };
+    auto cpu_start = getThreadCpuTime();
+    auto wall_start = steady_clock::now();
+    while (!sender_done)
+    {
+        finder.checkForServices(callback, milliseconds(10));
+    }
+    // drain what is still in flight
+    finder.checkForServices(callback, milliseconds(100));
+    auto cpu_time = getThreadCpuTime() - cpu_start;
+    auto wall_time = steady_clock::now() - wall_start;
+    sender.join();
+
+    auto finder_statistics = finder.getStatistics();
+    auto service_statistics = service.getStatistics();
+    uint64_t received = finder_statistics._receive._datagrams_received;
+    uint64_t wakeups = finder_statistics._receive._batches;
+    std::cout << std::left << std::setw(12) << backend._name
+              << " io_uring: " << (finder_statistics._receive._io_uring ? "yes" : "no ")
+              << " sent: " << std::setw(8) << service_statistics._notify._datagrams_sent
+              << " received: " << std::setw(8) << received
+              << " events: " << std::setw(8) << events
+              << " wakeups: " << std::setw(8) << wakeups
+              << " datagrams/wakeup: " << std::setw(6) << std::setprecision(3)
+              << (wakeups > 0 ? static_cast<double>(received) / wakeups : 0.0)
+              << " receiver cpu ns/datagram: " << std::setw(8)
+              << (received > 0 ? duration_cast<nanoseconds>(cpu_time).count() / static_cast<int64_t>(received) : 0)
+              << " wall ms: " << duration_cast<milliseconds>(wall_time).count()
+              << std::endl;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t datagrams = 20000;
+    if (argc > 1)
+    {
+        datagrams = std::stoull(argv[1]);
+    }
+
+    const Backend backends[] = {
+        { "select path", true, 1 },
+        { "recvmmsg", true, 32 },
+        { "io_uring", false, 32 },
+    };
+    for (const auto& backend : backends)
+    {
+        runBackend(backend, datagrams);
+    }
+    return 0;
+}
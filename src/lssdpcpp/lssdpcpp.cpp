@@ -22,11 +22,21 @@
 ******************************************************************************************/
 
 #include <lssdpcpp/lssdpcpp.h>
+#include <lssdpcpp/lssdppacket.h>
+#include <lssdpcpp/lssdpsearchtarget.h>
+#include <lssdpcpp/lssdpmessage.h>
+#include <lssdpcpp/lssdpnetwork.h>
+#include <lssdpcpp/lssdpratelimit.h>
 #include <url/url.hpp>
 #include <string.h>
 #include <string>
 #include <iostream>
 #include <map>
+#include <unordered_map>
+#include <limits>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
 
 #ifdef WIN32
 #include <WinSock2.h>
@@ -56,21 +66,31 @@ std::string getErrorAsString()
     std::string error_string = std::string(msgbuf) + " (" + std::to_string(err) + ")";
     return std::move(error_string);
 }
+bool isWouldBlock()
+{
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+bool isAddressInUse()
+{
+    return WSAGetLastError() == WSAEADDRINUSE;
+}
+inline int strncasecmp(const char* left, const char* right, size_t size)
+{
+    return _strnicmp(left, right, size);
+}
 }
 
 #else //WIN32
 #include <unistd.h>     // close
 #include <sys/time.h>   // gettimeofday
 #include <sys/ioctl.h>  // ioctl, FIONBIO
-#include <net/if.h>     // struct ifconf, struct ifreq
+#include <net/if.h>     // IFNAMSIZ, if_nametoindex, if_indextoname
+#include <ifaddrs.h>    // getifaddrs, freeifaddrs
 #include <sys/socket.h> // struct sockaddr, AF_INET, SOL_SOCKET, socklen_t, setsockopt, socket, bind, sendto, recvfrom
 #include <netinet/in.h> // struct sockaddr_in, struct ip_mreq, INADDR_ANY, IPPROTO_IP, also include <sys/socket.h>
 #include <arpa/inet.h>  // inet_aton, inet_ntop, inet_addr, also include <netinet/in.h>
 
 #define SOCKET_TYPE int
-#ifndef _SIZEOF_ADDR_IFREQ
-#define _SIZEOF_ADDR_IFREQ sizeof
-#endif
 
 namespace {
 std::string getErrorAsString()
@@ -78,6 +98,14 @@ std::string getErrorAsString()
     std::string error_string = std::string(strerror(errno)) + " (" + std::to_string(errno) + ")";
     return std::move(error_string);
 }
+bool isWouldBlock()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+bool isAddressInUse()
+{
+    return errno == EADDRINUSE;
+}
 }
 
 #endif //WIN32
@@ -86,30 +114,93 @@ std::string getErrorAsString()
 
 #ifdef __linux__
 #include <sys/utsname.h>
+// batched sends with sendmmsg and IP_PKTINFO
+#define LSSDP_USE_SENDMMSG
+// batched receive with recvmmsg, IP_PKTINFO tells the interface of each datagram
+#define LSSDP_USE_RECVMMSG
+// wait for readable sockets with epoll
+#include <sys/epoll.h>
+#define LSSDP_USE_EPOLL
+// ServiceFinder receive workers with SO_REUSEPORT, socket filters and SO_TIMESTAMPNS
+#include <sys/eventfd.h>
+#include <linux/filter.h>
+#include <poll.h>
+#include <pthread.h>    // pthread_setaffinity_np
+#include <sched.h>      // cpu_set_t, CPU_ZERO, CPU_SET
+#include <thread>
+#include <mutex>
+#define LSSDP_USE_RECEIVE_WORKERS
+// interface changes from rtnetlink address events
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#define LSSDP_USE_NETLINK
+// multishot receive and sends as SQEs with io_uring (cmake option lssdpcpp_enable_io_uring)
+#ifdef LSSDP_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>     // mmap, munmap
+#include <sys/syscall.h>  // __NR_io_uring_setup, __NR_io_uring_enter, __NR_io_uring_register
+#include <stdlib.h>       // getenv
+#endif
 #endif
 
 namespace
 {
-    // SSDP Header
-    constexpr static const char* const LSSDP_HEADER_MSEARCH = "M-SEARCH * HTTP/1.1\r\n";
-    constexpr static const char* const LSSDP_HEADER_NOTIFY = "NOTIFY * HTTP/1.1\r\n";
-    constexpr static const char* const LSSDP_HEADER_RESPONSE = "HTTP/1.1 200 OK\r\n";
-    // SSDP Method
-    constexpr static const char* const LSSDP_MSEARCH = "M-SEARCH";
-    constexpr static const char* const LSSDP_NOTIFY = "NOTIFY";
-    constexpr static const char* const LSSDP_RESPONSE = "OK";
-    
+    // SSDP Header (LSSDP_HEADER_MSEARCH, LSSDP_HEADER_NOTIFY, LSSDP_HEADER_RESPONSE) see lssdppacket.h
+
     constexpr static const char* const LSSDP_NOTIFY_NTS_ALIVE = "ssdp:alive";
     constexpr static const char* const LSSDP_NOTIFY_NTS_BYEBYE = "ssdp:byebye";
 
-    constexpr static const char* const LSSDP_SEARCH_TARGET_ALL = "ssdp:all";
-
     constexpr static const char* const LSSDP_ADDR_LOCALHOST = "127.0.0.1";
     constexpr static const char* const LSSDP_ADDR_LOCALHOST_MASK = "255.0.0.0";
 
     constexpr size_t LSSDP_MAX_BUFFER_LEN = 2048;
-    constexpr size_t LSSDP_FIELD_LEN = 128;
-    constexpr size_t LSSDP_LOCATION_LEN = 256;
+    //datagrams drained from the socket on each wakeup
+    constexpr size_t LSSDP_DEFAULT_RECEIVE_BATCH = 32;
+
+    //socket, bind, setsockopt IP_MULTICAST_LOOP, sendto and close for a socket per datagram
+    constexpr uint64_t LSSDP_SYSCALLS_PER_ONE_SHOT_SEND = 5;
+    //max datagrams of one sendmmsg call (UIO_MAXIOV)
+    constexpr size_t LSSDP_MAX_SENDMMSG_BATCH = 1024;
+
+#ifdef LSSDP_USE_RECVMMSG
+    //control data of a received datagram: IP_PKTINFO and SCM_TIMESTAMPNS (receive workers)
+    constexpr size_t LSSDP_RECEIVE_CONTROL_LEN = CMSG_SPACE(sizeof(struct in_pktinfo))
+                                                 + CMSG_SPACE(sizeof(struct timespec));
+#else
+    constexpr size_t LSSDP_RECEIVE_CONTROL_LEN = 0;
+#endif
+
+#ifdef LSSDP_USE_IO_URING
+    //submission queue entries of a ring, also the max datagrams of one send submission
+    constexpr unsigned int LSSDP_IO_URING_ENTRIES = 256;
+    //provided receive buffers of a listening socket (must be a power of 2)
+    constexpr unsigned int LSSDP_IO_URING_BUFFERS = 64;
+    constexpr uint16_t LSSDP_IO_URING_BUFFER_GROUP = 0;
+    //receive buffer: recvmsg header, source address, control data and the payload
+    constexpr size_t LSSDP_IO_URING_BUFFER_LEN = sizeof(struct io_uring_recvmsg_out)
+                                                 + sizeof(struct sockaddr_in)
+                                                 + LSSDP_RECEIVE_CONTROL_LEN
+                                                 + LSSDP_MAX_BUFFER_LEN;
+    //user_data of the multishot receive
+    constexpr uint64_t LSSDP_IO_URING_RECEIVE = std::numeric_limits<uint64_t>::max();
+    //set this environment variable to fall back to epoll, recvmmsg and sendmmsg
+    constexpr static const char* const LSSDP_DISABLE_IO_URING = "LSSDP_DISABLE_IO_URING";
+#endif
+
+    //max-age of a cached service if its announcement has no CACHE-CONTROL (UDA default)
+    constexpr std::chrono::seconds LSSDP_DEFAULT_MAX_AGE(1800);
+    //a ssdp:byebye is informed once, its copies from the other interfaces arrive within this time
+    constexpr std::chrono::seconds LSSDP_BYEBYE_HORIZON(5);
+    //timing wheel: 4 levels of 64 slots cover 2^24 ticks
+    constexpr unsigned int LSSDP_TIMING_WHEEL_BITS = 6;
+    constexpr unsigned int LSSDP_TIMING_WHEEL_LEVELS = 4;
+    //upper bound of the random response delay, an MX greater than 5 is treated as 5 (UDA 1.1)
+    constexpr std::chrono::milliseconds LSSDP_DEFAULT_MAX_RESPONSE_DELAY(5000);
+    //responses waiting for their delay, a response beyond is dropped (Statistics::_dropped_responses)
+    constexpr size_t LSSDP_MAX_PENDING_RESPONSES = 8192;
+    //receive workers: the events of a USN are only reordered within the latency of a worker batch,
+    //the receive order of a USN without events for this long is forgotten
+    constexpr std::chrono::seconds LSSDP_RECEIVE_ORDER_HORIZON(10);
 
     //option for receiving from my host
     constexpr bool LSSDP_RECEIVE_PACKETS_FROM_MYSELF = true;
@@ -174,205 +265,6 @@ public:
     }
 };
 
-/*******************************************************************************************************/
-/* Helper Packet Parser */
-/*******************************************************************************************************/
-struct LSSDPPacket 
-{
-    char            _method[LSSDP_FIELD_LEN];      // M-SEARCH, NOTIFY, RESPONSE
-    char            _st[LSSDP_FIELD_LEN];          // Search Target
-    char            _usn[LSSDP_FIELD_LEN];         // Unique Service Name
-    char            _location[LSSDP_LOCATION_LEN]; // Location
-    char            _nts[LSSDP_FIELD_LEN];         // nts 
-
-    /* Additional SSDP Header Fields */
-    char            _sm_id[LSSDP_FIELD_LEN];
-    char            _device_type[LSSDP_FIELD_LEN];
-
-    std::chrono::system_clock::time_point _update_time;
-    
-    uint32_t        _received_from;
-
-    LSSDPPacket() : _update_time(),
-                    _received_from(0)
-    {
-        memset(_method, 0, sizeof(_method));
-        memset(_st, 0, sizeof(_st));
-        memset(_usn, 0, sizeof(_usn));
-        memset(_location, 0, sizeof(_location));
-        memset(_sm_id, 0, sizeof(_sm_id));
-        memset(_device_type, 0, sizeof(_device_type));
-        memset(_nts, 0, sizeof(_nts));
-    }
-
-    ~LSSDPPacket() = default;
-    LSSDPPacket(const LSSDPPacket&) = default;
-    LSSDPPacket& operator=(const LSSDPPacket&) = default;
-    LSSDPPacket(LSSDPPacket&&) = default;
-    LSSDPPacket& operator=(LSSDPPacket&&) = default;
-
-    bool parse(const char * data, size_t data_len)
-    {
-        if (data == NULL)
-        {
-            return false;
-        }
-
-        if (data_len != strlen(data))
-        {
-            return false;
-        }
-
-        // 1. compare SSDP Method Header: M-SEARCH, NOTIFY, RESPONSE
-        size_t i;
-        if ((i = strlen(LSSDP_HEADER_MSEARCH)) < data_len && memcmp(data, LSSDP_HEADER_MSEARCH, i) == 0) {
-            strcpy_s(_method, sizeof(_method), LSSDP_MSEARCH);
-        }
-        else if ((i = strlen(LSSDP_HEADER_NOTIFY)) < data_len && memcmp(data, LSSDP_HEADER_NOTIFY, i) == 0) {
-            strcpy_s(_method, sizeof(_method), LSSDP_NOTIFY);
-        }
-        else if ((i = strlen(LSSDP_HEADER_RESPONSE)) < data_len && memcmp(data, LSSDP_HEADER_RESPONSE, i) == 0) {
-            strcpy_s(_method, sizeof(_method), LSSDP_RESPONSE);
-        }
-        else
-        {
-            return false;
-        }
-
-        // 2. parse each field line
-        size_t start = i;
-        for (i = start; i < data_len; i++)
-        {
-            if (data[i] == '\n' && i - 1 > start && data[i - 1] == '\r')
-            {
-                parse_field_line(data, start, i - 2);
-                start = i + 1;
-            }
-        }
-        return true;
-    }
-
-    private:
-    #ifdef WIN32
-        #define strncasecmp _strnicmp
-    #endif 
-
-    bool parse_field_line(const char * data, size_t start, size_t end) {
-        // 1. find the colon
-        if (data[start] == ':')
-        {
-            return false;
-        }
-
-        int colon = get_colon_index(data, start + 1, end);
-        if (colon == -1)
-        {
-            return false;
-        }
-
-        if (colon == static_cast<int>(end))
-        {
-            // value is empty
-            return true;
-        }
-
-
-        // 2. get field, field_len
-        size_t i = start;
-        size_t j = colon - 1;
-        if (trim_spaces(data, &i, &j) == -1)
-        {
-            return false;
-        }
-        const char * field = &data[i];
-        size_t field_len = j - i + 1;
-
-
-        // 3. get value, value_len
-        i = colon + 1;
-        j = end;
-        if (trim_spaces(data, &i, &j) == -1)
-        {
-            return false;
-        };
-        const char * value = &data[i];
-        size_t value_len = j - i + 1;
-
-
-        // 4. set each field's value to packet
-        if (field_len == strlen("st") && strncasecmp(field, "st", field_len) == 0)
-        {
-            memcpy(_st, value, value_len < LSSDP_FIELD_LEN ? value_len : LSSDP_FIELD_LEN - 1);
-            return true;
-        }
-
-        if (field_len == strlen("nt") && strncasecmp(field, "nt", field_len) == 0)
-        {
-            memcpy(_st, value, value_len < LSSDP_FIELD_LEN ? value_len : LSSDP_FIELD_LEN - 1);
-            return true;
-        }
-
-        if (field_len == strlen("usn") && strncasecmp(field, "usn", field_len) == 0)
-        {
-            memcpy(_usn, value, value_len < LSSDP_FIELD_LEN ? value_len : LSSDP_FIELD_LEN - 1);
-            return true;
-        }
-
-        if (field_len == strlen("location") && strncasecmp(field, "location", field_len) == 0)
-        {
-            memcpy(_location, value, value_len < LSSDP_LOCATION_LEN ? value_len : LSSDP_LOCATION_LEN - 1);
-            return true;
-        }
-
-        if (field_len == strlen("sm_id") && strncasecmp(field, "sm_id", field_len) == 0)
-        {
-            memcpy(_sm_id, value, value_len < LSSDP_FIELD_LEN ? value_len : LSSDP_FIELD_LEN - 1);
-            return true;
-        }
-
-        if (field_len == strlen("dev_type") && strncasecmp(field, "dev_type", field_len) == 0)
-        {
-            memcpy(_device_type, value, value_len < LSSDP_FIELD_LEN ? value_len : LSSDP_FIELD_LEN - 1);
-            return true;
-        }
-        if (field_len == strlen("nts") && strncasecmp(field, "nts", field_len) == 0)
-        {
-            memcpy(_nts, value, value_len < LSSDP_FIELD_LEN ? value_len : LSSDP_FIELD_LEN - 1);
-            return true;
-        }
-
-        // the field is not in the struct packet
-        return false;
-    }
-
-    int get_colon_index(const char * string, size_t start, size_t end) {
-        size_t i;
-        for (i = start; i <= end; i++) {
-            if (string[i] == ':') {
-                return (int)i;
-            }
-        }
-        return -1;
-    }
-
-    int trim_spaces(const char * string, size_t * start, size_t * end) {
-        int i = static_cast<int>(*start);
-        int j = static_cast<int>(*end);
-
-        while (i <= static_cast<int>(*end) && (!isprint(string[i]) || isspace(string[i]))) i++;
-        while (j >= static_cast<int>(*start) && (!isprint(string[j]) || isspace(string[j]))) j--;
-
-        if (i > j) {
-            return -1;
-        }
-
-        *start = i;
-        *end = j;
-        return 0;
-    }
-};
-
-
 /*******************************************************************************************************/
 /* Helper class OS Version */
 /*******************************************************************************************************/
@@ -529,13 +421,242 @@ bool NetworkInterface::operator==(const NetworkInterface& other) const
         && getAddrNetMaskIp4() == other.getAddrNetMaskIp4());
 }
 
+/*****************************************************************************************/
+/**
+ * flat table of the IPv4 addresses of all interfaces, it is reused for each enumeration:
+ * the entries are contiguous and all names live in one buffer, so there is no heap
+ * allocation for an entry once the table has grown
+ */
+class InterfaceTable
+{
+public:
+    struct Entry
+    {
+        uint32_t _name_index;   // offset of the zero terminated name in the name buffer
+        uint32_t _address;
+        uint32_t _netmask;
+    };
+
+    void clear()
+    {
+        _entries.clear();
+        _names.clear();
+    }
+
+    void add(const char* name, uint32_t address, uint32_t netmask)
+    {
+        Entry entry = { static_cast<uint32_t>(_names.size()), address, netmask };
+        _names.insert(_names.end(), name, name + strlen(name) + 1);
+        _entries.push_back(entry);
+    }
+
+    /**
+     * true if @p interfaces holds the same interfaces in the same order
+     */
+    bool matches(const std::vector<NetworkInterface>& interfaces) const
+    {
+        if (interfaces.size() != _entries.size())
+        {
+            return false;
+        }
+        for (size_t index = 0; index < _entries.size(); ++index)
+        {
+            const Entry& entry = _entries[index];
+            if (interfaces[index].getAddrIp4() != entry._address
+                || interfaces[index].getAddrNetMaskIp4() != entry._netmask
+                || interfaces[index].getName() != &_names[entry._name_index])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void fill(std::vector<NetworkInterface>& interfaces) const
+    {
+        interfaces.clear();
+        interfaces.reserve(_entries.size());
+        for (const auto& entry : _entries)
+        {
+            interfaces.emplace_back(NetworkInterface(&_names[entry._name_index],
+                                                     entry._address,
+                                                     entry._netmask));
+        }
+    }
+
+private:
+    std::vector<Entry> _entries;
+    std::vector<char>  _names;
+};
+
+#ifdef LSSDP_USE_NETLINK
+/**
+ * reads the IPv4 address, its netmask and its label (like SIOCGIFCONF reports them)
+ * from a RTM_NEWADDR or RTM_DELADDR message
+ * @retval false no IPv4 address
+ */
+static bool parseAddressMessage(const struct nlmsghdr* header,
+                                uint32_t& address,
+                                uint32_t& netmask,
+                                char (&name)[IFNAMSIZ])
+{
+    const struct ifaddrmsg* message = reinterpret_cast<const struct ifaddrmsg*>(NLMSG_DATA(header));
+    if (message->ifa_family != AF_INET)
+    {
+        return false;
+    }
+    bool has_address = false;
+    memset(name, 0, sizeof(name));
+    int attributes_len = static_cast<int>(IFA_PAYLOAD(header));
+    for (const struct rtattr* attribute = IFA_RTA(message);
+         RTA_OK(attribute, attributes_len);
+         attribute = RTA_NEXT(attribute, attributes_len))
+    {
+        if (attribute->rta_type == IFA_LOCAL
+            || (attribute->rta_type == IFA_ADDRESS && !has_address))
+        {
+            memcpy(&address, RTA_DATA(attribute), sizeof(address));
+            has_address = true;
+        }
+        else if (attribute->rta_type == IFA_LABEL)
+        {
+            strncpy(name, reinterpret_cast<const char*>(RTA_DATA(attribute)), IFNAMSIZ - 1);
+        }
+    }
+    if (!has_address)
+    {
+        return false;
+    }
+    if (name[0] == '\0' && if_indextoname(message->ifa_index, name) == nullptr)
+    {
+        return false;
+    }
+    netmask = (message->ifa_prefixlen == 0)
+        ? 0
+        : htonl(std::numeric_limits<uint32_t>::max() << (32 - message->ifa_prefixlen));
+    return true;
+}
+#endif //LSSDP_USE_NETLINK
+
+#ifndef WIN32
+/**
+ * enumerates the IPv4 addresses of all interfaces into @p table, on Linux with one
+ * RTM_GETADDR dump, otherwise with getifaddrs, there is no limit of the address count
+ */
+static void enumerateInterfaces(InterfaceTable& table)
+{
+    table.clear();
+#ifdef LSSDP_USE_NETLINK
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0)
+    {
+        throw std::runtime_error(std::string("create netlink socket failed, errno = ")
+                                 + getErrorAsString());
+    }
+
+    // 1. request the dump of all IPv4 addresses
+    struct
+    {
+        struct nlmsghdr  _header;
+        struct ifaddrmsg _message;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request._header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+    request._header.nlmsg_type = RTM_GETADDR;
+    request._header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request._header.nlmsg_seq = 1;
+    request._message.ifa_family = AF_INET;
+    if (send(fd, &request, request._header.nlmsg_len, 0) < 0)
+    {
+        std::string throw_msg = std::string("send RTM_GETADDR failed, errno = ")
+            + getErrorAsString();
+        ::close(fd);
+        throw std::runtime_error(throw_msg);
+    }
+
+    // 2. the dump arrives in parts until NLMSG_DONE
+    alignas(struct nlmsghdr) char buffer[16384];
+    bool done = false;
+    while (!done)
+    {
+        ssize_t recv_len = recv(fd, buffer, sizeof(buffer), 0);
+        if (recv_len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::string throw_msg = std::string("recv RTM_GETADDR failed, errno = ")
+                + getErrorAsString();
+            ::close(fd);
+            throw std::runtime_error(throw_msg);
+        }
+        size_t len = static_cast<size_t>(recv_len);
+        for (const struct nlmsghdr* header = reinterpret_cast<const struct nlmsghdr*>(buffer);
+             NLMSG_OK(header, len);
+             header = NLMSG_NEXT(header, len))
+        {
+            if (header->nlmsg_type == NLMSG_DONE)
+            {
+                done = true;
+                break;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR)
+            {
+                const struct nlmsgerr* error = reinterpret_cast<const struct nlmsgerr*>(NLMSG_DATA(header));
+                errno = -error->error;
+                std::string throw_msg = std::string("RTM_GETADDR failed, errno = ")
+                    + getErrorAsString();
+                ::close(fd);
+                throw std::runtime_error(throw_msg);
+            }
+            if (header->nlmsg_type != RTM_NEWADDR)
+            {
+                continue;
+            }
+            uint32_t address = 0;
+            uint32_t netmask = 0;
+            char name[IFNAMSIZ];
+            if (parseAddressMessage(header, address, netmask, name))
+            {
+                table.add(name, address, netmask);
+            }
+        }
+    }
+    ::close(fd);
+#else //LSSDP_USE_NETLINK
+    struct ifaddrs* addresses = nullptr;
+    if (getifaddrs(&addresses) != 0)
+    {
+        throw std::runtime_error(std::string("getifaddrs failed, errno = ")
+                                 + getErrorAsString());
+    }
+    for (struct ifaddrs* current = addresses; current != nullptr; current = current->ifa_next)
+    {
+        if (current->ifa_addr == nullptr || current->ifa_addr->sa_family != AF_INET)
+        {
+            // only support IPv4
+            continue;
+        }
+        uint32_t netmask = (current->ifa_netmask != nullptr)
+            ? reinterpret_cast<struct sockaddr_in*>(current->ifa_netmask)->sin_addr.s_addr
+            : 0;
+        table.add(current->ifa_name,
+                  reinterpret_cast<struct sockaddr_in*>(current->ifa_addr)->sin_addr.s_addr,
+                  netmask);
+    }
+    freeifaddrs(addresses);
+#endif //LSSDP_USE_NETLINK
+}
+#endif //WIN32
+
 bool updateNetworkInterfaces(std::vector<NetworkInterface>& interfaces)
 {
     Initializer::init();
 
+#ifdef WIN32
     std::vector<NetworkInterface> new_interfaces;
 
-#ifdef WIN32
     #define WORKING_BUFFER_SIZE 15000
     #define MAX_TRIES 3
 
@@ -593,77 +714,236 @@ bool updateNetworkInterfaces(std::vector<NetworkInterface>& interfaces)
     }
     FREE(p_adaptersinfo);
 
+    bool is_equal = new_interfaces == interfaces;
+    if (is_equal)
+    {
+        return false;
+    }
+    else
+    {
+        interfaces = new_interfaces;
+        return true;
+    }
 #else //WIN32
-    /* Reference to this article:
-    * http://stackoverflow.com/a/8007079
-    */
-
-    // in lin create UDP socket
-    SOCKET_TYPE fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd < 0) 
+    // the table keeps its memory, only a change allocates the NetworkInterface s
+    static thread_local InterfaceTable table;
+    enumerateInterfaces(table);
+    if (table.matches(interfaces))
     {
-        throw std::runtime_error(std::string("create socket failed, errno = ") 
-                                 + getErrorAsString());
+        return false;
     }
-#define LOCAL_BUFFER_LEN    2048
-    // get ifconfig
-    char buffer[LOCAL_BUFFER_LEN];
-    struct ifconf ifc;
-    ifc.ifc_len = sizeof(buffer);
-    ifc.ifc_buf = (caddr_t)buffer;
+    table.fill(interfaces);
+    return true;
+#endif //WIN32
+}
 
-    if (ioctl(fd, SIOCGIFCONF, &ifc) < 0)
+/*****************************************************************************************/
+/**
+ * the interfaces of @p new_interfaces which are not in @p old_interfaces are @p added,
+ * the interfaces of @p old_interfaces which are not in @p new_interfaces are @p removed
+ */
+static void diffNetworkInterfaces(const std::vector<NetworkInterface>& old_interfaces,
+                                  const std::vector<NetworkInterface>& new_interfaces,
+                                  std::vector<NetworkInterface>& added,
+                                  std::vector<NetworkInterface>& removed)
+{
+    for (const auto& current : new_interfaces)
     {
-        throw std::runtime_error(std::string("ioctl SIOCGIFCONF failed, errno = ") 
-                                 + getErrorAsString());
+        if (std::find(old_interfaces.begin(), old_interfaces.end(), current) == old_interfaces.end())
+        {
+            added.push_back(current);
+        }
     }
-
-    // set to new interfaces 
-    int i;
-    struct ifreq * ifr;
-    for (i = 0; i < ifc.ifc_len; i += _SIZEOF_ADDR_IFREQ(*ifr))
+    for (const auto& current : old_interfaces)
     {
-        ifr = (struct ifreq *)(buffer + i);
-        if (ifr->ifr_addr.sa_family != AF_INET) {
-            // only support IPv4
-            continue;
+        if (std::find(new_interfaces.begin(), new_interfaces.end(), current) == new_interfaces.end())
+        {
+            removed.push_back(current);
         }
+    }
+}
 
-        // get interface ip address
-        struct sockaddr_in * addr = (struct sockaddr_in *) &ifr->ifr_addr;
-
-        // get network mask
-        struct ifreq netmask = {};
-        strcpy(netmask.ifr_name, ifr->ifr_name);
-        if (ioctl(fd, SIOCGIFNETMASK, &netmask) != 0) 
+struct NetworkInterfaceWatcher::Impl
+{
+    Impl()
+    {
+#ifdef LSSDP_USE_NETLINK
+        // subscribe before the first enumeration, so no change gets lost in between
+        _netlink = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+        if (_netlink < 0)
         {
-            continue;
+            LSSDP_LOG_DEBUG_MESSAGE(std::string("netlink not used: ") + getErrorAsString());
+            return;
         }
-        struct sockaddr_in * netmask_addr  = (struct sockaddr_in *) &netmask.ifr_addr;
-
-        new_interfaces.emplace_back(NetworkInterface(ifr->ifr_name,
-                                                     addr->sin_addr.s_addr,
-                                                     netmask_addr->sin_addr.s_addr));
+        struct sockaddr_nl addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = RTMGRP_IPV4_IFADDR;
+        if (bind(_netlink, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            LSSDP_LOG_DEBUG_MESSAGE(std::string("netlink not used: ") + getErrorAsString());
+            ::close(_netlink);
+            _netlink = -1;
+        }
+#endif
     }
-       
-    // close socket
-    if (fd >= 0 && close(fd) != 0)
+    ~Impl()
     {
-       throw std::runtime_error(std::string("closing of socket failed, errno = ") 
-                                 + getErrorAsString());
+#ifdef LSSDP_USE_NETLINK
+        if (_netlink >= 0)
+        {
+            ::close(_netlink);
+        }
+#endif
     }
 
-#endif //WIN32
-    bool is_equal = new_interfaces == interfaces;
-    if (is_equal)
+    bool update(std::vector<NetworkInterface>& interfaces,
+                std::vector<NetworkInterface>& added,
+                std::vector<NetworkInterface>& removed)
     {
-        return false;
+        added.clear();
+        removed.clear();
+#ifdef LSSDP_USE_NETLINK
+        if (_enumerated && _netlink >= 0)
+        {
+            return applyEvents(interfaces, added, removed);
+        }
+#endif
+        return enumerate(interfaces, added, removed);
     }
-    else
+
+private:
+    bool enumerate(std::vector<NetworkInterface>& interfaces,
+                   std::vector<NetworkInterface>& added,
+                   std::vector<NetworkInterface>& removed)
     {
-        interfaces = new_interfaces;
-        return true;
+        _previous = interfaces;
+        if (!updateNetworkInterfaces(interfaces))
+        {
+            _enumerated = true;
+            return false;
+        }
+        _enumerated = true;
+        diffNetworkInterfaces(_previous, interfaces, added, removed);
+        return (!added.empty() || !removed.empty());
+    }
+
+#ifdef LSSDP_USE_NETLINK
+    /**
+     * applies the pending RTM_NEWADDR/RTM_DELADDR events to @p interfaces,
+     * the delta is computed against the interfaces before the first event
+     */
+    bool applyEvents(std::vector<NetworkInterface>& interfaces,
+                     std::vector<NetworkInterface>& added,
+                     std::vector<NetworkInterface>& removed)
+    {
+        bool received_event = false;
+        while (true)
+        {
+            ssize_t recv_len = recv(_netlink, _buffer, sizeof(_buffer), 0);
+            if (recv_len < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (isWouldBlock())
+                {
+                    // drained
+                    break;
+                }
+                if (errno == ENOBUFS)
+                {
+                    // the kernel dropped events, only a new enumeration is reliable
+                    LSSDP_LOG_DEBUG_MESSAGE("netlink overrun, enumerating the interfaces again");
+                    if (received_event)
+                    {
+                        interfaces = _previous;
+                    }
+                    return enumerate(interfaces, added, removed);
+                }
+                throw std::runtime_error(std::string("recv from netlink failed, errno = ")
+                    + getErrorAsString());
+            }
+
+            size_t len = static_cast<size_t>(recv_len);
+            for (struct nlmsghdr* header = reinterpret_cast<struct nlmsghdr*>(_buffer);
+                 NLMSG_OK(header, len);
+                 header = NLMSG_NEXT(header, len))
+            {
+                if (header->nlmsg_type != RTM_NEWADDR && header->nlmsg_type != RTM_DELADDR)
+                {
+                    continue;
+                }
+                // 1. the address and the label, like the enumeration reports them
+                uint32_t address = 0;
+                uint32_t netmask = 0;
+                char name[IFNAMSIZ];
+                if (!parseAddressMessage(header, address, netmask, name))
+                {
+                    continue;
+                }
+
+                // 2. apply it, keep the interfaces before the first event for the delta
+                if (!received_event)
+                {
+                    _previous = interfaces;
+                    received_event = true;
+                }
+                auto found = std::find_if(interfaces.begin(), interfaces.end(),
+                    [address](const NetworkInterface& current)
+                    {
+                        return current.getAddrIp4() == address;
+                    });
+                if (header->nlmsg_type == RTM_NEWADDR)
+                {
+                    NetworkInterface changed(name, address, netmask);
+                    if (found == interfaces.end())
+                    {
+                        interfaces.push_back(std::move(changed));
+                    }
+                    else if (!(*found == changed))
+                    {
+                        *found = std::move(changed);
+                    }
+                }
+                else if (found != interfaces.end())
+                {
+                    interfaces.erase(found);
+                }
+            }
+        }
+        if (!received_event)
+        {
+            return false;
+        }
+        diffNetworkInterfaces(_previous, interfaces, added, removed);
+        return (!added.empty() || !removed.empty());
     }
+
+    int  _netlink = -1;
+    // netlink messages are aligned to 4 bytes
+    alignas(struct nlmsghdr) char _buffer[8192];
+#endif //LSSDP_USE_NETLINK
+
+    bool _enumerated = false;
+    std::vector<NetworkInterface> _previous;
+};
+
+NetworkInterfaceWatcher::NetworkInterfaceWatcher() :
+    _impl(std::make_unique<Impl>())
+{
+}
+
+NetworkInterfaceWatcher::~NetworkInterfaceWatcher()
+{
+}
+
+bool NetworkInterfaceWatcher::update(std::vector<NetworkInterface>& interfaces,
+                                     std::vector<NetworkInterface>& added,
+                                     std::vector<NetworkInterface>& removed)
+{
+    return _impl->update(interfaces, added, removed);
 }
 
 /*****************************************************************************************/
@@ -738,146 +1018,454 @@ std::string ServiceDescription::getProductVersion() const
     return _product_version;
 }
 
+/*****************************************************************************************/
+MessageHeaders::MessageHeaders(const char* data, const Entry* entries, size_t count) :
+    _data(data),
+    _entries(entries),
+    _count(count)
+{
+}
+
+MessageHeaders::MessageHeaders(const MessageHeaders& other)
+{
+    copyFrom(other);
+}
+
+MessageHeaders& MessageHeaders::operator=(const MessageHeaders& other)
+{
+    if (this != &other)
+    {
+        copyFrom(other);
+    }
+    return *this;
+}
+
+MessageHeaders::MessageHeaders(MessageHeaders&& other) :
+    _data(other._data),
+    _entries(other._entries),
+    _count(other._count),
+    _owned(std::move(other._owned))
+{
+    // the owned buffer moved along, the pointers stay valid
+    other._data = nullptr;
+    other._entries = nullptr;
+    other._count = 0;
+}
+
+MessageHeaders& MessageHeaders::operator=(MessageHeaders&& other)
+{
+    if (this != &other)
+    {
+        _data = other._data;
+        _entries = other._entries;
+        _count = other._count;
+        _owned = std::move(other._owned);
+        other._data = nullptr;
+        other._entries = nullptr;
+        other._count = 0;
+    }
+    return *this;
+}
+
+void MessageHeaders::copyFrom(const MessageHeaders& other)
+{
+    _count = other._count;
+    if (other._owned || other._count == 0)
+    {
+        // the owned buffer is never changed, the copies share it
+        _data = other._data;
+        _entries = other._entries;
+        _owned = other._owned;
+        return;
+    }
+    // the header lines end at the end of the last value, the rest of the datagram is not copied
+    size_t data_size = 0;
+    for (size_t index = 0; index < other._count; ++index)
+    {
+        const Entry& entry = other._entries[index];
+        data_size = std::max(data_size, static_cast<size_t>(entry._value_offset) + entry._value_size);
+    }
+    // the index first, new char[] is aligned for it, the header lines behind
+    const size_t entries_size = other._count * sizeof(Entry);
+    char* buffer = new char[entries_size + data_size];
+    _owned.reset(buffer, std::default_delete<char[]>());
+    memcpy(buffer, other._entries, entries_size);
+    memcpy(buffer + entries_size, other._data, data_size);
+    _entries = reinterpret_cast<const Entry*>(buffer);
+    _data = buffer + entries_size;
+}
+
+size_t MessageHeaders::size() const
+{
+    return _count;
+}
+
+std::string MessageHeaders::getName(size_t index) const
+{
+    if (index >= _count)
+    {
+        return std::string();
+    }
+    return std::string(&_data[_entries[index]._name_offset], _entries[index]._name_size);
+}
+
+std::string MessageHeaders::getValue(size_t index) const
+{
+    if (index >= _count)
+    {
+        return std::string();
+    }
+    return std::string(&_data[_entries[index]._value_offset], _entries[index]._value_size);
+}
+
+const MessageHeaders::Entry* MessageHeaders::find(const std::string& name) const
+{
+    // a known header is found by its id, any other by its name
+    const HeaderId id = findHeader(name.data(), name.size());
+    for (size_t index = 0; index < _count; ++index)
+    {
+        const Entry& entry = _entries[index];
+        if (id != header_unknown)
+        {
+            if (entry._id == id)
+            {
+                return &entry;
+            }
+        }
+        else if (entry._id == header_unknown
+                 && entry._name_size == name.size()
+                 && strncasecmp(&_data[entry._name_offset], name.data(), name.size()) == 0)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool MessageHeaders::getHeader(const std::string& name, std::string& value) const
+{
+    const Entry* entry = find(name);
+    if (entry == nullptr)
+    {
+        return false;
+    }
+    value.assign(&_data[entry->_value_offset], entry->_value_size);
+    return true;
+}
+
+std::string MessageHeaders::getHeader(const std::string& name) const
+{
+    std::string value;
+    getHeader(name, value);
+    return value;
+}
+
+bool MessageHeaders::getMaxAge(std::chrono::seconds& max_age) const
+{
+    const Entry* entry = find("cache-control");
+    uint32_t seconds = 0;
+    if (entry == nullptr || !parseMaxAge(&_data[entry->_value_offset], entry->_value_size, seconds))
+    {
+        return false;
+    }
+    max_age = std::chrono::seconds(seconds);
+    return true;
+}
+
+bool MessageHeaders::getMx(std::chrono::seconds& mx) const
+{
+    const Entry* entry = find("mx");
+    uint32_t seconds = 0;
+    if (entry == nullptr || !parseNumber(&_data[entry->_value_offset], entry->_value_size, seconds))
+    {
+        return false;
+    }
+    mx = std::chrono::seconds(seconds);
+    return true;
+}
+
+bool MessageHeaders::getBootId(uint32_t& boot_id) const
+{
+    const Entry* entry = find("bootid.upnp.org");
+    return entry != nullptr && parseNumber(&_data[entry->_value_offset], entry->_value_size, boot_id);
+}
+
+#ifdef LSSDP_USE_IO_URING
 /**********************************************************************************/
-class NonBlockingMulticastSocket
+/* Minimal io_uring on raw syscalls (no liburing): the submission and completion  */
+/* queues are mapped into user space, preparing SQEs and reaping CQEs costs no    */
+/* syscall at all.                                                                */
+/**********************************************************************************/
+class IoUring
 {
 public:
-    NonBlockingMulticastSocket() = default;
-    ~NonBlockingMulticastSocket()
+    IoUring() = default;
+    ~IoUring()
     {
         close();
     }
-    void open(uint32_t multicast_socket_addr, uint16_t multicast_socket_port)
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * the io_uring may be switched off at runtime by setting LSSDP_DISABLE_IO_URING
+     */
+    static bool isEnabled()
     {
-        Initializer::init();
+        const char* disabled = getenv(LSSDP_DISABLE_IO_URING);
+        return (disabled == nullptr || disabled[0] == '\0' || strcmp(disabled, "0") == 0);
+    }
 
+    /**
+     * sets up the rings
+     * @retval false the kernel lacks support, see @p error
+     */
+    bool open(unsigned int entries, std::string& error)
+    {
         close();
-
-        if (multicast_socket_port == 0)
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
         {
-            throw std::runtime_error(std::string("SSDP port ")
-                + std::to_string(multicast_socket_port) + " has not been setup right");
+            error = std::string("io_uring_setup failed, errno = ") + getErrorAsString();
+            return false;
         }
-        _multicast_socket_addr = multicast_socket_addr;
-        _multicast_socket_port = multicast_socket_port;
-
-        // create UDP socket
-        _socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-        if (_socket < 0) 
+        _fd = fd;
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0)
         {
-            std::string throw_msg = std::string("create socket failed, errno = ")
-                + getErrorAsString();
+            error = "io_uring_setup failed, kernel lacks IORING_FEAT_SINGLE_MMAP";
             close();
-            throw std::runtime_error(throw_msg);
+            return false;
         }
 
-#ifdef WIN32
-        u_long mode = 1;
-        if (ioctlsocket(_socket, FIONBIO, &mode) != 0)
-        {
-            std::string throw_msg = std::string("ioctl FIONBIO failed, errno = ")
-                + getErrorAsString();
-            close();
-            throw std::runtime_error(throw_msg);
-        }
-        // set reuse address
-        int opt = 1;
-        if (setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt)) != 0)
+        // 1. one mapping for the submission and the completion ring
+        size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        _ring_size = (sq_size > cq_size) ? sq_size : cq_size;
+        void* ring = mmap(nullptr, _ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          _fd, IORING_OFF_SQ_RING);
+        if (ring == MAP_FAILED)
         {
-            std::string throw_msg = std::string("setsockopt SO_REUSEADDR failed, errno = ")
-                + getErrorAsString();
+            error = std::string("mmap of io_uring failed, errno = ") + getErrorAsString();
             close();
-            throw std::runtime_error(throw_msg);
+            return false;
         }
-#else // WIN32
-        int opt = 1;
-        if (ioctl(_socket, FIONBIO, &opt) != 0)
+        _ring = static_cast<char*>(ring);
+
+        // 2. the submission queue entries
+        _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+        void* sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          _fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
         {
-            std::string throw_msg = std::string("ioctl FIONBIO failed, errno = ")
-                + getErrorAsString();
+            error = std::string("mmap of io_uring SQEs failed, errno = ") + getErrorAsString();
             close();
-            throw std::runtime_error(throw_msg);
+            return false;
         }
-        // set reuse address
-        if (setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) != 0)
+        _sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+        _sq_head = reinterpret_cast<unsigned int*>(_ring + params.sq_off.head);
+        _sq_tail = reinterpret_cast<unsigned int*>(_ring + params.sq_off.tail);
+        _sq_mask = *reinterpret_cast<unsigned int*>(_ring + params.sq_off.ring_mask);
+        _sq_entries = params.sq_entries;
+        _cq_head = reinterpret_cast<unsigned int*>(_ring + params.cq_off.head);
+        _cq_tail = reinterpret_cast<unsigned int*>(_ring + params.cq_off.tail);
+        _cq_mask = *reinterpret_cast<unsigned int*>(_ring + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<struct io_uring_cqe*>(_ring + params.cq_off.cqes);
+
+        // the submission array maps each slot to the SQE of the same index
+        unsigned int* sq_array = reinterpret_cast<unsigned int*>(_ring + params.sq_off.array);
+        for (unsigned int index = 0; index < params.sq_entries; ++index)
         {
-            std::string throw_msg = std::string("setsockopt SO_REUSEADDR failed, errno = ")
-                + getErrorAsString();
-            close();
-            throw std::runtime_error(throw_msg);
+            sq_array[index] = index;
         }
-#endif // WIN32
+        _sq_local_tail = *_sq_tail;
+        return true;
+    }
 
-#ifdef WIN32
-       //found no solution for that in WinSock API 
-#else
-        // set FD_CLOEXEC (http://kaivy2001.pixnet.net/blog/post/32726732)
-        int sock_opt = fcntl(_socket, F_GETFD);
-        if (sock_opt == -1)
+    void close()
+    {
+        if (_sqes != nullptr)
         {
-            std::string throw_msg = std::string("fcntl F_GETFD failed, errno = ")
-                + getErrorAsString();
-            close();
-            throw std::runtime_error(throw_msg);
+            munmap(_sqes, _sqes_size);
+            _sqes = nullptr;
         }
-        else
+        if (_ring != nullptr)
         {
-            // F_SETFD
-            if (fcntl(_socket, F_SETFD, sock_opt | FD_CLOEXEC) == -1)
-            {
-                std::string throw_msg = std::string("fcntl F_SETFD FD_CLOEXEC failed, errno = ")
-                    + getErrorAsString();
-                close();
-                throw std::runtime_error(throw_msg);
-            }
+            munmap(_ring, _ring_size);
+            _ring = nullptr;
         }
-#endif
-        // bind socket
-        struct sockaddr_in addr;
-        memset(&addr, 0, sizeof(addr));
-        addr.sin_family = AF_INET;
-        addr.sin_port = htons(multicast_socket_port);
-        addr.sin_addr.s_addr = htonl(INADDR_ANY);
-        
-        if (bind(_socket, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        if (_fd >= 0)
         {
-            std::string throw_msg = std::string("bind failed to ADDR ANY for multicast, errno = ")
-                + getErrorAsString();
-            close();
-            throw std::runtime_error(throw_msg);
+            ::close(_fd);
+            _fd = -1;
         }
+    }
 
-        struct in_addr multicast_address;
-        memset(&multicast_address, 0, sizeof(multicast_address));
-        multicast_address.s_addr = multicast_socket_addr;
+    bool isOpen() const
+    {
+        return _fd >= 0;
+    }
 
-        // set IP_ADD_MEMBERSHIP
-        struct ip_mreq imr;
-        memset(&imr, 0, sizeof(imr));
-        imr.imr_multiaddr.s_addr = multicast_address.s_addr;
-        imr.imr_interface.s_addr = htonl(INADDR_ANY);
-        
-#ifdef WIN32
-        if (setsockopt(_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&imr, sizeof(imr)) != 0)
-        {
-            std::string throw_msg = std::string("setsockopt IP_ADD_MEMBERSHIP failed, errno = ")
-                + getErrorAsString();
-            close();
-            throw std::runtime_error(throw_msg);
-        }
-#else
-        if (setsockopt(_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &imr, sizeof(imr)) != 0)
+    /**
+     * the ring is readable for epoll or select while completions are pending
+     */
+    int getFd() const
+    {
+        return _fd;
+    }
+
+    /**
+     * the next free and zeroed SQE, nullptr if the submission queue is full
+     */
+    struct io_uring_sqe* getSqe()
+    {
+        unsigned int head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        if (_sq_local_tail - head >= _sq_entries)
         {
-            std::string throw_msg = std::string("setsockopt IP_ADD_MEMBERSHIP failed, errno = ")
-                + getErrorAsString();
-            close();
-            throw std::runtime_error(throw_msg);
+            return nullptr;
         }
-
-#endif
+        struct io_uring_sqe* sqe = &_sqes[_sq_local_tail & _sq_mask];
+        ++_sq_local_tail;
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
     }
 
-    void closeSocket(SOCKET_TYPE* socket_to_close)
+    /**
+     * submits all prepared SQEs and waits for @p wait_for completions with one syscall
+     * @retval the count of submitted SQEs, < 0 on error (see errno)
+     */
+    int submit(unsigned int wait_for)
+    {
+        unsigned int to_submit = _sq_local_tail - *_sq_tail;
+        __atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+        return enter(to_submit, wait_for);
+    }
+
+    /**
+     * waits for @p wait_for completions
+     */
+    int wait(unsigned int wait_for)
+    {
+        return enter(0, wait_for);
+    }
+
+    /**
+     * the oldest completion, nullptr if there is none (no syscall)
+     */
+    struct io_uring_cqe* peekCqe()
+    {
+        unsigned int head = *_cq_head;
+        if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE))
+        {
+            return nullptr;
+        }
+        return &_cqes[head & _cq_mask];
+    }
+
+    /**
+     * hands the completion returned by peekCqe back to the kernel
+     */
+    void seenCqe()
+    {
+        __atomic_store_n(_cq_head, *_cq_head + 1, __ATOMIC_RELEASE);
+    }
+
+    int registerBufferRing(struct io_uring_buf_reg* buffer_ring)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PBUF_RING, buffer_ring, 1));
+    }
+
+private:
+    int enter(unsigned int to_submit, unsigned int wait_for)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, _fd, to_submit, wait_for,
+                                        wait_for > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+    }
+
+    int                   _fd = -1;
+    char*                 _ring = nullptr;
+    size_t                _ring_size = 0;
+    struct io_uring_sqe*  _sqes = nullptr;
+    size_t                _sqes_size = 0;
+
+    unsigned int*         _sq_head = nullptr;
+    unsigned int*         _sq_tail = nullptr;
+    unsigned int          _sq_mask = 0;
+    unsigned int          _sq_entries = 0;
+    unsigned int          _sq_local_tail = 0;
+    unsigned int*         _cq_head = nullptr;
+    unsigned int*         _cq_tail = nullptr;
+    unsigned int          _cq_mask = 0;
+    struct io_uring_cqe*  _cqes = nullptr;
+};
+#endif //LSSDP_USE_IO_URING
+
+/**********************************************************************************/
+/* The parse of the received datagrams: one definition for the library and all    */
+/* its users, the scanner is chosen by the flags the library is compiled with.    */
+/**********************************************************************************/
+bool LSSDPPacket::parse(const char * data, size_t data_len)
+{
+#if defined(LSSDP_USE_AVX2)
+    return parseWith<detail::scan_line_marks_avx2>(data, data_len);
+#elif defined(LSSDP_USE_SSE2)
+    return parseWith<detail::scan_line_marks_sse2>(data, data_len);
+#else
+    return parseWith<detail::scan_line_marks_scalar>(data, data_len);
+#endif
+}
+
+/**********************************************************************************/
+class NonBlockingMulticastSocket
+{
+public:
+    NonBlockingMulticastSocket() = default;
+    ~NonBlockingMulticastSocket()
+    {
+        close();
+    }
+    /**
+     * binds the socket to the SSDP port, the group is joined with updateMemberships
+     */
+    void open(uint32_t multicast_socket_addr, uint16_t multicast_socket_port)
+    {
+        if (multicast_socket_port == 0)
+        {
+            throw std::runtime_error(std::string("SSDP port ")
+                + std::to_string(multicast_socket_port) + " has not been setup right");
+        }
+        openSocket(multicast_socket_addr, multicast_socket_port);
+    }
+
+    /**
+     * opens the socket on an ephemeral port without joining a group,
+     * unicast responses to the datagrams sent from it arrive there.
+     * Multicast sent from it leaves on @p interface_address (IP_MULTICAST_IF), unless it is INADDR_ANY.
+     */
+    void openUnicast(uint32_t interface_address)
+    {
+        openSocket(htonl(INADDR_ANY), 0);
+        if (interface_address == htonl(INADDR_ANY))
+        {
+            return;
+        }
+        struct in_addr interface_in_addr;
+        interface_in_addr.s_addr = interface_address;
+        if (setsockopt(_socket, IPPROTO_IP, IP_MULTICAST_IF,
+                       (const char*)&interface_in_addr, sizeof(interface_in_addr)) != 0)
+        {
+            std::string throw_msg = std::string("setsockopt IP_MULTICAST_IF for ")
+                + inet_ntoa(interface_in_addr)
+                + " failed, errno = "
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+    }
+
+    static void closeSocket(SOCKET_TYPE* socket_to_close)
     {
 #ifdef WIN32
         closesocket(*socket_to_close);
@@ -888,6 +1476,10 @@ public:
 
     void close()
     {
+#ifdef LSSDP_USE_IO_URING
+        // cancels the multishot receive before its socket goes away
+        closeIoUring();
+#endif
 
         // check lssdp->sock
         if (_socket > 0)
@@ -899,488 +1491,3765 @@ public:
         _socket = 0;
         _multicast_socket_addr = 0;
         _multicast_socket_port = 0;
+        _memberships.clear();
     }
 
-    void sendDataTo(const char* data, uint32_t address, uint16_t port)
+    /**
+     * joins the multicast group on the interfaces of the @p added addresses and leaves it on those of the
+     * @p removed ones, the bound socket and its receive queue stay, failures are added to @p errors keyed by
+     * the address. The group is joined once per interface and counts its addresses, it is left with the last
+     * one. If the address the group was joined through goes away it is joined again through a remaining one.
+     * @retval false joining or leaving failed for an interface
+     */
+    bool updateMemberships(const std::vector<NetworkInterface>& added,
+                           const std::vector<NetworkInterface>& removed,
+                           std::map<std::string, std::string>& errors)
     {
-        if (data == nullptr)
-        {
-            throw std::runtime_error("invalid data");
-        }
-
-        size_t data_len = strlen(data);
-        if (data_len == 0)
-        {
-            throw std::runtime_error("invalid data size");
-        }
-        // 1. create UDP socket
-        SOCKET_TYPE fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-        if (fd < 0)
-        {
-            std::string throw_msg = std::string("create socket failed, errno = ")
-                + getErrorAsString();
-            closeSocket(&fd);
-            throw std::runtime_error(throw_msg);
-        }
-
-        // 2. bind socket
-        struct sockaddr_in addr;
-        memset(&addr, 0, sizeof(addr));
-        addr.sin_family = AF_INET;
-        addr.sin_addr.s_addr = address;
-        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        bool error_occured = false;
+        for (const auto& current : removed)
         {
-            std::string throw_msg = std::string("bind to address ")
-                                    + inet_ntoa(addr.sin_addr)
-                                    + std::string(" failed, errno =  ")
-                                    + getErrorAsString();
-            closeSocket(&fd);
-            throw std::runtime_error(throw_msg);
+            auto membership = std::find_if(_memberships.begin(), _memberships.end(),
+                                           [&current](const Membership& candidate)
+                                           {
+                                               return std::find(candidate._addresses.begin(),
+                                                                candidate._addresses.end(),
+                                                                current.getAddrIp4()) != candidate._addresses.end();
+                                           });
+            if (membership == _memberships.end())
+            {
+                continue;
+            }
+            membership->_addresses.erase(std::find(membership->_addresses.begin(),
+                                                   membership->_addresses.end(),
+                                                   current.getAddrIp4()));
+            if (!membership->_addresses.empty())
+            {
+                if (membership->_joined_address == current.getAddrIp4())
+                {
+                    rejoin(*membership);
+                }
+                continue;
+            }
+            bool dropped = setMembership(IP_DROP_MEMBERSHIP, *membership);
+            _memberships.erase(membership);
+            if (!dropped)
+            {
+                error_occured = true;
+                errors[current.getIp4()] = std::string("setsockopt IP_DROP_MEMBERSHIP on ") + current.getIp4()
+                    + " failed, errno = " + getErrorAsString();
+            }
         }
-
-        // 3. enable IP_MULTICAST_LOOP for us, because we want that if the 
-        //    option "send to myself is set"
-        if (LSSDP_SEND_TO_LOCALHOST)
+        for (const auto& current : added)
         {
-            int opt = 1;
-#ifdef WIN32
-            const char* value_to_set = (const char*)&opt;
-#else
-            int* value_to_set = &opt;
-#endif
-
-            if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, value_to_set, sizeof(opt)) != 0)
+            const unsigned int interface_index = getInterfaceIndex(current);
+            auto membership = std::find_if(_memberships.begin(), _memberships.end(),
+                                           [&current, interface_index](const Membership& candidate)
+                                           {
+                                               return (interface_index != 0)
+                                                   ? candidate._interface_index == interface_index
+                                                   : candidate._name == current.getName();
+                                           });
+            if (membership != _memberships.end())
             {
-                std::string throw_msg = std::string("setsockopt IP_MULTICAST_LOOP failed, errno = ")
-                    + getErrorAsString();
-                closeSocket(&fd);
-                throw std::runtime_error(throw_msg);
+                // another address of the same interface has joined already
+                if (std::find(membership->_addresses.begin(), membership->_addresses.end(),
+                              current.getAddrIp4()) == membership->_addresses.end())
+                {
+                    membership->_addresses.push_back(current.getAddrIp4());
+                }
+                continue;
+            }
+            Membership joined;
+            joined._interface_index = interface_index;
+            joined._name = current.getName();
+            joined._joined_address = current.getAddrIp4();
+            joined._addresses.push_back(current.getAddrIp4());
+            // in use: the interface is not known by its index and was joined through another address
+            if (setMembership(IP_ADD_MEMBERSHIP, joined) || isAddressInUse())
+            {
+                _memberships.push_back(std::move(joined));
+            }
+            else
+            {
+                error_occured = true;
+                errors[current.getIp4()] = std::string("setsockopt IP_ADD_MEMBERSHIP on ") + current.getIp4()
+                    + " failed, errno = " + getErrorAsString();
             }
         }
+        return (!error_occured);
+    }
 
-        // 4. set destination address
-        struct sockaddr_in dest_addr;
-        memset(&dest_addr, 0, sizeof(dest_addr));
-        dest_addr.sin_family = AF_INET;
-        dest_addr.sin_port = htons(port);
-        dest_addr.sin_addr.s_addr = _multicast_socket_addr;
-        
-        // 5. send data
-        int send_data_size = sendto(fd, data, (int)data_len, 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-        if (send_data_size < 0)
-        {
-            std::string throw_msg = std::string("sendto ") + inet_ntoa(addr.sin_addr) + ":" + std::to_string(port) 
-                + " for multicast address "+ inet_ntoa(dest_addr.sin_addr) + ":" + std::to_string(port)
-                + " failed, errno = "
-                + getErrorAsString();
-            closeSocket(&fd);
-            throw std::runtime_error(throw_msg);
-        }
-        else
+    /**
+     * the socket is one of @p shards sockets bound with SO_REUSEPORT, it only receives the
+     * multicast datagrams of its source address shard, call it before open
+     */
+    void setShard(uint32_t shard, uint32_t shards)
+    {
+        _shard = shard;
+        _shards = (shards == 0) ? 1 : shards;
+    }
+
+    /**
+     * the socket to wait for, the io_uring if it receives for us
+     */
+    SOCKET_TYPE getPollSocket() const
+    {
+#ifdef LSSDP_USE_IO_URING
+        if (_use_io_uring)
         {
-            LSSDP_LOG_DEBUG_MESSAGE(std::to_string(send_data_size) + " size sent");
+            return _uring.getFd();
         }
-        
-        closeSocket(&fd);
+#endif
+        return _socket;
     }
 
-    std::pair<bool, LSSDPPacket> receivePacket()
+    /**
+     * drains up to @p max_datagrams from the socket without blocking and parses
+     * them in one pass, the valid packets are stored to @p packets.
+     * The packets refer to the receive buffers, they are valid until the next call.
+     */
+    void receivePackets(std::vector<LSSDPPacket>& packets,
+                        size_t max_datagrams,
+                        ReceiveStatistics& statistics)
     {
         // check socket and port
         if (_socket <= 0 || _multicast_socket_port == 0)
         {
             throw std::runtime_error(std::string("invalid state of multicast port"));
         }
-        char buffer[LSSDP_MAX_BUFFER_LEN];
-        memset(buffer, 0, sizeof(buffer));
-        struct sockaddr_in address;
-        memset(&address, 0, sizeof(address));
-        socklen_t address_len = sizeof(struct sockaddr_in);
-
-        ssize_t recv_len = recvfrom(_socket, buffer, sizeof(buffer), 0, (struct sockaddr *)&address, &address_len);
-        if (recv_len < 0)
+        packets.clear();
+#ifdef LSSDP_USE_IO_URING
+        if (_use_io_uring)
         {
-            LSSDP_LOG_DEBUG_MESSAGE("receive lower 0");
-            if (errno)
-            {
-                throw std::runtime_error(std::string("recvfrom ") + inet_ntoa(*(in_addr*)&_multicast_socket_addr)
-                    + " failed, errno = "
-                    + getErrorAsString());
-            }
+            // the packets of the last call are gone, the kernel gets their buffers back
+            recycleIoUringBuffers();
+        }
+#endif
+        if (max_datagrams == 0)
+        {
+            max_datagrams = 1;
         }
-        else if (recv_len == 0)
+        _payloads.resize(max_datagrams);
+        _lengths.resize(max_datagrams);
+        _addresses.resize(max_datagrams);
+        _ancillaries.resize(max_datagrams);
+
+        size_t received = 0;
+#ifdef LSSDP_USE_IO_URING
+        statistics._io_uring = _use_io_uring;
+        if (_use_io_uring)
         {
-            LSSDP_LOG_DEBUG_MESSAGE("receive 0");
-            //socket has been closed
+            received = receiveFromIoUring(max_datagrams);
+            if (!_receive_posted)
+            {
+                // the multishot receive stopped, no completion would wake us to give the
+                // buffers back later: the packets get their own copy and it is posted again
+                copyIoUringPayloads(received);
+                recycleIoUringBuffers();
+            }
         }
         else
         {
-            LSSDP_LOG_DEBUG_MESSAGE(std::string("Packet received: ") + std::string(buffer));
-
-            LSSDPPacket packet;
-            packet._update_time = std::chrono::system_clock::now();
-            packet._received_from = address.sin_addr.s_addr;
+            received = receiveFromSocket(max_datagrams);
+        }
+#else
+        received = receiveFromSocket(max_datagrams);
+#endif
 
-            auto valid = packet.parse(buffer, recv_len);
+        // parse the whole batch before the socket is polled again
+        auto now = std::chrono::system_clock::now();
+        for (size_t index = 0; index < received; ++index)
+        {
+            const char* buffer = _payloads[index];
+            LSSDP_LOG_DEBUG_MESSAGE(std::string("Packet received: ") + std::string(buffer, _lengths[index]));
+
+            // the kernel receive time if SO_TIMESTAMPNS is on, otherwise the time of the batch
+            const Ancillary& ancillary = _ancillaries[index];
+            // parsed in place, the packet with its header index is not copied
+            packets.emplace_back();
+            LSSDPPacket& packet = packets.back();
+            packet._update_time = (ancillary._received == std::chrono::system_clock::time_point()) ? now : ancillary._received;
+            packet._received_from = _addresses[index].sin_addr.s_addr;
+            packet._received_from_port = _addresses[index].sin_port;
+            packet._interface_index = ancillary._interface_index;
+            packet._local_address = ancillary._local_address;
+            if (_lengths[index] > 0 && packet.parse(buffer, _lengths[index]))
+            {
+                if (ancillary._interface_index > 0)
+                {
+                    if (statistics._interface_datagrams.size() <= ancillary._interface_index)
+                    {
+                        statistics._interface_datagrams.resize(ancillary._interface_index + 1, 0);
+                    }
+                    ++statistics._interface_datagrams[ancillary._interface_index];
+                }
+            }
+            else
+            {
+                packets.pop_back();
+                ++statistics._invalid_datagrams;
+            }
+        }
 
-            return { valid, std::move(packet) };
+        statistics._datagrams_received += received;
+        ++statistics._batches;
+        if (statistics._batch_sizes.size() <= received)
+        {
+            statistics._batch_sizes.resize(received + 1, 0);
         }
-        return { false, LSSDPPacket() };
+        ++statistics._batch_sizes[received];
     }
 
     SOCKET_TYPE _socket = 0;
     uint32_t    _multicast_socket_addr = 0;
     uint16_t    _multicast_socket_port = 0;
-};
 
-
-/*****************************************************************************************/
-struct Service::Impl : public ServiceDescription
-{
-    Impl(std::string discover_url,
-        std::chrono::seconds max_age,
-        std::string location_url,
-        std::string unique_service_name,
-        std::string search_target,
-        std::string product_name,
-        std::string product_version,
-        std::string sm_id,
-        std::string device_type) 
-        : ServiceDescription(location_url,
-                             unique_service_name,
-                             search_target,
-                             product_name,
-                             product_version,
-                             sm_id,
-                             device_type)
+private:
+    void openSocket(uint32_t multicast_socket_addr, uint16_t multicast_socket_port)
     {
-        cxxurl::Url url(discover_url);
+        Initializer::init();
 
-        _port = std::stoi(url.port());
+        close();
 
-        //very important !! this must be an IP address ... we check that
-        if (url.ip_version() != 4)
+        _multicast_socket_addr = multicast_socket_addr;
+        _multicast_socket_port = multicast_socket_port;
+
+        // create UDP socket
+        _socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (_socket < 0) 
         {
-            throw std::runtime_error("The given url " + discover_url + " does not contain a IPv4 multicast address for host");
+            std::string throw_msg = std::string("create socket failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
         }
-        _address = inet_addr(url.host().c_str());
-
-        //prepare notify alive message
-        _notify_alive_message = 
-            std::string(LSSDP_HEADER_NOTIFY)
-            + "HOST:" + url.host() + ":" + url.port() + "\r\n"
-            + "CACHE-CONTROL:max-age=" + std::to_string(max_age.count()) + "\r\n"
-            + "LOCATION:" + getLocationURL() +"\r\n"
-            + "SERVER:" + OSVersion::getOsVersion().getName() + "/" + OSVersion::getOsVersion().getVersion()
-                        + " " + getProductName() + "/" + getProductVersion() + "\r\n"
-            + "NT:" + getSearchTarget() + "\r\n"
-            + "NTS:" + LSSDP_NOTIFY_NTS_ALIVE + "\r\n"
-            + "USN:" + getUniqueServiceName() + "\r\n";
-            
-        if (!getSMID().empty())
-        {
-            _notify_alive_message += "SM_ID:" + getSMID() + "\r\n";
-        }
-        if (!getDeviceType().empty())
-        {
-            _notify_alive_message += "DEV_TYPE:" + getDeviceType() + "\r\n";
-        }
-        _notify_alive_message += std::string("\r\n");
-
-        //prepare notify byebye message
-        _notify_byebye_message = 
-            std::string(LSSDP_HEADER_NOTIFY)
-            + "HOST:" + url.host() + ":" + url.port() + "\r\n"
-            + "NT:" + getSearchTarget() + "\r\n"
-            + "NTS:" + LSSDP_NOTIFY_NTS_BYEBYE + "\r\n"
-            + "USN:" + getUniqueServiceName() + "\r\n"
-            + std::string("\r\n");
-        
-        //prepare response message
-        _response_message =
-            std::string(LSSDP_HEADER_RESPONSE)
-            + "CACHE-CONTROL:max-age=" + std::to_string(max_age.count()) + "\r\n"
-            + "DATE:\r\n"
-            + "EXT:\r\n"
-            + "LOCATION:" + getLocationURL() + "\r\n"
-            + "SERVER:" + OSVersion::getOsVersion().getName() + "/" + OSVersion::getOsVersion().getVersion()
-            + " " + getProductName() + "/" + getProductVersion() + "\r\n"
-            + "ST:" + getSearchTarget() + "\r\n"
-            + "USN:" + getUniqueServiceName() + "\r\n";
-        if (!getSMID().empty())
+
+#ifdef WIN32
+        u_long mode = 1;
+        if (ioctlsocket(_socket, FIONBIO, &mode) != 0)
+        {
+            std::string throw_msg = std::string("ioctl FIONBIO failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+        // set reuse address
+        int opt = 1;
+        if (setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt)) != 0)
+        {
+            std::string throw_msg = std::string("setsockopt SO_REUSEADDR failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+#else // WIN32
+        int opt = 1;
+        if (ioctl(_socket, FIONBIO, &opt) != 0)
         {
-            _response_message += "SM_ID: " + getSMID() + "\r\n";
+            std::string throw_msg = std::string("ioctl FIONBIO failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
         }
-        if (!getDeviceType().empty())
+        // set reuse address
+        if (setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) != 0)
         {
-            _response_message += "DEV_TYPE: " + getDeviceType() + "\r\n";
+            std::string throw_msg = std::string("setsockopt SO_REUSEADDR failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
         }
-        _response_message += std::string("\r\n");
+#endif // WIN32
 
-        //open the socket NOW for the NOTIFY Messages 
-        ::lssdp::updateNetworkInterfaces(_network_interfaces);
-        openSocket();
-    }
-    ~Impl()
-    {
-        closeSocket();
+#ifdef WIN32
+       //found no solution for that in WinSock API 
+#else
+        // set FD_CLOEXEC (http://kaivy2001.pixnet.net/blog/post/32726732)
+        int sock_opt = fcntl(_socket, F_GETFD);
+        if (sock_opt == -1)
+        {
+            std::string throw_msg = std::string("fcntl F_GETFD failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+        else
+        {
+            // F_SETFD
+            if (fcntl(_socket, F_SETFD, sock_opt | FD_CLOEXEC) == -1)
+            {
+                std::string throw_msg = std::string("fcntl F_SETFD FD_CLOEXEC failed, errno = ")
+                    + getErrorAsString();
+                close();
+                throw std::runtime_error(throw_msg);
+            }
+        }
+#endif
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+        if (_shards > 1)
+        {
+            openShard();
+        }
+#endif
+        // bind socket
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(multicast_socket_port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        
+        if (bind(_socket, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            std::string throw_msg = std::string("bind failed to ADDR ANY for multicast, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+
+        if (multicast_socket_port == 0)
+        {
+            // the ephemeral port the kernel chose
+            socklen_t addr_len = sizeof(addr);
+            if (getsockname(_socket, (struct sockaddr *)&addr, &addr_len) != 0)
+            {
+                std::string throw_msg = std::string("getsockname failed, errno = ")
+                    + getErrorAsString();
+                close();
+                throw std::runtime_error(throw_msg);
+            }
+            _multicast_socket_port = ntohs(addr.sin_port);
+        }
+#ifndef WIN32
+#ifdef LSSDP_USE_RECVMMSG
+        // each datagram tells its ingress interface and local address
+        if (setsockopt(_socket, IPPROTO_IP, IP_PKTINFO, &opt, sizeof(opt)) != 0)
+        {
+            std::string throw_msg = std::string("setsockopt IP_PKTINFO failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+#endif
+#endif
+#ifdef LSSDP_USE_IO_URING
+        // post the multishot receive, without kernel support we fall back to recvmmsg
+        std::string io_uring_error;
+        _use_io_uring = IoUring::isEnabled() && openIoUring(io_uring_error);
+        if (!_use_io_uring)
+        {
+            LSSDP_LOG_DEBUG_MESSAGE(std::string("io_uring not used: ") + io_uring_error);
+            closeIoUring();
+        }
+#endif
+    }
+
+    /**
+     * the multicast group joined on one interface for all of its addresses
+     */
+    struct Membership
+    {
+        // 0 if the platform does not tell it, the interface is known by its name then
+        unsigned int          _interface_index = 0;
+        std::string           _name;
+        // the address the group was joined through
+        uint32_t              _joined_address = 0;
+        // the addresses of the interface, the group is left with the last one
+        std::vector<uint32_t> _addresses;
+    };
+
+    static unsigned int getInterfaceIndex(const NetworkInterface& network_interface)
+    {
+#ifdef WIN32
+        (void)network_interface;
+        return 0;
+#else
+        // an alias label like eth0:1 is resolved to the index of eth0
+        return if_nametoindex(network_interface.getName().c_str());
+#endif
+    }
+
+    bool setMembership(int option, const Membership& membership)
+    {
+#ifdef __linux__
+        // by the interface index, the membership does not depend on the address it was joined through
+        struct ip_mreqn imr;
+        memset(&imr, 0, sizeof(imr));
+        imr.imr_multiaddr.s_addr = _multicast_socket_addr;
+        imr.imr_address.s_addr = membership._joined_address;
+        imr.imr_ifindex = static_cast<int>(membership._interface_index);
+#else
+        struct ip_mreq imr;
+        memset(&imr, 0, sizeof(imr));
+        imr.imr_multiaddr.s_addr = _multicast_socket_addr;
+        imr.imr_interface.s_addr = membership._joined_address;
+#endif
+        return (setsockopt(_socket, IPPROTO_IP, option, (const char*)&imr, sizeof(imr)) == 0);
+    }
+
+    /**
+     * the address @p membership was joined through went away, it is joined through a remaining one,
+     * the interface may still be joined (in use)
+     */
+    void rejoin(Membership& membership)
+    {
+        membership._joined_address = membership._addresses.front();
+#ifdef __linux__
+        if (membership._interface_index != 0)
+        {
+            // joined by the index, not by the address
+            return;
+        }
+#endif
+        if (!setMembership(IP_ADD_MEMBERSHIP, membership) && !isAddressInUse())
+        {
+            LSSDP_LOG_DEBUG_MESSAGE(std::string("setsockopt IP_ADD_MEMBERSHIP failed, errno = ") + getErrorAsString());
+        }
+    }
+
+    /**
+     * what the kernel tells about a received datagram besides its source address
+     */
+    struct Ancillary
+    {
+        std::chrono::system_clock::time_point _received;
+        unsigned int                          _interface_index = 0;
+        uint32_t                              _local_address = 0;
+    };
+
+    size_t receiveFromSocket(size_t max_datagrams)
+    {
+        // buffers are reused and never zeroed, the parse is driven by the received length
+        _buffers.resize(max_datagrams * LSSDP_MAX_BUFFER_LEN);
+        for (size_t index = 0; index < max_datagrams; ++index)
+        {
+            _payloads[index] = &_buffers[index * LSSDP_MAX_BUFFER_LEN];
+        }
+
+        size_t received = 0;
+#ifdef LSSDP_USE_RECVMMSG
+        _messages.resize(max_datagrams);
+        _iovecs.resize(max_datagrams);
+        _controls.resize(max_datagrams);
+        for (size_t index = 0; index < max_datagrams; ++index)
+        {
+            _iovecs[index].iov_base = _payloads[index];
+            _iovecs[index].iov_len = LSSDP_MAX_BUFFER_LEN;
+            struct msghdr& header = _messages[index].msg_hdr;
+            memset(&header, 0, sizeof(header));
+            header.msg_name = &_addresses[index];
+            header.msg_namelen = sizeof(struct sockaddr_in);
+            header.msg_iov = &_iovecs[index];
+            header.msg_iovlen = 1;
+            header.msg_control = _controls[index]._buffer;
+            header.msg_controllen = sizeof(_controls[index]._buffer);
+        }
+        int ret = recvmmsg(_socket, _messages.data(), static_cast<unsigned int>(max_datagrams), MSG_DONTWAIT, nullptr);
+        if (ret < 0)
+        {
+            LSSDP_LOG_DEBUG_MESSAGE("receive lower 0");
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                throw std::runtime_error(std::string("recvmmsg ") + inet_ntoa(*(in_addr*)&_multicast_socket_addr)
+                    + " failed, errno = "
+                    + getErrorAsString());
+            }
+        }
+        else
+        {
+            received = static_cast<size_t>(ret);
+            for (size_t index = 0; index < received; ++index)
+            {
+                _lengths[index] = (_messages[index].msg_hdr.msg_flags & MSG_TRUNC) ? 0 : _messages[index].msg_len;
+                _ancillaries[index] = readAncillary(_messages[index].msg_hdr);
+            }
+        }
+#else //LSSDP_USE_RECVMMSG
+        while (received < max_datagrams)
+        {
+            socklen_t address_len = sizeof(struct sockaddr_in);
+            ssize_t recv_len = recvfrom(_socket, _payloads[received], LSSDP_MAX_BUFFER_LEN, 0,
+                                        (struct sockaddr *)&_addresses[received], &address_len);
+            if (recv_len < 0)
+            {
+                LSSDP_LOG_DEBUG_MESSAGE("receive lower 0");
+                if (isWouldBlock())
+                {
+                    // drained
+                    break;
+                }
+                throw std::runtime_error(std::string("recvfrom ") + inet_ntoa(*(in_addr*)&_multicast_socket_addr)
+                    + " failed, errno = "
+                    + getErrorAsString());
+            }
+            // recvfrom does not tell a truncation, a full buffer may be one
+            _lengths[received] = (static_cast<size_t>(recv_len) < LSSDP_MAX_BUFFER_LEN) ? static_cast<size_t>(recv_len) : 0;
+            _ancillaries[received] = Ancillary();
+            ++received;
+        }
+#endif //LSSDP_USE_RECVMMSG
+        return received;
+    }
+
+#ifdef LSSDP_USE_RECVMMSG
+    /**
+     * the IP_PKTINFO and SCM_TIMESTAMPNS of a received datagram
+     */
+    static Ancillary readAncillary(struct msghdr& header)
+    {
+        Ancillary ancillary;
+        for (struct cmsghdr* control = CMSG_FIRSTHDR(&header);
+             control != nullptr;
+             control = CMSG_NXTHDR(&header, control))
+        {
+            if (control->cmsg_level == IPPROTO_IP && control->cmsg_type == IP_PKTINFO)
+            {
+                struct in_pktinfo packet_info;
+                memcpy(&packet_info, CMSG_DATA(control), sizeof(packet_info));
+                ancillary._interface_index = static_cast<unsigned int>(packet_info.ipi_ifindex);
+                ancillary._local_address = packet_info.ipi_spec_dst.s_addr;
+            }
+            else if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                struct timespec received;
+                memcpy(&received, CMSG_DATA(control), sizeof(received));
+                ancillary._received = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::seconds(received.tv_sec) + std::chrono::nanoseconds(received.tv_nsec)));
+            }
+        }
+        return ancillary;
+    }
+#endif //LSSDP_USE_RECVMMSG
+
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+    /**
+     * joins the SO_REUSEPORT group, enables the receive timestamps and attaches the
+     * filter of the shard: multicast is delivered to each socket of the group,
+     * the filter keeps the datagrams with (source address % shards) == shard
+     */
+    void openShard()
+    {
+        int opt = 1;
+        if (setsockopt(_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) != 0)
+        {
+            std::string throw_msg = std::string("setsockopt SO_REUSEPORT failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+        if (setsockopt(_socket, SOL_SOCKET, SO_TIMESTAMPNS, &opt, sizeof(opt)) != 0)
+        {
+            std::string throw_msg = std::string("setsockopt SO_TIMESTAMPNS failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+
+        struct sock_filter code[] = {
+            // unicast is accepted by the socket the kernel picked
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_NET_OFF + 16)),
+            BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0xf0000000),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xe0000000, 0, 3),
+            // multicast of our source address shard
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_NET_OFF + 12)),
+            BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, _shards),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, _shard, 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, 0xffffffff),
+            BPF_STMT(BPF_RET | BPF_K, 0),
+        };
+        struct sock_fprog filter;
+        filter.len = static_cast<unsigned short>(sizeof(code) / sizeof(code[0]));
+        filter.filter = code;
+        if (setsockopt(_socket, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) != 0)
+        {
+            std::string throw_msg = std::string("setsockopt SO_ATTACH_FILTER failed, errno = ")
+                + getErrorAsString();
+            close();
+            throw std::runtime_error(throw_msg);
+        }
+    }
+#endif //LSSDP_USE_RECEIVE_WORKERS
+
+    // reused for each batch
+    std::vector<char>               _buffers;
+    std::vector<char*>              _payloads;
+    std::vector<size_t>             _lengths;
+    std::vector<struct sockaddr_in> _addresses;
+    std::vector<Ancillary>          _ancillaries;
+#ifdef LSSDP_USE_RECVMMSG
+    union Control
+    {
+        char           _buffer[LSSDP_RECEIVE_CONTROL_LEN];
+        struct cmsghdr _align;
+    };
+    std::vector<struct mmsghdr>     _messages;
+    std::vector<struct iovec>       _iovecs;
+    std::vector<Control>            _controls;
+#endif
+    // the interfaces the group is joined on
+    std::vector<Membership>         _memberships;
+    uint32_t                        _shard = 0;
+    uint32_t                        _shards = 1;
+
+#ifdef LSSDP_USE_IO_URING
+    bool openIoUring(std::string& error)
+    {
+        if (!_uring.open(LSSDP_IO_URING_ENTRIES, error))
+        {
+            return false;
+        }
+
+        // 1. register the provided buffer ring, the kernel picks a buffer for each datagram
+        _buffer_ring_size = LSSDP_IO_URING_BUFFERS * sizeof(struct io_uring_buf);
+        void* buffer_ring = mmap(nullptr, _buffer_ring_size, PROT_READ | PROT_WRITE,
+                                 MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+        if (buffer_ring == MAP_FAILED)
+        {
+            error = std::string("mmap of io_uring buffer ring failed, errno = ") + getErrorAsString();
+            return false;
+        }
+        // struct io_uring_buf_ring has another layout in C++ (flexible array in a union),
+        // so the ring is used as array of buffers with the tail overlaid on bufs[0].resv
+        _buffer_ring = static_cast<struct io_uring_buf*>(buffer_ring);
+        struct io_uring_buf_reg buffer_ring_reg;
+        memset(&buffer_ring_reg, 0, sizeof(buffer_ring_reg));
+        buffer_ring_reg.ring_addr = reinterpret_cast<uint64_t>(buffer_ring);
+        buffer_ring_reg.ring_entries = LSSDP_IO_URING_BUFFERS;
+        buffer_ring_reg.bgid = LSSDP_IO_URING_BUFFER_GROUP;
+        if (_uring.registerBufferRing(&buffer_ring_reg) != 0)
+        {
+            error = std::string("io_uring_register IORING_REGISTER_PBUF_RING failed, errno = ")
+                + getErrorAsString();
+            return false;
+        }
+        _uring_buffers.resize(LSSDP_IO_URING_BUFFERS * LSSDP_IO_URING_BUFFER_LEN);
+        _buffer_ring_tail = 0;
+        for (unsigned int buffer_id = 0; buffer_id < LSSDP_IO_URING_BUFFERS; ++buffer_id)
+        {
+            provideBuffer(static_cast<uint16_t>(buffer_id));
+        }
+        __atomic_store_n(&_buffer_ring[0].resv, _buffer_ring_tail, __ATOMIC_RELEASE);
+
+        // 2. post the multishot receive, without kernel support it fails immediately
+        if (!postReceive(error))
+        {
+            return false;
+        }
+        struct io_uring_cqe* cqe = _uring.peekCqe();
+        if (cqe != nullptr && cqe->res < 0 && (cqe->flags & IORING_CQE_F_MORE) == 0 && cqe->res != -ENOBUFS)
+        {
+            errno = -cqe->res;
+            error = std::string("io_uring multishot recvmsg failed, errno = ") + getErrorAsString();
+            return false;
+        }
+        return true;
+    }
+
+    void closeIoUring()
+    {
+        _uring.close();
+        if (_buffer_ring != nullptr)
+        {
+            munmap(_buffer_ring, _buffer_ring_size);
+            _buffer_ring = nullptr;
+        }
+        _buffer_ids.clear();
+        _use_io_uring = false;
+        _receive_posted = false;
+    }
+
+    bool postReceive(std::string& error)
+    {
+        // the kernel writes the source address and the control data to each buffer
+        memset(&_uring_message, 0, sizeof(_uring_message));
+        _uring_message.msg_namelen = sizeof(struct sockaddr_in);
+        _uring_message.msg_controllen = LSSDP_RECEIVE_CONTROL_LEN;
+
+        struct io_uring_sqe* sqe = _uring.getSqe();
+        if (sqe == nullptr)
+        {
+            error = "io_uring submission queue is full";
+            return false;
+        }
+        sqe->opcode = IORING_OP_RECVMSG;
+        sqe->fd = _socket;
+        sqe->addr = reinterpret_cast<uint64_t>(&_uring_message);
+        sqe->len = 1;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = LSSDP_IO_URING_BUFFER_GROUP;
+        sqe->user_data = LSSDP_IO_URING_RECEIVE;
+        if (_uring.submit(0) < 0)
+        {
+            error = std::string("io_uring_enter failed, errno = ") + getErrorAsString();
+            return false;
+        }
+        _receive_posted = true;
+        return true;
+    }
+
+    void provideBuffer(uint16_t buffer_id)
+    {
+        // the tail is published by the caller once for all buffers
+        struct io_uring_buf* buffer = &_buffer_ring[_buffer_ring_tail & (LSSDP_IO_URING_BUFFERS - 1)];
+        buffer->addr = reinterpret_cast<uint64_t>(&_uring_buffers[buffer_id * LSSDP_IO_URING_BUFFER_LEN]);
+        buffer->len = static_cast<uint32_t>(LSSDP_IO_URING_BUFFER_LEN);
+        buffer->bid = buffer_id;
+        ++_buffer_ring_tail;
+    }
+
+    /**
+     * reaps the completions of the multishot receive, no syscall is needed for that
+     */
+    size_t receiveFromIoUring(size_t max_datagrams)
+    {
+        _buffer_ids.clear();
+        size_t received = 0;
+        struct io_uring_cqe* cqe = nullptr;
+        while (received < max_datagrams && (cqe = _uring.peekCqe()) != nullptr)
+        {
+            int result = cqe->res;
+            uint32_t flags = cqe->flags;
+            bool own_completion = (cqe->user_data == LSSDP_IO_URING_RECEIVE);
+            _uring.seenCqe();
+            if (!own_completion)
+            {
+                continue;
+            }
+            if ((flags & IORING_CQE_F_MORE) == 0)
+            {
+                // the kernel stopped the multishot receive (i.e. out of buffers)
+                _receive_posted = false;
+            }
+            if (result < 0)
+            {
+                if (result == -ENOBUFS)
+                {
+                    continue;
+                }
+                errno = -result;
+                throw std::runtime_error(std::string("io_uring recvmsg ") + inet_ntoa(*(in_addr*)&_multicast_socket_addr)
+                    + " failed, errno = "
+                    + getErrorAsString());
+            }
+            if ((flags & IORING_CQE_F_BUFFER) == 0)
+            {
+                continue;
+            }
+            uint16_t buffer_id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+            _buffer_ids.push_back(buffer_id);
+
+            // buffer layout: recvmsg header, source address, control data, payload
+            char* buffer = &_uring_buffers[buffer_id * LSSDP_IO_URING_BUFFER_LEN];
+            struct io_uring_recvmsg_out header;
+            memcpy(&header, buffer, sizeof(header));
+            size_t name_offset = sizeof(struct io_uring_recvmsg_out);
+            size_t payload_offset = name_offset + _uring_message.msg_namelen + _uring_message.msg_controllen;
+            memset(&_addresses[received], 0, sizeof(struct sockaddr_in));
+            memcpy(&_addresses[received], buffer + name_offset,
+                   header.namelen < sizeof(struct sockaddr_in) ? header.namelen : sizeof(struct sockaddr_in));
+            _payloads[received] = buffer + payload_offset;
+            struct msghdr control_header;
+            memset(&control_header, 0, sizeof(control_header));
+            control_header.msg_control = buffer + name_offset + _uring_message.msg_namelen;
+            control_header.msg_controllen = header.controllen;
+            _ancillaries[received] = readAncillary(control_header);
+            bool truncated = (header.flags & MSG_TRUNC) != 0
+                || static_cast<size_t>(result) < payload_offset
+                || static_cast<size_t>(result) - payload_offset < header.payloadlen;
+            _lengths[received] = truncated ? 0 : header.payloadlen;
+            ++received;
+        }
+        return received;
+    }
+
+    /**
+     * moves the payloads of the batch out of the io_uring buffers
+     */
+    void copyIoUringPayloads(size_t received)
+    {
+        _buffers.resize(received * LSSDP_MAX_BUFFER_LEN);
+        for (size_t index = 0; index < received; ++index)
+        {
+            char* payload = &_buffers[index * LSSDP_MAX_BUFFER_LEN];
+            memcpy(payload, _payloads[index], std::min(_lengths[index], LSSDP_MAX_BUFFER_LEN));
+            _payloads[index] = payload;
+        }
+    }
+
+    /**
+     * gives the parsed buffers back to the kernel and posts the receive again if it stopped
+     */
+    void recycleIoUringBuffers()
+    {
+        for (auto buffer_id : _buffer_ids)
+        {
+            provideBuffer(buffer_id);
+        }
+        if (!_buffer_ids.empty())
+        {
+            __atomic_store_n(&_buffer_ring[0].resv, _buffer_ring_tail, __ATOMIC_RELEASE);
+        }
+        _buffer_ids.clear();
+        if (!_receive_posted)
+        {
+            std::string error;
+            if (!postReceive(error))
+            {
+                throw std::runtime_error(std::string("io_uring recvmsg ") + inet_ntoa(*(in_addr*)&_multicast_socket_addr)
+                    + " could not be posted: " + error);
+            }
+        }
+    }
+
+    IoUring                         _uring;
+    bool                            _use_io_uring = false;
+    bool                            _receive_posted = false;
+    struct msghdr                   _uring_message;
+    struct io_uring_buf*            _buffer_ring = nullptr;
+    size_t                          _buffer_ring_size = 0;
+    uint16_t                        _buffer_ring_tail = 0;
+    std::vector<char>               _uring_buffers;
+    std::vector<uint16_t>           _buffer_ids;
+#endif //LSSDP_USE_IO_URING
+};
+
+/**********************************************************************************/
+/* Send sockets keyed by the network interface address.                           */
+/* A socket is opened when its interface is discovered and is reused for every    */
+/* datagram sent on that interface until the interface goes away.                 */
+/* With sendmmsg (Linux) this table of sockets is replaced by one socket bound to */
+/* INADDR_ANY which sends for all interfaces: each datagram carries its interface */
+/* as IP_PKTINFO, the table only keeps the interface index of each address, and  */
+/* a whole batch is one syscall.                                                  */
+/* A datagram is a list of segments which are sent as iovecs, without sendmmsg    */
+/* they are gathered into one buffer. Each datagram has its own destination, so   */
+/* multicast and unicast datagrams are flushed together.                          */
+/**********************************************************************************/
+class SendSocketTable
+{
+public:
+    /**
+     * one datagram of a batch, the segments refer to the message and are sent as they are
+     * to _address_to and _port (host byte order)
+     */
+    struct Datagram
+    {
+        StringRef       _segments[LSSDP_MAX_SEGMENTS];
+        size_t          _segment_count = 0;
+        uint32_t        _interface_address = 0;
+        uint32_t        _address_to = 0;
+        uint16_t        _port = 0;
+        SendStatistics* _statistics = nullptr;
+
+        Datagram() = default;
+        Datagram(uint32_t interface_address,
+                 uint32_t address_to,
+                 uint16_t port,
+                 SendStatistics* statistics)
+            : _interface_address(interface_address),
+              _address_to(address_to),
+              _port(port),
+              _statistics(statistics)
+        {
+        }
+
+        size_t size() const
+        {
+            size_t data_len = 0;
+            for (size_t index = 0; index < _segment_count; ++index)
+            {
+                data_len += _segments[index]._size;
+            }
+            return data_len;
+        }
+    };
+
+    SendSocketTable() = default;
+    ~SendSocketTable()
+    {
+        clear();
+    }
+    SendSocketTable(const SendSocketTable&) = delete;
+    SendSocketTable& operator=(const SendSocketTable&) = delete;
+
+    /**
+     * closes the sockets of the @p removed interfaces and opens them for the @p added ones
+     */
+    void update(const std::vector<NetworkInterface>& added,
+                const std::vector<NetworkInterface>& removed)
+    {
+        Initializer::init();
+
+#ifdef LSSDP_USE_SENDMMSG
+        // the batch socket sends for all interfaces, we only need the interface index
+        for (const auto& current_interface : removed)
+        {
+            _interface_indexes.erase(current_interface.getAddrIp4());
+        }
+        for (const auto& current_interface : added)
+        {
+            _interface_indexes[current_interface.getAddrIp4()] = if_nametoindex(current_interface.getName().c_str());
+        }
+        if (!_interface_indexes.empty())
+        {
+            openBatchSocket();
+        }
+#else
+        // 1. close the sockets of the interfaces which went away
+        for (const auto& current_interface : removed)
+        {
+            auto found = _sockets.find(current_interface.getAddrIp4());
+            if (found != _sockets.end())
+            {
+                closeEntry(found->second);
+                _sockets.erase(found);
+            }
+        }
+
+        // 2. open the sockets of the new interfaces
+        for (const auto& current_interface : added)
+        {
+            if (_sockets.find(current_interface.getAddrIp4()) == _sockets.end())
+            {
+                _sockets.emplace(current_interface.getAddrIp4(),
+                                 openSocket(current_interface.getAddrIp4()));
+            }
+        }
+#endif
+    }
+
+    void clear()
+    {
+#ifdef LSSDP_USE_SENDMMSG
+        _interface_indexes.clear();
+#ifdef LSSDP_USE_IO_URING
+        _uring.close();
+        _use_io_uring = false;
+#endif
+        closeEntry(_batch_socket);
+        _batch_socket._error.clear();
+#else
+        for (auto& current : _sockets)
+        {
+            closeEntry(current.second);
+        }
+        _sockets.clear();
+#endif
+    }
+
+    /**
+     * sends all @p datagrams each to its destination, failures are added to @p send_errors
+     * keyed by the interface
+     */
+    bool sendBatch(const Datagram* datagrams,
+                   size_t count,
+                   std::map<std::string, std::string>& send_errors)
+    {
+        bool error_occured = false;
+#ifdef LSSDP_USE_SENDMMSG
+        if (getBatchSocket() <= 0)
+        {
+            for (size_t index = 0; index < count; ++index)
+            {
+                addError(datagrams[index], _batch_socket._error, send_errors);
+            }
+            return (count == 0);
+        }
+
+        // 1. build the message headers, each carries its interface as IP_PKTINFO
+        _messages.resize(count);
+        _iovecs.resize(count * LSSDP_MAX_SEGMENTS);
+        _controls.resize(count);
+        _destinations.resize(count);
+        _batch.resize(count);
+        size_t to_send = 0;
+        for (size_t index = 0; index < count; ++index)
+        {
+            const Datagram& current = datagrams[index];
+            auto interface_index = _interface_indexes.find(current._interface_address);
+            if (current.size() == 0)
+            {
+                error_occured = true;
+                addError(current, "invalid data", send_errors);
+                continue;
+            }
+            if (interface_index == _interface_indexes.end())
+            {
+                error_occured = true;
+                addError(current, "no send socket for interface", send_errors);
+                continue;
+            }
+            // the segments are sent where they are, the kernel gathers them
+            struct iovec* iovecs = &_iovecs[to_send * LSSDP_MAX_SEGMENTS];
+            size_t iovec_count = 0;
+            for (size_t segment = 0; segment < current._segment_count; ++segment)
+            {
+                if (!current._segments[segment].empty())
+                {
+                    iovecs[iovec_count].iov_base = const_cast<char*>(current._segments[segment]._data);
+                    iovecs[iovec_count].iov_len = current._segments[segment]._size;
+                    ++iovec_count;
+                }
+            }
+
+            struct sockaddr_in& dest_addr = _destinations[to_send];
+            setDestination(current, dest_addr);
+
+            struct msghdr& header = _messages[to_send].msg_hdr;
+            memset(&header, 0, sizeof(header));
+            header.msg_name = &dest_addr;
+            header.msg_namelen = sizeof(dest_addr);
+            header.msg_iov = iovecs;
+            header.msg_iovlen = iovec_count;
+            header.msg_control = _controls[to_send]._buffer;
+            header.msg_controllen = sizeof(_controls[to_send]._buffer);
+
+            struct cmsghdr* control = CMSG_FIRSTHDR(&header);
+            control->cmsg_level = IPPROTO_IP;
+            control->cmsg_type = IP_PKTINFO;
+            control->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
+            struct in_pktinfo* packet_info = reinterpret_cast<struct in_pktinfo*>(CMSG_DATA(control));
+            memset(packet_info, 0, sizeof(struct in_pktinfo));
+            packet_info->ipi_ifindex = static_cast<int>(interface_index->second);
+            packet_info->ipi_spec_dst.s_addr = current._interface_address;
+
+            _batch[to_send] = current;
+            ++to_send;
+        }
+
+        // 2. flush, a failing datagram is reported and skipped
+#ifdef LSSDP_USE_IO_URING
+        if (_use_io_uring)
+        {
+            if (!flushWithIoUring(to_send, send_errors))
+            {
+                error_occured = true;
+            }
+        }
+        else if (!flushWithSendmmsg(0, to_send, send_errors))
+        {
+            error_occured = true;
+        }
+#else
+        if (!flushWithSendmmsg(0, to_send, send_errors))
+        {
+            error_occured = true;
+        }
+#endif
+#else //LSSDP_USE_SENDMMSG
+        for (size_t index = 0; index < count; ++index)
+        {
+            const Datagram& current = datagrams[index];
+            auto entry = _sockets.find(current._interface_address);
+            if (current.size() == 0)
+            {
+                error_occured = true;
+                addError(current, "invalid data", send_errors);
+                continue;
+            }
+            if (entry == _sockets.end())
+            {
+                error_occured = true;
+                addError(current, "no send socket for interface", send_errors);
+                continue;
+            }
+
+            // the source socket of the interface has its IP_MULTICAST_IF set already,
+            // a unicast datagram may leave from the source of all interfaces
+            auto source = _sources.find(current._interface_address);
+            if (source == _sources.end() && !IN_MULTICAST(ntohl(current._address_to)))
+            {
+                source = _sources.find(htonl(INADDR_ANY));
+            }
+            SOCKET_TYPE send_socket = (source != _sources.end()) ? source->second : entry->second._socket;
+            if (source == _sources.end() && !entry->second._error.empty())
+            {
+                error_occured = true;
+                addError(current, entry->second._error, send_errors);
+                continue;
+            }
+
+            // gathers the segments into one buffer, it keeps its capacity
+            const char* data = current._segments[0]._data;
+            size_t data_len = current._segments[0]._size;
+            if (current._segment_count > 1)
+            {
+                _gather.clear();
+                for (size_t segment = 0; segment < current._segment_count; ++segment)
+                {
+                    _gather.append(current._segments[segment]._data, current._segments[segment]._size);
+                }
+                data = _gather.data();
+                data_len = _gather.size();
+            }
+
+            ++current._statistics->_syscalls;
+            current._statistics->_syscalls_saved += LSSDP_SYSCALLS_PER_ONE_SHOT_SEND - 1;
+            struct sockaddr_in dest_addr;
+            setDestination(current, dest_addr);
+            int send_data_size = sendto(send_socket, data, (int)data_len, 0,
+                                        (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+            if (send_data_size < 0)
+            {
+                error_occured = true;
+                addError(current, sendErrorMessage(current), send_errors);
+            }
+            else
+            {
+                ++current._statistics->_datagrams_sent;
+                LSSDP_LOG_DEBUG_MESSAGE(std::to_string(send_data_size) + " size sent");
+            }
+        }
+#endif //LSSDP_USE_SENDMMSG
+        return (!error_occured);
+    }
+
+    /**
+     * the datagrams of the interface @p interface_address leave from @p socket instead of the
+     * send socket, so the replies arrive at its owner, 0 sends from the send socket again.
+     * With sendmmsg one source sends for all interfaces, it is set for INADDR_ANY. Without,
+     * the source of INADDR_ANY sends the unicast datagrams of an interface without its own source.
+     */
+    void setSource(uint32_t interface_address, SOCKET_TYPE socket)
+    {
+#ifdef LSSDP_USE_SENDMMSG
+        (void)interface_address;
+        _source = socket;
+#else
+        if (socket > 0)
+        {
+            _sources[interface_address] = socket;
+        }
+        else
+        {
+            _sources.erase(interface_address);
+        }
+#endif
+    }
+
+    void fillStatistics(Statistics& statistics) const
+    {
+        statistics._send_sockets_opened = _sockets_opened;
+        statistics._send_sockets_closed = _sockets_closed;
+        statistics._send_socket_syscalls = _syscalls;
+#ifdef LSSDP_USE_IO_URING
+        statistics._send_io_uring = _use_io_uring;
+#endif
+    }
+
+private:
+    struct Entry
+    {
+        SOCKET_TYPE  _socket = 0;
+        std::string  _error;
+    };
+
+    static std::string addressToString(uint32_t address)
+    {
+        struct in_addr in_address;
+        in_address.s_addr = address;
+        return inet_ntoa(in_address);
+    }
+
+    static void addError(const Datagram& datagram,
+                         const std::string& error,
+                         std::map<std::string, std::string>& send_errors)
+    {
+        ++datagram._statistics->_send_failures;
+        send_errors[addressToString(datagram._interface_address)] = error;
+    }
+
+    static void setDestination(const Datagram& datagram, struct sockaddr_in& dest_addr)
+    {
+        memset(&dest_addr, 0, sizeof(dest_addr));
+        dest_addr.sin_family = AF_INET;
+        dest_addr.sin_port = htons(datagram._port);
+        dest_addr.sin_addr.s_addr = datagram._address_to;
+    }
+
+    static std::string sendErrorMessage(const Datagram& datagram)
+    {
+        return std::string("sendto ") + addressToString(datagram._interface_address)
+            + " for address " + addressToString(datagram._address_to) + ":" + std::to_string(datagram._port)
+            + " failed, errno = "
+            + getErrorAsString();
+    }
+
+#ifdef LSSDP_USE_SENDMMSG
+    SOCKET_TYPE getBatchSocket() const
+    {
+        return (_source > 0) ? _source : _batch_socket._socket;
+    }
+
+    /**
+     * sends the prepared messages [@p first, @p to_send), one sendmmsg for up to LSSDP_MAX_SENDMMSG_BATCH
+     */
+    bool flushWithSendmmsg(size_t first,
+                           size_t to_send,
+                           std::map<std::string, std::string>& send_errors)
+    {
+        bool error_occured = false;
+        size_t sent = first;
+        while (sent < to_send)
+        {
+            unsigned int chunk = static_cast<unsigned int>(
+                (to_send - sent) < LSSDP_MAX_SENDMMSG_BATCH ? (to_send - sent) : LSSDP_MAX_SENDMMSG_BATCH);
+            SendStatistics& first_statistics = *_batch[sent]._statistics;
+            ++first_statistics._syscalls;
+            int ret = sendmmsg(getBatchSocket(), &_messages[sent], chunk, 0);
+            if (ret < 0)
+            {
+                error_occured = true;
+                addError(_batch[sent], sendErrorMessage(_batch[sent]), send_errors);
+                ++sent;
+                continue;
+            }
+            // the first datagram pays the sendmmsg syscall, all others are for free
+            first_statistics._syscalls_saved += LSSDP_SYSCALLS_PER_ONE_SHOT_SEND - 1;
+            ++first_statistics._datagrams_sent;
+            for (size_t index = sent + 1; index < sent + static_cast<size_t>(ret); ++index)
+            {
+                _batch[index]._statistics->_syscalls_saved += LSSDP_SYSCALLS_PER_ONE_SHOT_SEND;
+                ++_batch[index]._statistics->_datagrams_sent;
+            }
+            LSSDP_LOG_DEBUG_MESSAGE(std::to_string(ret) + " datagrams sent");
+            sent += static_cast<size_t>(ret);
+        }
+        return (!error_occured);
+    }
+#endif //LSSDP_USE_SENDMMSG
+
+#ifdef LSSDP_USE_IO_URING
+    /**
+     * sends the prepared messages as SENDMSG SQEs, each submission and its completions
+     * are one syscall, if the io_uring fails we fall back to sendmmsg
+     */
+    bool flushWithIoUring(size_t to_send,
+                          std::map<std::string, std::string>& send_errors)
+    {
+        bool error_occured = false;
+        size_t sent = 0;
+        while (sent < to_send)
+        {
+            // 1. one SQE for each datagram, the user_data is its index in the batch
+            unsigned int chunk = 0;
+            struct io_uring_sqe* sqe = nullptr;
+            while (sent + chunk < to_send && (sqe = _uring.getSqe()) != nullptr)
+            {
+                sqe->opcode = IORING_OP_SENDMSG;
+                sqe->fd = getBatchSocket();
+                sqe->addr = reinterpret_cast<uint64_t>(&_messages[sent + chunk].msg_hdr);
+                sqe->len = 1;
+                sqe->user_data = sent + chunk;
+                ++chunk;
+            }
+
+            // 2. submit and wait for all completions
+            SendStatistics& first_statistics = *_batch[sent]._statistics;
+            ++first_statistics._syscalls;
+            int ret = _uring.submit(chunk);
+            if (ret < 0 && errno != EINTR)
+            {
+                LSSDP_LOG_DEBUG_MESSAGE(std::string("io_uring_enter failed, falling back to sendmmsg: ") + getErrorAsString());
+                _uring.close();
+                _use_io_uring = false;
+                --first_statistics._syscalls;
+                return flushWithSendmmsg(sent, to_send, send_errors) && !error_occured;
+            }
+
+            // 3. reap, a failing datagram is reported and skipped
+            unsigned int completed = 0;
+            while (completed < chunk)
+            {
+                struct io_uring_cqe* cqe = _uring.peekCqe();
+                if (cqe == nullptr)
+                {
+                    ++first_statistics._syscalls;
+                    if (_uring.wait(chunk - completed) < 0 && errno != EINTR)
+                    {
+                        // closing the ring drops the SQEs still in flight, they count as failed
+                        std::string error = std::string("io_uring_enter failed, errno = ") + getErrorAsString();
+                        _uring.close();
+                        _use_io_uring = false;
+                        for (size_t index = sent; index < sent + chunk; ++index)
+                        {
+                            if (!_completed[index - sent])
+                            {
+                                error_occured = true;
+                                addError(_batch[index], error, send_errors);
+                            }
+                        }
+                        return flushWithSendmmsg(sent + chunk, to_send, send_errors) && !error_occured;
+                    }
+                    continue;
+                }
+                size_t index = static_cast<size_t>(cqe->user_data);
+                int result = cqe->res;
+                _uring.seenCqe();
+                if (index < sent || index >= sent + chunk)
+                {
+                    continue;
+                }
+                ++completed;
+                _completed[index - sent] = true;
+                if (result < 0)
+                {
+                    errno = -result;
+                    error_occured = true;
+                    addError(_batch[index], sendErrorMessage(_batch[index]), send_errors);
+                    continue;
+                }
+                // the first datagram pays the io_uring_enter syscall, all others are for free
+                _batch[index]._statistics->_syscalls_saved += (index == sent)
+                    ? LSSDP_SYSCALLS_PER_ONE_SHOT_SEND - 1
+                    : LSSDP_SYSCALLS_PER_ONE_SHOT_SEND;
+                ++_batch[index]._statistics->_datagrams_sent;
+            }
+            std::fill(_completed.begin(), _completed.end(), false);
+            LSSDP_LOG_DEBUG_MESSAGE(std::to_string(chunk) + " datagrams submitted");
+            sent += chunk;
+        }
+        return (!error_occured);
+    }
+#endif //LSSDP_USE_IO_URING
+
+#ifdef LSSDP_USE_SENDMMSG
+    void openBatchSocket()
+    {
+        if (_batch_socket._socket > 0 || !_batch_socket._error.empty())
+        {
+            return;
+        }
+        _batch_socket = openSocket(htonl(INADDR_ANY));
+#ifdef LSSDP_USE_IO_URING
+        // sends are submitted as SQEs, without kernel support we stay with sendmmsg
+        std::string io_uring_error;
+        _use_io_uring = _batch_socket._error.empty()
+            && IoUring::isEnabled()
+            && _uring.open(LSSDP_IO_URING_ENTRIES, io_uring_error);
+        _completed.assign(LSSDP_IO_URING_ENTRIES, false);
+        if (!_use_io_uring)
+        {
+            LSSDP_LOG_DEBUG_MESSAGE(std::string("io_uring not used: ") + io_uring_error);
+            _uring.close();
+        }
+#endif
+    }
+#endif //LSSDP_USE_SENDMMSG
+
+    Entry openSocket(uint32_t interface_address)
+    {
+        Entry entry;
+        struct in_addr interface_in_addr;
+        interface_in_addr.s_addr = interface_address;
+
+        // 1. create UDP socket
+        ++_syscalls;
+        SOCKET_TYPE fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (fd < 0)
+        {
+            entry._error = std::string("create socket failed, errno = ")
+                + getErrorAsString();
+            return entry;
+        }
+
+#ifndef WIN32
+        // 2. set FD_CLOEXEC, the socket lives as long as the interface
+        _syscalls += 2;
+        int sock_opt = fcntl(fd, F_GETFD);
+        if (sock_opt == -1 || fcntl(fd, F_SETFD, sock_opt | FD_CLOEXEC) == -1)
+        {
+            entry._error = std::string("fcntl FD_CLOEXEC failed, errno = ")
+                + getErrorAsString();
+            ++_syscalls;
+            NonBlockingMulticastSocket::closeSocket(&fd);
+            return entry;
+        }
+#endif
+
+        // 3. bind socket to the interface
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = interface_address;
+        ++_syscalls;
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            entry._error = std::string("bind to address ")
+                + inet_ntoa(interface_in_addr)
+                + std::string(" failed, errno =  ")
+                + getErrorAsString();
+            ++_syscalls;
+            NonBlockingMulticastSocket::closeSocket(&fd);
+            return entry;
+        }
+
+        // 4. enable IP_MULTICAST_LOOP for us, because we want that if the
+        //    option "send to myself is set"
+        int opt = 1;
+#ifdef WIN32
+        const char* value_to_set = (const char*)&opt;
+        const char* interface_to_set = (const char*)&interface_in_addr;
+#else
+        int* value_to_set = &opt;
+        struct in_addr* interface_to_set = &interface_in_addr;
+#endif
+        if (LSSDP_SEND_TO_LOCALHOST)
+        {
+            ++_syscalls;
+            if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, value_to_set, sizeof(opt)) != 0)
+            {
+                entry._error = std::string("setsockopt IP_MULTICAST_LOOP failed, errno = ")
+                    + getErrorAsString();
+                ++_syscalls;
+                NonBlockingMulticastSocket::closeSocket(&fd);
+                return entry;
+            }
+        }
+
+        // 5. multicast leaves on this interface (the batch socket selects it per datagram)
+        if (interface_address != htonl(INADDR_ANY))
+        {
+            ++_syscalls;
+            if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, interface_to_set, sizeof(interface_in_addr)) != 0)
+            {
+                entry._error = std::string("setsockopt IP_MULTICAST_IF for ")
+                    + inet_ntoa(interface_in_addr)
+                    + " failed, errno = "
+                    + getErrorAsString();
+                ++_syscalls;
+                NonBlockingMulticastSocket::closeSocket(&fd);
+                return entry;
+            }
+        }
+
+        ++_sockets_opened;
+        entry._socket = fd;
+        return entry;
+    }
+
+    void closeEntry(Entry& entry)
+    {
+        if (entry._error.empty() && entry._socket > 0)
+        {
+            ++_syscalls;
+            ++_sockets_closed;
+            NonBlockingMulticastSocket::closeSocket(&entry._socket);
+        }
+        entry._socket = 0;
+    }
+
+#ifdef LSSDP_USE_SENDMMSG
+    SOCKET_TYPE                      _source = 0;
+    union Control
+    {
+        char           _buffer[CMSG_SPACE(sizeof(struct in_pktinfo))];
+        struct cmsghdr _align;
+    };
+    // the interface index of each interface address, for IP_PKTINFO
+    std::map<uint32_t, unsigned int> _interface_indexes;
+    Entry                            _batch_socket;
+    // reused for each batch
+    std::vector<struct mmsghdr>      _messages;
+    std::vector<struct iovec>        _iovecs;
+    std::vector<Control>             _controls;
+    std::vector<struct sockaddr_in>  _destinations;
+    std::vector<Datagram>            _batch;
+#else
+    std::map<uint32_t, Entry>        _sockets;
+    // the source socket of each interface
+    std::map<uint32_t, SOCKET_TYPE>  _sources;
+    // reused to gather the segments of each datagram
+    std::string                      _gather;
+#endif
+#ifdef LSSDP_USE_IO_URING
+    IoUring                     _uring;
+    bool                        _use_io_uring = false;
+    // completions reaped of the current submission
+    std::vector<bool>           _completed;
+#endif
+
+    uint64_t _sockets_opened = 0;
+    uint64_t _sockets_closed = 0;
+    uint64_t _syscalls = 0;
+};
+
+
+/**********************************************************************************/
+/* Something to wait for: the sockets to watch and what to do if one is readable. */
+/**********************************************************************************/
+class PollSource
+{
+public:
+    virtual ~PollSource() = default;
+    /**
+     * changes each time the sockets are reopened,
+     * the poller registers the sockets again if it changed
+     */
+    virtual uint64_t getSocketsVersion() const = 0;
+    virtual void getSockets(std::vector<SOCKET_TYPE>& sockets) const = 0;
+    /**
+     * @p socket is readable, returns false if an error occured while handling it
+     */
+    virtual bool onReadable(SOCKET_TYPE socket) = 0;
+    /**
+     * the time onTimeout wants to be called at, time_point::max() if there is no timer
+     */
+    virtual std::chrono::steady_clock::time_point getNextTimeout() const
+    {
+        return std::chrono::steady_clock::time_point::max();
+    }
+    /**
+     * the time of getNextTimeout has passed, returns false if an error occured while handling it
+     */
+    virtual bool onTimeout(std::chrono::steady_clock::time_point now)
+    {
+        (void)now;
+        return true;
+    }
+};
+
+/**********************************************************************************/
+/* Waits for the sockets of many PollSources until a deadline (epoll on Linux,    */
+/* select otherwise) and dispatches a readable socket immediately. The wait ends  */
+/* early for the next timeout of a source.                                        */
+/**********************************************************************************/
+class Poller
+{
+public:
+    Poller()
+    {
+#ifdef LSSDP_USE_EPOLL
+        _epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (_epoll < 0)
+        {
+            throw std::runtime_error(std::string("epoll_create1 failed, errno = ")
+                + getErrorAsString());
+        }
+#endif
+    }
+    ~Poller()
+    {
+#ifdef LSSDP_USE_EPOLL
+        if (_epoll >= 0)
+        {
+            ::close(_epoll);
+        }
+#endif
+    }
+    Poller(const Poller&) = delete;
+    Poller& operator=(const Poller&) = delete;
+
+    void add(PollSource* source)
+    {
+        Registration registration;
+        registration._source = source;
+        _registrations.push_back(registration);
+    }
+
+    void remove(PollSource* source)
+    {
+        for (auto current = _registrations.begin(); current != _registrations.end(); ++current)
+        {
+            if (current->_source == source)
+            {
+                unregisterSockets(*current);
+                _registrations.erase(current);
+                return;
+            }
+        }
+    }
+
+    /**
+     * waits until @p deadline and dispatches each readable socket and each passed timeout,
+     * with a deadline in the past the sockets are checked once without waiting
+     * @retval false waiting failed (see @p error) or a source failed handling its socket
+     */
+    bool waitUntil(std::chrono::steady_clock::time_point deadline, std::string& error)
+    {
+        bool return_value = true;
+        do
+        {
+            registerSockets();
+            int timeout_ms = getTimeoutMs(getWakeup(deadline));
+#ifdef LSSDP_USE_EPOLL
+            _events.resize(_sockets.empty() ? 1 : _sockets.size());
+            int ret = epoll_wait(_epoll, _events.data(), static_cast<int>(_events.size()), timeout_ms);
+            if (ret < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                error = std::string("epoll_wait failed, errno = ") + getErrorAsString();
+                return false;
+            }
+            for (int index = 0; index < ret; ++index)
+            {
+                SOCKET_TYPE ready_socket = static_cast<SOCKET_TYPE>(_events[index].data.fd);
+                auto source = _sockets.find(ready_socket);
+                if (source != _sockets.end() && !source->second->onReadable(ready_socket))
+                {
+                    return_value = false;
+                }
+            }
+#else //LSSDP_USE_EPOLL
+            fd_set fs;
+            FD_ZERO(&fs);
+            int used_socket_in_select = 0;
+            for (const auto& current : _sockets)
+            {
+                FD_SET(current.first, &fs);
+#ifndef WIN32
+                if (static_cast<int>(current.first) + 1 > used_socket_in_select)
+                {
+                    used_socket_in_select = static_cast<int>(current.first) + 1;
+                }
+#endif
+            }
+            struct timeval tv;
+            tv.tv_sec = timeout_ms / 1000;
+            tv.tv_usec = (timeout_ms % 1000) * 1000;
+            int ret = select(used_socket_in_select, &fs, NULL, NULL, &tv);
+            if (ret < 0)
+            {
+                error = std::string("select failed, errno = ") + getErrorAsString();
+                return false;
+            }
+            _ready.clear();
+            for (const auto& current : _sockets)
+            {
+                if (FD_ISSET(current.first, &fs))
+                {
+                    _ready.push_back(current.first);
+                }
+            }
+            for (auto ready_socket : _ready)
+            {
+                auto source = _sockets.find(ready_socket);
+                if (source != _sockets.end() && !source->second->onReadable(ready_socket))
+                {
+                    return_value = false;
+                }
+            }
+#endif //LSSDP_USE_EPOLL
+            if (!dispatchTimeouts())
+            {
+                return_value = false;
+            }
+        } while (std::chrono::steady_clock::now() < deadline);
+        return return_value;
+    }
+
+private:
+    struct Registration
+    {
+        PollSource*              _source = nullptr;
+        uint64_t                 _version = 0;
+        bool                     _registered = false;
+        std::vector<SOCKET_TYPE> _sockets;
+    };
+
+    std::chrono::steady_clock::time_point getWakeup(std::chrono::steady_clock::time_point deadline) const
+    {
+        auto wakeup = deadline;
+        for (const auto& current : _registrations)
+        {
+            auto next_timeout = current._source->getNextTimeout();
+            if (next_timeout < wakeup)
+            {
+                wakeup = next_timeout;
+            }
+        }
+        return wakeup;
+    }
+
+    bool dispatchTimeouts()
+    {
+        bool return_value = true;
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& current : _registrations)
+        {
+            if (current._source->getNextTimeout() <= now && !current._source->onTimeout(now))
+            {
+                return_value = false;
+            }
+        }
+        return return_value;
+    }
+
+    static int getTimeoutMs(std::chrono::steady_clock::time_point deadline)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (deadline <= now)
+        {
+            return 0;
+        }
+        // round up, we never want to wake before the deadline
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+        auto remaining_ms = (remaining + 999) / 1000;
+        if (remaining_ms > std::numeric_limits<int>::max())
+        {
+            return std::numeric_limits<int>::max();
+        }
+        return static_cast<int>(remaining_ms);
+    }
+
+    void registerSockets()
+    {
+        for (auto& current : _registrations)
+        {
+            if (current._registered && current._version == current._source->getSocketsVersion())
+            {
+                continue;
+            }
+            unregisterSockets(current);
+            current._version = current._source->getSocketsVersion();
+            current._source->getSockets(current._sockets);
+            for (auto current_socket : current._sockets)
+            {
+#ifdef LSSDP_USE_EPOLL
+                struct epoll_event event;
+                memset(&event, 0, sizeof(event));
+                event.events = EPOLLIN;
+                event.data.fd = current_socket;
+                if (epoll_ctl(_epoll, EPOLL_CTL_ADD, current_socket, &event) != 0 && errno == EEXIST)
+                {
+                    epoll_ctl(_epoll, EPOLL_CTL_MOD, current_socket, &event);
+                }
+#endif
+                _sockets[current_socket] = current._source;
+            }
+            current._registered = true;
+        }
+    }
+
+    void unregisterSockets(Registration& registration)
+    {
+        for (auto current_socket : registration._sockets)
+        {
+#ifdef LSSDP_USE_EPOLL
+            // the socket may already be closed, then it has left the epoll set by itself
+            epoll_ctl(_epoll, EPOLL_CTL_DEL, current_socket, nullptr);
+#endif
+            auto found = _sockets.find(current_socket);
+            if (found != _sockets.end() && found->second == registration._source)
+            {
+                _sockets.erase(found);
+            }
+        }
+        registration._sockets.clear();
+        registration._registered = false;
+    }
+
+    std::vector<Registration>          _registrations;
+    std::map<SOCKET_TYPE, PollSource*> _sockets;
+#ifdef LSSDP_USE_EPOLL
+    int                                _epoll = -1;
+    std::vector<struct epoll_event>    _events;
+#else
+    std::vector<SOCKET_TYPE>           _ready;
+#endif
+};
+
+/**********************************************************************************/
+/* Hierarchical timing wheel: LSSDP_TIMING_WHEEL_LEVELS levels of 64 slots, each  */
+/* slot is an intrusive list of timer indices. Scheduling and cancelling cost     */
+/* O(1). A bitmap per level marks the used slots, advance jumps from one used     */
+/* slot (or the cascade of one) to the next, an idle gap costs O(levels) instead  */
+/* of a step per elapsed tick.                                                    */
+/**********************************************************************************/
+class TimingWheel
+{
+    static_assert(LSSDP_TIMING_WHEEL_BITS == 6, "the used slots of a level are a 64 bit mask");
+
+public:
+    TimingWheel()
+    {
+        clear();
+    }
+
+    /**
+     * (re)schedules @p timer to expire at @p expiry_tick,
+     * the timers are dense indices chosen by the caller
+     */
+    void schedule(uint32_t timer, uint64_t expiry_tick)
+    {
+        if (timer >= _timers.size())
+        {
+            _timers.resize(timer + 1);
+        }
+        cancel(timer);
+        _timers[timer]._expiry_tick = expiry_tick;
+        // the slot of the current tick is done, an expiry in the past is due with the next one
+        insert(timer, _current_tick + 1);
+        ++_size;
+    }
+
+    void cancel(uint32_t timer)
+    {
+        if (timer < _timers.size() && _timers[timer]._slot != NO_SLOT)
+        {
+            unlink(timer);
+            --_size;
+        }
+    }
+
+    void clear()
+    {
+        for (auto& level : _slots)
+        {
+            for (auto& slot : level)
+            {
+                slot = NO_TIMER;
+            }
+        }
+        for (auto& used : _used)
+        {
+            used = 0;
+        }
+        _timers.clear();
+        _size = 0;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    /**
+     * the first tick advance has work at: the first used slot of level 0 or the first
+     * cascade of a used slot of an upper level, std::numeric_limits<uint64_t>::max() without timers
+     */
+    uint64_t getNextTick() const
+    {
+        if (_size == 0)
+        {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        uint64_t next_tick = std::numeric_limits<uint64_t>::max();
+        for (unsigned int level = 0; level < LSSDP_TIMING_WHEEL_LEVELS; ++level)
+        {
+            if (_used[level] == 0)
+            {
+                continue;
+            }
+            // the slot of level is reached when the lower levels wrap to 0
+            const unsigned int shift = LSSDP_TIMING_WHEEL_BITS * level;
+            const uint64_t rotation = uint64_t(1) << (shift + LSSDP_TIMING_WHEEL_BITS);
+            const uint64_t current_slot = (_current_tick >> shift) & MASK;
+            const uint64_t first_tick = _current_tick & ~(rotation - 1);
+            // the used slots after the current one, the others are reached in the next rotation
+            const uint64_t later = _used[level] & ~((uint64_t(2) << current_slot) - 1);
+            uint64_t tick = (later != 0)
+                ? first_tick + (uint64_t(detail::lowest_bit(later)) << shift)
+                : first_tick + rotation + (uint64_t(detail::lowest_bit(_used[level])) << shift);
+            next_tick = std::min(next_tick, tick);
+        }
+        return next_tick;
+    }
+
+    /**
+     * advances to @p now_tick and appends the timers which expired to @p expired,
+     * the ticks without a used slot are skipped
+     */
+    void advance(uint64_t now_tick, std::vector<uint32_t>& expired)
+    {
+        while (_size > 0)
+        {
+            uint64_t next_tick = getNextTick();
+            if (next_tick > now_tick)
+            {
+                break;
+            }
+            _current_tick = next_tick;
+            // the lower levels wrapped, the slot of the upper level moves down
+            for (unsigned int level = 1; level < LSSDP_TIMING_WHEEL_LEVELS; ++level)
+            {
+                if ((_current_tick & ((uint64_t(1) << (LSSDP_TIMING_WHEEL_BITS * level)) - 1)) != 0)
+                {
+                    break;
+                }
+                cascade(level, (_current_tick >> (LSSDP_TIMING_WHEEL_BITS * level)) & MASK);
+            }
+
+            uint32_t timer = detach(0, _current_tick & MASK);
+            while (timer != NO_TIMER)
+            {
+                uint32_t next = _timers[timer]._next;
+                if (_timers[timer]._expiry_tick <= _current_tick)
+                {
+                    --_size;
+                    expired.push_back(timer);
+                }
+                else
+                {
+                    // parked beyond the range of the wheel
+                    insert(timer, _current_tick + 1);
+                }
+                timer = next;
+            }
+        }
+        if (_current_tick < now_tick)
+        {
+            // no used slot up to now_tick
+            _current_tick = now_tick;
+        }
+    }
+
+private:
+    static constexpr uint32_t NO_TIMER = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+    static constexpr uint64_t SLOTS = uint64_t(1) << LSSDP_TIMING_WHEEL_BITS;
+    static constexpr uint64_t MASK = SLOTS - 1;
+
+    struct Timer
+    {
+        uint64_t _expiry_tick = 0;
+        uint32_t _prev = NO_TIMER;
+        uint32_t _next = NO_TIMER;
+        uint32_t _slot = NO_SLOT;  // level * SLOTS + slot
+    };
+
+    // places @p timer in its level, an expiry before @p first_tick is due at @p first_tick
+    void insert(uint32_t timer, uint64_t first_tick)
+    {
+        Timer& current = _timers[timer];
+        uint64_t expiry_tick = std::max(current._expiry_tick, first_tick);
+        uint64_t delta = expiry_tick - _current_tick;
+        unsigned int level = 0;
+        while (level + 1 < LSSDP_TIMING_WHEEL_LEVELS
+               && delta >= (uint64_t(1) << (LSSDP_TIMING_WHEEL_BITS * (level + 1))))
+        {
+            ++level;
+        }
+        if (delta >= (uint64_t(1) << (LSSDP_TIMING_WHEEL_BITS * LSSDP_TIMING_WHEEL_LEVELS)))
+        {
+            // beyond the range, the cascade of the top level places it again
+            expiry_tick = _current_tick + (uint64_t(1) << (LSSDP_TIMING_WHEEL_BITS * LSSDP_TIMING_WHEEL_LEVELS)) - 1;
+        }
+        uint32_t slot = static_cast<uint32_t>((expiry_tick >> (LSSDP_TIMING_WHEEL_BITS * level)) & MASK);
+        uint32_t& head = _slots[level][slot];
+        _used[level] |= uint64_t(1) << slot;
+        current._slot = static_cast<uint32_t>(level * SLOTS + slot);
+        current._prev = NO_TIMER;
+        current._next = head;
+        if (head != NO_TIMER)
+        {
+            _timers[head]._prev = timer;
+        }
+        head = timer;
+    }
+
+    void unlink(uint32_t timer)
+    {
+        Timer& current = _timers[timer];
+        if (current._prev != NO_TIMER)
+        {
+            _timers[current._prev]._next = current._next;
+        }
+        else
+        {
+            _slots[current._slot / SLOTS][current._slot % SLOTS] = current._next;
+            if (current._next == NO_TIMER)
+            {
+                _used[current._slot / SLOTS] &= ~(uint64_t(1) << (current._slot % SLOTS));
+            }
+        }
+        if (current._next != NO_TIMER)
+        {
+            _timers[current._next]._prev = current._prev;
+        }
+        current._slot = NO_SLOT;
+    }
+
+    // takes the list of a slot, the timers are unlinked
+    uint32_t detach(unsigned int level, uint64_t slot)
+    {
+        uint32_t head = _slots[level][slot];
+        _slots[level][slot] = NO_TIMER;
+        _used[level] &= ~(uint64_t(1) << slot);
+        for (uint32_t timer = head; timer != NO_TIMER; timer = _timers[timer]._next)
+        {
+            _timers[timer]._slot = NO_SLOT;
+        }
+        return head;
+    }
+
+    void cascade(unsigned int level, uint64_t slot)
+    {
+        uint32_t timer = detach(level, slot);
+        while (timer != NO_TIMER)
+        {
+            uint32_t next = _timers[timer]._next;
+            // the slot of the current tick is handled right after the cascade
+            insert(timer, _current_tick);
+            timer = next;
+        }
+    }
+
+    uint32_t           _slots[LSSDP_TIMING_WHEEL_LEVELS][SLOTS];
+    // bit n of a level is set if its slot n has timers
+    uint64_t           _used[LSSDP_TIMING_WHEEL_LEVELS];
+    std::vector<Timer> _timers;
+    uint64_t           _current_tick = 0;
+    size_t             _size = 0;
+};
+
+/**********************************************************************************/
+/* Response scheduler of a Service or a ServiceHost: a response to an M-SEARCH    */
+/* waits a random delay within the MX on a timing wheel of 1 ms ticks, the poll   */
+/* wait ends when the next one is due. A repeated M-SEARCH of the same requester  */
+/* is merged into the pending response, at most LSSDP_MAX_PENDING_RESPONSES wait. */
+/**********************************************************************************/
+class ResponseScheduler
+{
+public:
+
+    struct Response
+    {
+        uint32_t _requester = 0;          // network byte order
+        uint16_t _requester_port = 0;     // network byte order
+        uint32_t _interface_address = 0;  // the interface to send from
+        uint32_t _message = 0;            // the response message of the owner, i.e. a hosted service
+        MatchedSearchTarget _search_target;  // the ST to echo
+    };
+
+    ResponseScheduler() :
+        _epoch(std::chrono::steady_clock::now()),
+        _random(std::random_device()())
+    {
+    }
+
+    void setMaxDelay(std::chrono::milliseconds max_delay)
+    {
+        _max_delay = max_delay;
+    }
+
+    /**
+     * a random delay within the MX of the M-SEARCH @p packet and the max delay,
+     * 0 if the packet has no MX
+     */
+    std::chrono::milliseconds getDelay(const LSSDPPacket& packet)
+    {
+        std::chrono::seconds mx;
+        if (_max_delay.count() <= 0 || !packet.getHeaders().getMx(mx) || mx.count() <= 0)
+        {
+            return std::chrono::milliseconds(0);
+        }
+        std::uniform_int_distribution<int64_t> distribution(0, std::min<std::chrono::milliseconds>(mx, _max_delay).count());
+        return std::chrono::milliseconds(distribution(_random));
+    }
+
+    /**
+     * queues @p response to be sent at @p due, the same response pending already is merged
+     * and counted in Statistics::_merged_responses, a response beyond LSSDP_MAX_PENDING_RESPONSES
+     * is dropped and counted in Statistics::_dropped_responses
+     */
+    void schedule(const Response& response,
+                  std::chrono::steady_clock::time_point due,
+                  std::chrono::steady_clock::time_point now,
+                  Statistics& statistics)
+    {
+        Key key = getKey(response);
+        if (_pending.find(key) != _pending.end())
+        {
+            ++statistics._merged_responses;
+            return;
+        }
+        if (_pending.size() >= LSSDP_MAX_PENDING_RESPONSES)
+        {
+            ++statistics._dropped_responses;
+            return;
+        }
+        if (_wheel.size() == 0)
+        {
+            // nothing scheduled, the wheel jumps to now instead of walking each tick since the last response
+            _wheel.advance(getTick(now), _expired);
+        }
+        uint32_t timer;
+        if (!_free_timers.empty())
+        {
+            timer = _free_timers.back();
+            _free_timers.pop_back();
+        }
+        else
+        {
+            timer = static_cast<uint32_t>(_responses.size());
+            _responses.emplace_back();
+        }
+        _responses[timer] = response;
+        _pending.emplace(key, timer);
+        _wheel.schedule(timer, getTick(due));
+    }
+
+    std::chrono::steady_clock::time_point getNextTimeout() const
+    {
+        if (_wheel.size() == 0)
+        {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        return _epoch + std::chrono::milliseconds(_wheel.getNextTick());
+    }
+
+    /**
+     * appends the responses due at @p now to @p due, they are no longer pending
+     */
+    void takeDue(std::chrono::steady_clock::time_point now, std::vector<Response>& due)
+    {
+        _expired.clear();
+        _wheel.advance(getTick(now), _expired);
+        for (auto timer : _expired)
+        {
+            due.push_back(_responses[timer]);
+            _pending.erase(getKey(_responses[timer]));
+            _free_timers.push_back(timer);
+        }
+    }
+
+    /**
+     * drops the pending responses with @p message, the greater messages move down by one
+     */
+    void removeMessage(uint32_t message)
+    {
+        std::unordered_map<Key, uint32_t, KeyHash> pending;
+        for (const auto& current : _pending)
+        {
+            Response& response = _responses[current.second];
+            if (response._message == message)
+            {
+                _wheel.cancel(current.second);
+                _free_timers.push_back(current.second);
+                continue;
+            }
+            if (response._message > message)
+            {
+                --response._message;
+            }
+            pending.emplace(getKey(response), current.second);
+        }
+        _pending.swap(pending);
+    }
+
+private:
+    struct Key
+    {
+        uint64_t _requester;      // address and port
+        uint64_t _source;         // interface address and message
+        uint64_t _search_target;  // kind and version
+        bool operator==(const Key& other) const
+        {
+            return _requester == other._requester && _source == other._source
+                   && _search_target == other._search_target;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return static_cast<size_t>((key._requester * 0x9E3779B97F4A7C15ULL ^ key._source) + key._search_target);
+        }
+    };
+
+    static Key getKey(const Response& response)
+    {
+        return { (static_cast<uint64_t>(response._requester) << 16) | response._requester_port,
+                 (static_cast<uint64_t>(response._interface_address) << 32) | response._message,
+                 (static_cast<uint64_t>(response._search_target._kind) << 32) | response._search_target._version };
+    }
+
+    uint64_t getTick(std::chrono::steady_clock::time_point time) const
+    {
+        if (time <= _epoch)
+        {
+            return 0;
+        }
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(time - _epoch).count());
+    }
+
+    std::chrono::steady_clock::time_point       _epoch;
+    std::chrono::milliseconds                   _max_delay = LSSDP_DEFAULT_MAX_RESPONSE_DELAY;
+    std::minstd_rand                            _random;
+    TimingWheel                                 _wheel;
+    std::vector<Response>                       _responses;
+    std::vector<uint32_t>                       _free_timers;
+    std::unordered_map<Key, uint32_t, KeyHash>  _pending;
+    std::vector<uint32_t>                       _expired;
+};
+
+/**
+ * sets the BOOTID.UPNP.ORG header line of @p boot_id into @p header and the boot id slot
+ * of @p slot_values, a boot id of 0 has none
+ */
+static void setBootIdSlot(uint32_t boot_id, std::string& header, StringRef* slot_values)
+{
+    header.clear();
+    if (boot_id != 0)
+    {
+        header = "BOOTID.UPNP.ORG:" + std::to_string(boot_id) + "\r\n";
+    }
+    slot_values[MessageTemplate::slot_boot_id] = StringRef(header.data(), header.size());
+}
+
+/**
+ * prepares the messages of a service to prevent string memory allocation on each send
+ */
+static void createServiceMessages(const ServiceDescription& description,
+                           cxxurl::Url& url,
+                           std::chrono::seconds max_age,
+                           MessageTemplate& notify_alive_message,
+                           MessageTemplate& notify_byebye_message,
+                           MessageTemplate& response_message)
+{
+    const std::string host = url.host() + ":" + url.port();
+    const std::string cache_control = "max-age=" + std::to_string(max_age.count());
+    const std::string server = OSVersion::getOsVersion().getName() + "/" + OSVersion::getOsVersion().getVersion()
+                               + " " + description.getProductName() + "/" + description.getProductVersion();
+
+    //prepare notify alive message
+    notify_alive_message.clear();
+    notify_alive_message.add(LSSDP_HEADER_NOTIFY)
+                        .addHeader("HOST:", host)
+                        .addHeader("CACHE-CONTROL:", cache_control)
+                        .add("LOCATION:").addSlot(MessageTemplate::slot_location).add("\r\n")
+                        .addHeader("SERVER:", server)
+                        .addHeader("NT:", description.getSearchTarget())
+                        .addHeader("NTS:", LSSDP_NOTIFY_NTS_ALIVE)
+                        .addHeader("USN:", description.getUniqueServiceName());
+    if (!description.getSMID().empty())
+    {
+        notify_alive_message.addHeader("SM_ID:", description.getSMID());
+    }
+    if (!description.getDeviceType().empty())
+    {
+        notify_alive_message.addHeader("DEV_TYPE:", description.getDeviceType());
+    }
+    notify_alive_message.addSlot(MessageTemplate::slot_boot_id).add("\r\n");
+
+    //prepare notify byebye message
+    notify_byebye_message.clear();
+    notify_byebye_message.add(LSSDP_HEADER_NOTIFY)
+                         .addHeader("HOST:", host)
+                         .addHeader("NT:", description.getSearchTarget())
+                         .addHeader("NTS:", LSSDP_NOTIFY_NTS_BYEBYE)
+                         .addHeader("USN:", description.getUniqueServiceName())
+                         .addSlot(MessageTemplate::slot_boot_id).add("\r\n");
+
+    //prepare response message
+    response_message.clear();
+    response_message.add(LSSDP_HEADER_RESPONSE)
+                    .addHeader("CACHE-CONTROL:", cache_control)
+                    .add("DATE:").addSlot(MessageTemplate::slot_date).add("\r\n")
+                    .add("EXT:\r\n")
+                    .add("LOCATION:").addSlot(MessageTemplate::slot_location).add("\r\n")
+                    .addHeader("SERVER:", server)
+                    .add("ST:").addSlot(MessageTemplate::slot_search_target).add("\r\n")
+                    .addHeader("USN:", description.getUniqueServiceName());
+    if (!description.getSMID().empty())
+    {
+        response_message.addHeader("SM_ID: ", description.getSMID());
+    }
+    if (!description.getDeviceType().empty())
+    {
+        response_message.addHeader("DEV_TYPE: ", description.getDeviceType());
+    }
+    response_message.addSlot(MessageTemplate::slot_boot_id).add("\r\n");
+}
+
+/*****************************************************************************************/
+/**
+ * the prepared messages of a service, with a LOCATION template containing
+ * LSSDP_LOCATION_INTERFACE_IP the location is rendered once for each interface when the
+ * interfaces change, a send only picks the location of its interface for the slot
+ */
+class ServiceMessages
+{
+public:
+    void create(const ServiceDescription& description,
+                cxxurl::Url& url,
+                std::chrono::seconds max_age)
+    {
+        createServiceMessages(description,
+                              url,
+                              max_age,
+                              _notify_alive_message,
+                              _notify_byebye_message,
+                              _response_message);
+        _location = description.getLocationURL();
+        _per_interface = (_location.find(LSSDP_LOCATION_INTERFACE_IP) != std::string::npos);
+        _variants.clear();
+
+        _search_target = description.getSearchTarget();
+        const auto& unique_service_name = description.getUniqueServiceName();
+        _device = getDeviceOfUsn(StringRef(unique_service_name.data(), unique_service_name.size())).str();
+        size_t type_size = 0;
+        uint32_t version = 0;
+        _urn_type.clear();
+        if (parseUrnVersion(_search_target.data(), _search_target.size(), type_size, version))
+        {
+            _urn_type = _search_target.substr(0, type_size);
+        }
+        _urn_versions.clear();
+    }
+
+    /**
+     * renders the location for each of the @p network_interfaces
+     */
+    void updateInterfaces(const std::vector<NetworkInterface>& network_interfaces)
+    {
+        if (!_per_interface)
+        {
+            return;
+        }
+        _variants.clear();
+        for (const auto& current_interface : network_interfaces)
+        {
+            Variant variant;
+            variant._interface_address = current_interface.getAddrIp4();
+            variant._location = renderLocation(_location, current_interface.getIp4());
+            _variants.push_back(std::move(variant));
+        }
+    }
+
+    const MessageTemplate& getNotifyAlive() const
+    {
+        return _notify_alive_message;
+    }
+
+    const MessageTemplate& getNotifyByeBye() const
+    {
+        return _notify_byebye_message;
+    }
+
+    const std::string& getSearchTarget() const
+    {
+        return _search_target;
+    }
+
+    /**
+     * fills @p datagram with @p message for its interface, sets the location slot of @p slot_values
+     * @retval false the location of the interface is not rendered, the datagram is not filled and
+     *               counted as a send failure with an error in @p send_errors
+     */
+    bool fill(const MessageTemplate& message,
+              StringRef* slot_values,
+              SendSocketTable::Datagram& datagram,
+              std::map<std::string, std::string>& send_errors) const
+    {
+        const std::string* location = getLocation(datagram._interface_address);
+        if (location == nullptr)
+        {
+            // never send the template with its placeholder
+            struct in_addr interface_address;
+            interface_address.s_addr = datagram._interface_address;
+            ++datagram._statistics->_send_failures;
+            send_errors[inet_ntoa(interface_address)] = std::string("no LOCATION rendered for the interface ")
+                                                        + inet_ntoa(interface_address);
+            return false;
+        }
+        slot_values[MessageTemplate::slot_location] = StringRef(location->data(), location->size());
+        message.fill(slot_values, datagram._segments, datagram._segment_count);
+        return true;
+    }
+
+    /**
+     * fills @p datagram with the response for its interface, it carries the ST of @p search_target
+     * @retval false see fill
+     */
+    bool fillResponse(const MatchedSearchTarget& search_target,
+                      StringRef* slot_values,
+                      SendSocketTable::Datagram& datagram,
+                      std::map<std::string, std::string>& send_errors)
+    {
+        slot_values[MessageTemplate::slot_search_target] = renderSearchTarget(search_target);
+        return fill(_response_message, slot_values, datagram, send_errors);
+    }
+
+private:
+    struct Variant
+    {
+        uint32_t    _interface_address = 0;
+        std::string _location;
+    };
+
+    /**
+     * the location for @p interface_address, nullptr if the location is a template and
+     * the interface is not one of the interfaces it was rendered for
+     */
+    const std::string* getLocation(uint32_t interface_address) const
+    {
+        if (!_per_interface)
+        {
+            return &_location;
+        }
+        // a handful of interfaces, a scan beats a hash
+        for (const auto& variant : _variants)
+        {
+            if (variant._interface_address == interface_address)
+            {
+                return &variant._location;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * the ST of @p search_target, an earlier version of the urn type is rendered on its first
+     * response and kept, the versions are bounded by the version of the service
+     */
+    StringRef renderSearchTarget(const MatchedSearchTarget& search_target)
+    {
+        switch (search_target._kind)
+        {
+        case MatchedSearchTarget::urn_version:
+            if (!_urn_type.empty())
+            {
+                std::string& rendered = _urn_versions[search_target._version];
+                if (rendered.empty())
+                {
+                    rendered = _urn_type + ":" + std::to_string(search_target._version);
+                }
+                return StringRef(rendered.data(), rendered.size());
+            }
+            break;
+        case MatchedSearchTarget::root_device:
+            return StringRef(LSSDP_SEARCH_TARGET_ROOT_DEVICE, strlen(LSSDP_SEARCH_TARGET_ROOT_DEVICE));
+        case MatchedSearchTarget::device:
+            if (!_device.empty())
+            {
+                return StringRef(_device.data(), _device.size());
+            }
+            break;
+        case MatchedSearchTarget::own:
+            break;
+        }
+        return StringRef(_search_target.data(), _search_target.size());
+    }
+
+    /**
+     * @p location with each LSSDP_LOCATION_INTERFACE_IP replaced by @p ip
+     */
+    static std::string renderLocation(const std::string& location, const std::string& ip)
+    {
+        std::string rendered = location;
+        const size_t placeholder_size = strlen(LSSDP_LOCATION_INTERFACE_IP);
+        for (size_t found = rendered.find(LSSDP_LOCATION_INTERFACE_IP);
+             found != std::string::npos;
+             found = rendered.find(LSSDP_LOCATION_INTERFACE_IP, found + ip.size()))
+        {
+            rendered.replace(found, placeholder_size, ip);
+        }
+        return rendered;
+    }
+
+    MessageTemplate      _notify_alive_message;
+    MessageTemplate      _notify_byebye_message;
+    MessageTemplate      _response_message;
+    std::string          _location;
+    bool                 _per_interface = false;
+    std::vector<Variant> _variants;
+    std::string          _search_target;
+    std::string          _device;
+    std::string          _urn_type;
+    // node based, the rendered versions stay where the queued datagrams point
+    std::map<uint32_t, std::string> _urn_versions;
+};
+
+/**
+ * the address of the interface to send the response to @p packet from
+ * @retval false the requester is on none of our networks
+ */
+static bool findResponseInterface(const LSSDPPacket& packet,
+                           const std::vector<NetworkInterface>& network_interfaces,
+                           uint32_t& interface_address)
+{
+    // 1. the interface the M-SEARCH came in on (IP_PKTINFO), if the platform tells it
+    if (packet._local_address != 0)
+    {
+        interface_address = packet._local_address;
+        return true;
+    }
+    // 2. otherwise find the interface which is in LAN
+    for (const auto& intf : network_interfaces)
+    {
+        if ((intf.getAddrIp4() & intf.getAddrNetMaskIp4())
+            == (packet._received_from & intf.getAddrNetMaskIp4()))
+        {
+            interface_address = intf.getAddrIp4();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**********************************************************************************/
+/* The services announced and responded on one discover url: the NOTIFYs for all */
+/* interfaces, the responses to the M-SEARCHs and the socket they are received    */
+/* on. A Service responds one service with it, a ServiceHost many.                */
+/**********************************************************************************/
+class ServiceResponder : public PollSource
+{
+public:
+    /**
+     * a hosted service with its prepared messages
+     */
+    struct HostedService
+    {
+        ServiceDescription _description;
+        ServiceMessages    _messages;
+    };
+
+    enum MessageType
+    {
+        alive,
+        byebye
+    };
+
+    ServiceResponder(std::string discover_url,
+                     std::chrono::seconds max_age)
+        : _discover_url(discover_url),
+          _url(discover_url),
+          _max_age(max_age)
+    {
+        _port = static_cast<uint16_t>(std::stoi(_url.port()));
+
+        //very important !! this must be an IP address ... we check that
+        if (_url.ip_version() != 4)
+        {
+            throw std::runtime_error("The given url " + discover_url + " does not contain a IPv4 multicast address for host");
+        }
+        _address = inet_addr(_url.host().c_str());
+
+        //open the socket NOW for the NOTIFY Messages 
+        _interface_watcher.update(_network_interfaces, _added_interfaces, _removed_interfaces);
+        _send_sockets.update(_added_interfaces, _removed_interfaces);
+        openSocket();
+        _poller.add(this);
+    }
+    ~ServiceResponder()
+    {
+        closeSocket();
+        _send_sockets.clear();
+    }
+
+    bool addService(const ServiceDescription& service)
+    {
+        // the queued datagrams refer to the messages of the services
+        flush();
+        auto services_of_target = _search_targets.findExact(service.getSearchTarget());
+        if (services_of_target != nullptr)
+        {
+            for (auto index : *services_of_target)
+            {
+                if (_services[index]._description == service)
+                {
+                    return false;
+                }
+            }
+        }
+        HostedService hosted_service;
+        hosted_service._description = service;
+        hosted_service._messages.create(service, _url, _max_age);
+        hosted_service._messages.updateInterfaces(_network_interfaces);
+        _search_targets.add(static_cast<uint32_t>(_services.size()),
+                            service.getSearchTarget(),
+                            service.getUniqueServiceName(),
+                            service.getDeviceType());
+        _services.push_back(std::move(hosted_service));
+        return true;
+    }
+
+    bool removeService(const ServiceDescription& service)
+    {
+        auto found = std::find_if(_services.begin(), _services.end(),
+            [&service](const HostedService& current)
+            {
+                return current._description == service;
+            });
+        if (found == _services.end())
+        {
+            return false;
+        }
+        flush();
+        _response_scheduler.removeMessage(static_cast<uint32_t>(found - _services.begin()));
+        _services.erase(found);
+
+        // the indices behind the removed service moved
+        _search_targets.clear();
+        for (size_t index = 0; index < _services.size(); ++index)
+        {
+            const auto& description = _services[index]._description;
+            _search_targets.add(static_cast<uint32_t>(index),
+                                description.getSearchTarget(),
+                                description.getUniqueServiceName(),
+                                description.getDeviceType());
+        }
+        return true;
+    }
+
+    const std::vector<HostedService>& getServices() const
+    {
+        return _services;
+    }
+
+    uint64_t getSocketsVersion() const override
+    {
+        return _sockets_version;
+    }
+
+    void getSockets(std::vector<SOCKET_TYPE>& sockets) const override
+    {
+        sockets.clear();
+        if (_multicast_socket._socket > 0)
+        {
+            sockets.push_back(_multicast_socket.getPollSocket());
+        }
+    }
+
+    bool onReadable(SOCKET_TYPE /*socket*/) override
+    {
+        bool error_while_sending = false;
+        _multicast_socket.receivePackets(_received_packets,
+                                         LSSDP_DEFAULT_RECEIVE_BATCH,
+                                         _statistics._receive);
+        auto now = std::chrono::steady_clock::now();
+        // the date of all responses of this batch, they leave with one flush
+        _slot_values[MessageTemplate::slot_date] = HttpDate::now();
+        for (const auto& packet : _received_packets)
+        {
+            if (packet._method == LSSDPPacket::msearch)
+            {
+                scheduleResponses(packet, now);
+            }
+        }
+        // the responses without delay leave as one batch
+        if (!flush())
+        {
+            error_while_sending = true;
+        }
+        return (!error_while_sending);
+    }
+
+    std::chrono::steady_clock::time_point getNextTimeout() const override
+    {
+        return _response_scheduler.getNextTimeout();
+    }
+
+    bool onTimeout(std::chrono::steady_clock::time_point now) override
+    {
+        _due_responses.clear();
+        _response_scheduler.takeDue(now, _due_responses);
+        // the date of all responses of this wakeup, they leave as one batch
+        _slot_values[MessageTemplate::slot_date] = HttpDate::now();
+        for (const auto& response : _due_responses)
+        {
+            queueResponse(_services[response._message], response);
+        }
+        return flush();
+    }
+
+    /**
+     * queues the NOTIFY of each service for all interfaces, it is sent with the next flush
+     */
+    void queueNotify(MessageType m_type)
+    {
+        updateNetworkInterfaces();
+        for (const auto& service : _services)
+        {
+            for (const auto& current_interface : _network_interfaces)
+            {
+                if (!LSSDP_SEND_TO_LOCALHOST)
+                {
+                    if (current_interface.getIp4() == LSSDP_ADDR_LOCALHOST)
+                    {
+                        continue;
+                    }
+                }
+                _pending_datagrams.emplace_back(current_interface.getAddrIp4(), _address, _port, &_statistics._notify);
+                if (!service._messages.fill((m_type == byebye)
+                                                ? service._messages.getNotifyByeBye()
+                                                : service._messages.getNotifyAlive(),
+                                            _slot_values,
+                                            _pending_datagrams.back(),
+                                            _send_errors))
+                {
+                    _pending_datagrams.pop_back();
+                }
+            }
+        }
+    }
+
+    bool sendNotify(MessageType m_type)
+    {
+        queueNotify(m_type);
+        return flush();
+    }
+
+    /**
+     * sends all queued datagrams as one batch
+     */
+    bool flush()
+    {
+        if (_pending_datagrams.empty())
+        {
+            return true;
+        }
+        bool sent = _send_sockets.sendBatch(_pending_datagrams.data(),
+                                            _pending_datagrams.size(),
+                                            _send_errors);
+        _pending_datagrams.clear();
+        return sent;
+    }
+
+    /**
+     * waits until @p timeout for M-SEARCHs and responds them
+     */
+    bool checkForMSearchAndSendResponse(std::chrono::milliseconds timeout)
+    {
+        std::string error_msg;
+        bool return_value = _poller.waitUntil(std::chrono::steady_clock::now() + timeout, error_msg);
+        if (!error_msg.empty())
+        {
+            _send_errors[_discover_url] = std::string("wait on ") + _discover_url
+                + " failed: " + error_msg;
+        }
+        return return_value;
+    }
+
+    void setMaxResponseDelay(std::chrono::milliseconds max_delay)
+    {
+        _response_scheduler.setMaxDelay(max_delay);
+    }
+
+    void setSearchRateLimit(double searches_per_second, uint32_t burst)
+    {
+        _search_rate_limiter.setLimit(searches_per_second, burst);
+    }
+
+    void setBootId(uint32_t boot_id)
+    {
+        // the queued datagrams refer to the header of the old boot id
+        flush();
+        setBootIdSlot(boot_id, _boot_id_header, _slot_values);
+    }
+
+    std::string getSendErrors()
+    {
+        std::string created_message;
+        for (const auto& current : _send_errors)
+        {
+            created_message += current.second;
+        }
+        _send_errors.clear();
+        return created_message;
+    }
+
+    Statistics getStatistics() const
+    {
+        Statistics statistics = _statistics;
+        _send_sockets.fillStatistics(statistics);
+        return statistics;
+    }
+
+private:
+    void openSocket()
+    {
+        _multicast_socket.open(_address, _port);
+        _multicast_socket.updateMemberships(_network_interfaces, std::vector<NetworkInterface>(), _send_errors);
+        // the responses leave from the SSDP port the M-SEARCH was sent to
+        _send_sockets.setSource(htonl(INADDR_ANY), _multicast_socket._socket);
+        ++_sockets_version;
+    }
+
+    void closeSocket()
+    {
+        _send_sockets.setSource(htonl(INADDR_ANY), 0);
+        _multicast_socket.close();
+    }
+
+    void updateNetworkInterfaces()
+    {
+        bool updated = _interface_watcher.update(_network_interfaces, _added_interfaces, _removed_interfaces);
+        if (updated)
+        {
+            // the queued datagrams refer to the locations of the old interfaces
+            flush();
+            // the socket stays bound, no datagram queued in the kernel gets lost
+            _send_sockets.update(_added_interfaces, _removed_interfaces);
+            _multicast_socket.updateMemberships(_added_interfaces, _removed_interfaces, _send_errors);
+            for (auto& service : _services)
+            {
+                service._messages.updateInterfaces(_network_interfaces);
+            }
+        }
+    }
+
+    /**
+     * queues the responses of the matching services to the M-SEARCH @p packet if it has no MX,
+     * otherwise each is queued after a random delay within the MX
+     */
+    void scheduleResponses(const LSSDPPacket& packet, std::chrono::steady_clock::time_point now)
+    {
+        ResponseScheduler::Response response;
+        // 1. find the interface the M-SEARCH came from
+        if (!findResponseInterface(packet, _network_interfaces, response._interface_address))
+        {
+            return;
+        }
+        response._requester = packet._received_from;
+        response._requester_port = packet._received_from_port;
+
+        // 2. the matching services, one lookup in the search target index
+        _matching.clear();
+        _search_targets.match(packet._st, packet._device_type, _matching);
+        if (_matching.empty())
+        {
+            return;
+        }
+
+        // 3. a requester searching too often is not responded
+        if (!_search_rate_limiter.allow(packet._received_from, now))
+        {
+            ++_statistics._suppressed_msearches;
+            return;
+        }
+        // 4. wait within the MX, the requesters of many control points are not answered at once
+        for (auto index : _matching)
+        {
+            scheduleResponse(packet, response, index, now);
+        }
+    }
+
+    void scheduleResponse(const LSSDPPacket& packet,
+                          ResponseScheduler::Response& response,
+                          size_t index,
+                          std::chrono::steady_clock::time_point now)
+    {
+        response._search_target = matchSearchTarget(packet._st, _services[index]._messages.getSearchTarget());
+        auto delay = _response_scheduler.getDelay(packet);
+        if (delay.count() == 0)
+        {
+            queueResponse(_services[index], response);
+            return;
+        }
+        response._message = static_cast<uint32_t>(index);
+        _response_scheduler.schedule(response, now + delay, now, _statistics);
+    }
+
+    void queueResponse(HostedService& service, const ResponseScheduler::Response& response)
+    {
+        // unicast to the requester, only it has to parse the response
+        _pending_datagrams.emplace_back(response._interface_address,
+                                        response._requester,
+                                        ntohs(response._requester_port),
+                                        &_statistics._response);
+        if (!service._messages.fillResponse(response._search_target, _slot_values, _pending_datagrams.back(), _send_errors))
+        {
+            _pending_datagrams.pop_back();
+        }
+    }
+
+    uint16_t _port = 0;
+    uint32_t _address = 0;
+
+    std::string          _discover_url;
+    cxxurl::Url          _url;
+    std::chrono::seconds _max_age;
+
+    std::vector<HostedService>      _services;
+    SearchTargetIndex               _search_targets;
+    StringRef                       _slot_values[MessageTemplate::slot_count];
+    std::string                     _boot_id_header;
+
+    std::vector<NetworkInterface>   _network_interfaces;
+    NetworkInterfaceWatcher         _interface_watcher;
+    std::vector<NetworkInterface>   _added_interfaces;
+    std::vector<NetworkInterface>   _removed_interfaces;
+    NonBlockingMulticastSocket      _multicast_socket;
+    uint64_t                        _sockets_version = 0;
+    SendSocketTable                 _send_sockets;
+    std::vector<SendSocketTable::Datagram> _pending_datagrams;
+    std::vector<LSSDPPacket>        _received_packets;
+    ResponseScheduler               _response_scheduler;
+    std::vector<ResponseScheduler::Response> _due_responses;
+    SearchRateLimiter               _search_rate_limiter;
+    std::vector<uint32_t>           _matching;
+    Poller                          _poller;
+    std::map<std::string, std::string> _send_errors;
+    Statistics                      _statistics;
+};
+
+/*****************************************************************************************/
+struct Service::Impl : public ServiceResponder
+{
+    Impl(std::string discover_url,
+        std::chrono::seconds max_age,
+        std::string location_url,
+        std::string unique_service_name,
+        std::string search_target,
+        std::string product_name,
+        std::string product_version,
+        std::string sm_id,
+        std::string device_type) 
+        : ServiceResponder(discover_url, max_age)
+    {
+        addService(ServiceDescription(location_url,
+                                      unique_service_name,
+                                      search_target,
+                                      product_name,
+                                      product_version,
+                                      sm_id,
+                                      device_type));
+    }
+
+    const ServiceDescription& getDescription() const
+    {
+        return getServices().front()._description;
+    }
+};
+
+/*****************************************************************************************/
+Service::Service(std::string discover_url,
+                 std::chrono::seconds max_age,
+                 std::string location_url,
+                 std::string unique_service_name,
+                 std::string search_target,
+                 std::string product_name,
+                 std::string product_version,
+                 std::string sm_id ,
+                 std::string device_type) :
+    _impl(std::make_unique<Impl>(discover_url,
+        max_age,
+        location_url,
+        unique_service_name,
+        search_target,
+        product_name,
+        product_version,
+        sm_id,
+        device_type
+        ))
+{
+}
+
+Service::~Service()
+{
+}
+
+bool Service::sendNotifyAlive()
+{
+    return _impl->sendNotify(Impl::alive);
+}
+
+bool Service::sendNotifyByeBye()
+{
+    return _impl->sendNotify(Impl::byebye);
+}
+
+void Service::queueNotifyAlive()
+{
+    _impl->queueNotify(Impl::alive);
+}
+
+void Service::queueNotifyByeBye()
+{
+    _impl->queueNotify(Impl::byebye);
+}
+
+bool Service::flush()
+{
+    return _impl->flush();
+}
+
+bool Service::checkForMSearchAndSendResponse(std::chrono::milliseconds timeout)
+{
+    return _impl->checkForMSearchAndSendResponse(timeout);
+}
+
+void Service::setMaxResponseDelay(std::chrono::milliseconds max_delay)
+{
+    _impl->setMaxResponseDelay(max_delay);
+}
+
+void Service::setSearchRateLimit(double searches_per_second, uint32_t burst)
+{
+    _impl->setSearchRateLimit(searches_per_second, burst);
+}
+
+void Service::setBootId(uint32_t boot_id)
+{
+    _impl->setBootId(boot_id);
+}
+
+bool Service::operator==(const ServiceDescription& other) const
+{
+    return (other == _impl->getDescription());
+}
+
+ServiceDescription Service::getServiceDescription() const
+{
+    return _impl->getDescription();
+}
+
+std::string Service::getLastSendErrors() const
+{
+    return _impl->getSendErrors();
+}
+
+Statistics Service::getStatistics() const
+{
+    return _impl->getStatistics();
+}
+
+/*****************************************************************************************/
+struct ServiceHost::Impl : public ServiceResponder
+{
+    using ServiceResponder::ServiceResponder;
+};
+
+/*****************************************************************************************/
+ServiceHost::ServiceHost(std::string discover_url,
+                         std::chrono::seconds max_age) :
+    _impl(std::make_unique<Impl>(discover_url, max_age))
+{
+}
+
+ServiceHost::~ServiceHost()
+{
+}
+
+bool ServiceHost::addService(const ServiceDescription& service)
+{
+    return _impl->addService(service);
+}
+
+bool ServiceHost::removeService(const ServiceDescription& service)
+{
+    return _impl->removeService(service);
+}
+
+std::vector<ServiceDescription> ServiceHost::getServices() const
+{
+    std::vector<ServiceDescription> services;
+    services.reserve(_impl->getServices().size());
+    for (const auto& current : _impl->getServices())
+    {
+        services.push_back(current._description);
+    }
+    return services;
+}
+
+bool ServiceHost::sendNotifyAlive()
+{
+    return _impl->sendNotify(Impl::alive);
+}
+
+bool ServiceHost::sendNotifyByeBye()
+{
+    return _impl->sendNotify(Impl::byebye);
+}
+
+void ServiceHost::queueNotifyAlive()
+{
+    _impl->queueNotify(Impl::alive);
+}
+
+void ServiceHost::queueNotifyByeBye()
+{
+    _impl->queueNotify(Impl::byebye);
+}
+
+bool ServiceHost::flush()
+{
+    return _impl->flush();
+}
+
+bool ServiceHost::checkForMSearchAndSendResponse(std::chrono::milliseconds timeout)
+{
+    return _impl->checkForMSearchAndSendResponse(timeout);
+}
+
+void ServiceHost::setMaxResponseDelay(std::chrono::milliseconds max_delay)
+{
+    _impl->setMaxResponseDelay(max_delay);
+}
+
+void ServiceHost::setSearchRateLimit(double searches_per_second, uint32_t burst)
+{
+    _impl->setSearchRateLimit(searches_per_second, burst);
+}
+
+void ServiceHost::setBootId(uint32_t boot_id)
+{
+    _impl->setBootId(boot_id);
+}
+
+std::string ServiceHost::getLastSendErrors() const
+{
+    return _impl->getSendErrors();
+}
+
+Statistics ServiceHost::getStatistics() const
+{
+    return _impl->getStatistics();
+}
+
+
+
+
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+/**********************************************************************************/
+/* Receive workers of a ServiceFinder: one socket bound with SO_REUSEPORT and one */
+/* thread to receive and parse for each shard. The events are queued and merged   */
+/* on the thread which waits for the ready eventfd, for each USN in the order the */
+/* kernel received them.                                                          */
+/**********************************************************************************/
+class ReceiveWorkers
+{
+public:
+    using Event = ServiceFinder::ServiceUpdateEvent;
+    // creates the event of a packet, false if the packet is not of interest
+    using EventFactory = std::function<bool(const LSSDPPacket&, Event&)>;
+
+    /**
+     * starts @p workers threads, worker i is pinned to @p cpus[i % cpus.size()] unless @p cpus is empty
+     */
+    ReceiveWorkers(uint32_t multicast_socket_addr,
+                   uint16_t multicast_socket_port,
+                   size_t workers,
+                   size_t batch_size,
+                   const std::vector<unsigned int>& cpus,
+                   const EventFactory& create_event) :
+        _create_event(create_event),
+        _start(std::chrono::steady_clock::now())
+    {
+        _stop = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        _ready = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (_stop < 0 || _ready < 0)
+        {
+            std::string throw_msg = std::string("eventfd failed, errno = ") + getErrorAsString();
+            closeEvents();
+            throw std::runtime_error(throw_msg);
+        }
+        try
+        {
+            for (size_t index = 0; index < workers; ++index)
+            {
+                std::unique_ptr<Worker> worker(new Worker());
+                worker->_socket.setShard(static_cast<uint32_t>(index), static_cast<uint32_t>(workers));
+                worker->_socket.open(multicast_socket_addr, multicast_socket_port);
+                _workers.push_back(std::move(worker));
+            }
+        }
+        catch (...)
+        {
+            _workers.clear();
+            closeEvents();
+            throw;
+        }
+        for (auto& worker : _workers)
+        {
+            worker->_thread = std::thread(&ReceiveWorkers::run, this, worker.get(), batch_size);
+        }
+        for (size_t index = 0; index < _workers.size() && !cpus.empty(); ++index)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            int result = EINVAL;
+            if (cpus[index % cpus.size()] < CPU_SETSIZE)
+            {
+                CPU_SET(cpus[index % cpus.size()], &cpu_set);
+                result = pthread_setaffinity_np(_workers[index]->_thread.native_handle(), sizeof(cpu_set), &cpu_set);
+            }
+            if (result != 0)
+            {
+                errno = result;
+                std::string throw_msg = std::string("pthread_setaffinity_np to cpu ")
+                    + std::to_string(cpus[index % cpus.size()]) + " failed, errno = " + getErrorAsString();
+                stopWorkers();
+                throw std::runtime_error(throw_msg);
+            }
+        }
+    }
+
+    ~ReceiveWorkers()
+    {
+        stopWorkers();
+    }
+
+    ReceiveWorkers(const ReceiveWorkers&) = delete;
+    ReceiveWorkers& operator=(const ReceiveWorkers&) = delete;
+
+    /**
+     * joins and leaves the group on the sockets of all workers, they keep receiving meanwhile
+     */
+    bool updateMemberships(const std::vector<NetworkInterface>& added,
+                           const std::vector<NetworkInterface>& removed,
+                           std::map<std::string, std::string>& errors)
+    {
+        bool error_occured = false;
+        for (auto& worker : _workers)
+        {
+            if (!worker->_socket.updateMemberships(added, removed, errors))
+            {
+                error_occured = true;
+            }
+        }
+        return (!error_occured);
+    }
+
+    /**
+     * readable while events are queued
+     */
+    int getFd() const
+    {
+        return _ready;
+    }
+
+    /**
+     * takes the queued events of all workers and merges them: sorted by receive time
+     * and for each USN never older than the last event delivered for it
+     * @retval false a worker failed, see @p errors
+     */
+    bool takeEvents(std::vector<Event>& events, std::string& errors)
+    {
+        // reset the eventfd before the queue is taken, a later event makes it readable again
+        uint64_t counter = 0;
+        if (read(_ready, &counter, sizeof(counter)) < 0 && !isWouldBlock())
+        {
+            errors += std::string("read of eventfd failed, errno = ") + getErrorAsString();
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _taken.swap(_queued);
+            errors += _errors;
+            _errors.clear();
+        }
+        std::stable_sort(_taken.begin(), _taken.end(),
+                         [](const Received& left, const Received& right) { return left._received < right._received; });
+
+        events.clear();
+        uint64_t now_tick = getTick(std::chrono::steady_clock::now());
+        for (auto& current : _taken)
+        {
+            const std::string& usn = current._event._service_description.getUniqueServiceName();
+            auto found = _order_index.find(usn);
+            if (found == _order_index.end())
+            {
+                found = _order_index.emplace(usn, allocateOrder(usn)).first;
+            }
+            LastReceived& last_received = _last_received[found->second];
+            _order_wheel.schedule(found->second, now_tick + static_cast<uint64_t>(LSSDP_RECEIVE_ORDER_HORIZON.count()));
+            if (current._received < last_received._received)
+            {
+                ++_stale_events;
+                continue;
+            }
+            last_received._received = current._received;
+            events.push_back(std::move(current._event));
+        }
+        _taken.clear();
+
+        // forget the receive order of the USNs without events within the horizon
+        _expired_orders.clear();
+        _order_wheel.advance(now_tick, _expired_orders);
+        for (auto entry : _expired_orders)
+        {
+            _order_index.erase(_last_received[entry]._usn);
+            _last_received[entry] = LastReceived();
+            _free_orders.push_back(entry);
+        }
+        return errors.empty();
+    }
+
+    void addStatistics(ReceiveStatistics& statistics) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const auto& worker : _workers)
+        {
+            addReceiveStatistics(statistics, worker->_statistics);
+        }
+        statistics._stale_events += _stale_events;
+    }
+
+private:
+    struct Received
+    {
+        Event                                 _event;
+        std::chrono::system_clock::time_point _received;
+    };
+
+    struct LastReceived
+    {
+        std::string                           _usn;
+        std::chrono::system_clock::time_point _received;
+    };
+
+    uint64_t getTick(std::chrono::steady_clock::time_point now) const
+    {
+        if (now <= _start)
+        {
+            return 0;
+        }
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(now - _start).count());
+    }
+
+    uint32_t allocateOrder(const std::string& usn)
+    {
+        uint32_t entry;
+        if (!_free_orders.empty())
+        {
+            entry = _free_orders.back();
+            _free_orders.pop_back();
+        }
+        else
+        {
+            _last_received.emplace_back();
+            entry = static_cast<uint32_t>(_last_received.size() - 1);
+        }
+        _last_received[entry]._usn = usn;
+        return entry;
+    }
+
+    struct Worker
+    {
+        NonBlockingMulticastSocket _socket;
+        ReceiveStatistics          _statistics;
+        std::thread                _thread;
+    };
+
+    void stopWorkers()
+    {
+        uint64_t value = 1;
+        if (write(_stop, &value, sizeof(value)) != sizeof(value))
+        {
+            LSSDP_LOG_DEBUG_MESSAGE("stopping the receive workers failed");
+        }
+        for (auto& worker : _workers)
+        {
+            if (worker->_thread.joinable())
+            {
+                worker->_thread.join();
+            }
+        }
+        _workers.clear();
+        closeEvents();
+    }
+
+    static void addReceiveStatistics(ReceiveStatistics& statistics, const ReceiveStatistics& to_add)
+    {
+        statistics._datagrams_received += to_add._datagrams_received;
+        statistics._invalid_datagrams += to_add._invalid_datagrams;
+        statistics._batches += to_add._batches;
+        if (statistics._batch_sizes.size() < to_add._batch_sizes.size())
+        {
+            statistics._batch_sizes.resize(to_add._batch_sizes.size(), 0);
+        }
+        for (size_t index = 0; index < to_add._batch_sizes.size(); ++index)
+        {
+            statistics._batch_sizes[index] += to_add._batch_sizes[index];
+        }
+        if (statistics._interface_datagrams.size() < to_add._interface_datagrams.size())
+        {
+            statistics._interface_datagrams.resize(to_add._interface_datagrams.size(), 0);
+        }
+        for (size_t index = 0; index < to_add._interface_datagrams.size(); ++index)
+        {
+            statistics._interface_datagrams[index] += to_add._interface_datagrams[index];
+        }
+        statistics._io_uring = statistics._io_uring || to_add._io_uring;
+        statistics._stale_events += to_add._stale_events;
+    }
+
+    void run(Worker* worker, size_t batch_size)
+    {
+        std::vector<LSSDPPacket> packets;
+        std::vector<Received> received;
+        ReceiveStatistics batch_statistics;
+        struct pollfd poll_fds[2];
+        while (true)
+        {
+            poll_fds[0].fd = worker->_socket.getPollSocket();
+            poll_fds[0].events = POLLIN;
+            poll_fds[0].revents = 0;
+            poll_fds[1].fd = _stop;
+            poll_fds[1].events = POLLIN;
+            poll_fds[1].revents = 0;
+            if (poll(poll_fds, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                addError(std::string("poll of receive worker failed, errno = ") + getErrorAsString());
+                return;
+            }
+            if (poll_fds[1].revents != 0)
+            {
+                return;
+            }
+            if (poll_fds[0].revents == 0)
+            {
+                continue;
+            }
+
+            // receive and parse without the lock
+            try
+            {
+                worker->_socket.receivePackets(packets, batch_size, batch_statistics);
+            }
+            catch (const std::exception& ex)
+            {
+                addError(std::string("receive worker stopped: ") + ex.what());
+                return;
+            }
+            received.clear();
+            for (const auto& packet : packets)
+            {
+                Received current;
+                if (_create_event(packet, current._event))
+                {
+                    // the receive buffer is reused by the next batch, the queued event owns its header lines
+                    current._event._headers = MessageHeaders(current._event._headers);
+                    current._received = packet._update_time;
+                    received.push_back(std::move(current));
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                addReceiveStatistics(worker->_statistics, batch_statistics);
+                for (auto& current : received)
+                {
+                    _queued.push_back(std::move(current));
+                }
+            }
+            batch_statistics = ReceiveStatistics();
+            if (!received.empty())
+            {
+                notifyReady();
+            }
+        }
     }
 
-    void openSocket()
+    void addError(const std::string& error)
     {
-        _multicast_socket.open(_address, _port);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _errors += error;
+        }
+        notifyReady();
     }
 
-    void closeSocket()
+    void notifyReady()
     {
-        _multicast_socket.close();
+        uint64_t ready = 1;
+        if (write(_ready, &ready, sizeof(ready)) != sizeof(ready))
+        {
+            LSSDP_LOG_DEBUG_MESSAGE("notify of the receive workers failed");
+        }
     }
 
-    void updateNetworkInterfaces()
+    void closeEvents()
     {
-        bool updated = ::lssdp::updateNetworkInterfaces(_network_interfaces);
-        if (updated)
+        if (_stop >= 0)
         {
-            closeSocket();
-            openSocket();
+            ::close(_stop);
+            _stop = -1;
+        }
+        if (_ready >= 0)
+        {
+            ::close(_ready);
+            _ready = -1;
         }
     }
 
-    enum MessageType
+    EventFactory                          _create_event;
+    int                                   _stop = -1;
+    int                                   _ready = -1;
+    std::vector<std::unique_ptr<Worker>>  _workers;
+
+    // guarded by _mutex, filled by the workers
+    mutable std::mutex                    _mutex;
+    std::vector<Received>                 _queued;
+    std::string                           _errors;
+
+    // used by the merging thread only
+    std::vector<Received>                 _taken;
+    // the last receive time of each USN, it expires on the wheel (1 second ticks) after the horizon
+    std::chrono::steady_clock::time_point     _start;
+    TimingWheel                               _order_wheel;
+    std::unordered_map<std::string, uint32_t> _order_index;
+    std::vector<LastReceived>                 _last_received;
+    std::vector<uint32_t>                     _free_orders;
+    std::vector<uint32_t>                     _expired_orders;
+    uint64_t                              _stale_events = 0;
+};
+#endif //LSSDP_USE_RECEIVE_WORKERS
+
+/*****************************************************************************************/
+/**
+ * the services a ServiceFinder discovered by USN, each entry expires on a TimingWheel
+ * with 1 second ticks after the max-age of its last announcement.
+ * The last seen state of a service is a 64 bit hash of its LOCATION, ST, SM_ID and DEV_TYPE,
+ * the description is only kept for getServices (setKeepDescriptions). A change whose fields
+ * hash like the last seen ones is taken for a repetition (FNV-1a, a chance of about 2^-64).
+ */
+class ServiceCache
+{
+public:
+    ServiceCache() : _start(std::chrono::steady_clock::now())
     {
-        alive,
-        byebye
-    };
+    }
 
-    bool sendNotify(MessageType m_type)
+    void clear()
     {
-        bool error_occured = false;
-        updateNetworkInterfaces();
-        const char* message_to_send = _notify_alive_message.c_str();
-        if (m_type == byebye)
+        _wheel.clear();
+        _index.clear();
+        _entries.clear();
+        _descriptions.clear();
+        _free.clear();
+    }
+
+    /**
+     * @p keep true keeps the description of each service for getServices,
+     * false keeps the hash of its fields only
+     */
+    void setKeepDescriptions(bool keep)
+    {
+        _keep_descriptions = keep;
+        _descriptions.clear();
+        if (_keep_descriptions)
         {
-            message_to_send = _notify_byebye_message.c_str();
+            _descriptions.resize(_entries.size());
         }
-        for (const auto& current_interface : _network_interfaces)
+        for (auto& entry : _entries)
+        {
+            // described again by its next announcement
+            entry._described = false;
+        }
+    }
+
+    /**
+     * records an alive or response event, a byebye removes the service
+     * @retval true the service is new, its LOCATION, ST, SM_ID or DEV_TYPE changed or it left
+     * @retval false a repetition of the last announcement or byebye
+     */
+    bool update(const ServiceFinder::ServiceUpdateEvent& event, std::chrono::steady_clock::time_point now)
+    {
+        std::string usn = event._service_description.getUniqueServiceName();
+        if (event._event_id == ServiceFinder::ServiceUpdateEvent::notify_byebye)
         {
-            if (!LSSDP_SEND_TO_LOCALHOST)
+            uint32_t entry;
+            auto found = _index.find(usn);
+            if (found != _index.end())
             {
-                if (current_interface.getIp4() == LSSDP_ADDR_LOCALHOST)
+                entry = found->second;
+                if (_entries[entry]._left)
                 {
-                    continue;
+                    // left already (the byebye arrives on each interface)
+                    return false;
                 }
             }
-            try
+            else
             {
-                _multicast_socket.sendDataTo(message_to_send,
-                    current_interface.getAddrIp4(),
-                    _port);
+                // not seen before, informed once as well
+                entry = add(std::move(usn));
             }
-            catch (std::runtime_error& ex)
+            _entries[entry]._left = true;
+            _entries[entry]._described = false;
+            if (_keep_descriptions)
             {
-                error_occured = true;
-                _send_errors[current_interface.getIp4()] = ex.what();
+                _descriptions[entry] = ServiceDescription();
             }
+            // forgotten when the copies of the other interfaces are through
+            _wheel.schedule(entry, getTick(now) + static_cast<uint64_t>(LSSDP_BYEBYE_HORIZON.count()) + 1);
+            return true;
         }
-        return (!error_occured);
-    }
-
-    bool sendResponse(uint32_t address_to)
-    {
-        bool error_occured = false;
-        bool found = false;
-        std::string found_address;
-        // 1. find the interface which is in LAN
-        for (const auto& intf : _network_interfaces)
+        if (event._event_id != ServiceFinder::ServiceUpdateEvent::notify_alive
+            && event._event_id != ServiceFinder::ServiceUpdateEvent::response)
         {
-            if ((intf.getAddrIp4() & intf.getAddrNetMaskIp4())
-                == (address_to & intf.getAddrNetMaskIp4()))
-            {
-                found = true;
-                found_address = intf.getIp4();
-            }
+            return true;
         }
 
-        if (!found)
+        uint32_t entry;
+        bool changed = true;
+        uint64_t fields_hash = hashFields(event._service_description);
+        auto found = _index.find(usn);
+        if (found != _index.end())
         {
-            return true;
+            entry = found->second;
+            changed = (_entries[entry]._left || _entries[entry]._fields_hash != fields_hash);
         }
-
-        try
+        else
         {
-            _multicast_socket.sendDataTo(_response_message.c_str(),
-                address_to,
-                _port);
+            entry = add(std::move(usn));
         }
-        catch (std::runtime_error& ex)
+        Entry& current = _entries[entry];
+        current._fields_hash = fields_hash;
+        current._left = false;
+        if (_keep_descriptions && (changed || !current._described))
         {
-            error_occured = true;
-            _send_errors[found_address] = ex.what();
+            _descriptions[entry] = event._service_description;
+            current._described = true;
         }
-        LSSDP_LOG_DEBUG_MESSAGE(std::string("send response: ") + response_message_generic);
-        return (!error_occured);
+        auto max_age = (event._max_age.count() > 0) ? event._max_age : LSSDP_DEFAULT_MAX_AGE;
+        // the tick rounds down, one more never expires early
+        _wheel.schedule(entry, getTick(now) + static_cast<uint64_t>(max_age.count()) + 1);
+        return changed;
     }
 
-    std::string getSendErrors()
+    /**
+     * removes the services whose max-age passed until @p now and appends an
+     * expired event for each to @p events, without the kept description it has the USN only
+     */
+    void expire(std::chrono::steady_clock::time_point now,
+                std::vector<ServiceFinder::ServiceUpdateEvent>& events)
     {
-        std::string created_message;
-        for (const auto& current : _send_errors)
+        _expired.clear();
+        _wheel.advance(getTick(now), _expired);
+        for (auto entry : _expired)
         {
-            created_message += current.second;
+            Entry& current = _entries[entry];
+            if (!current._left)
+            {
+                ServiceFinder::ServiceUpdateEvent event;
+                event._event_id = ServiceFinder::ServiceUpdateEvent::expired;
+                if (current._described)
+                {
+                    event._service_description = std::move(_descriptions[entry]);
+                }
+                else
+                {
+                    event._service_description = ServiceDescription(std::string(), *current._usn,
+                                                                    std::string(), std::string(), std::string());
+                }
+                events.push_back(std::move(event));
+            }
+            release(entry);
         }
-        _send_errors.clear();
-        return created_message;
     }
-    
-
-private:
-    friend class Service;
-
-    uint16_t _port = 0;
-    uint32_t _address = 0;
-
-    std::string _dicover_url;
-
-    std::string _notify_alive_message;
-    std::string _notify_byebye_message;
-    std::string _response_message;
-   
-
-    std::vector<NetworkInterface>   _network_interfaces;
-    NonBlockingMulticastSocket      _multicast_socket;
-    std::map<std::string, std::string> _send_errors;
-
-};
 
-/*****************************************************************************************/
-Service::Service(std::string discover_url,
-                 std::chrono::seconds max_age,
-                 std::string location_url,
-                 std::string unique_service_name,
-                 std::string search_target,
-                 std::string product_name,
-                 std::string product_version,
-                 std::string sm_id ,
-                 std::string device_type) :
-    _impl(std::make_unique<Impl>(discover_url,
-        max_age,
-        location_url,
-        unique_service_name,
-        search_target,
-        product_name,
-        product_version,
-        sm_id,
-        device_type
-        ))
-{
-}
+    std::chrono::steady_clock::time_point getNextTimeout() const
+    {
+        uint64_t tick = _wheel.getNextTick();
+        if (tick == std::numeric_limits<uint64_t>::max())
+        {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        return _start + std::chrono::seconds(tick);
+    }
 
-Service::~Service()
-{
-}
+    void getServices(std::vector<ServiceDescription>& services) const
+    {
+        services.clear();
+        services.reserve(_index.size());
+        for (const auto& current : _index)
+        {
+            if (_entries[current.second]._described)
+            {
+                services.push_back(_descriptions[current.second]);
+            }
+        }
+    }
 
-bool Service::sendNotifyAlive()
-{
-    return _impl->sendNotify(Impl::alive);
-}
+private:
+    struct Entry
+    {
+        uint64_t           _fields_hash = 0;
+        // the key of the entry in the index
+        const std::string* _usn = nullptr;
+        // the byebye was informed, its copies are not
+        bool               _left = false;
+        // the description of the last change is kept
+        bool               _described = false;
+    };
 
-bool Service::sendNotifyByeBye()
-{
-    return _impl->sendNotify(Impl::byebye);
-}
+    // FNV-1a of the fields a repeated announcement must not change
+    static uint64_t hashFields(const ServiceDescription& description)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        auto add = [&hash](const std::string& field)
+        {
+            for (char current : field)
+            {
+                hash = (hash ^ static_cast<unsigned char>(current)) * 1099511628211ULL;
+            }
+            // separator, "ab" + "c" differs from "a" + "bc"
+            hash = (hash ^ 0xFFu) * 1099511628211ULL;
+        };
+        add(description.getLocationURL());
+        add(description.getSearchTarget());
+        add(description.getSMID());
+        add(description.getDeviceType());
+        return hash;
+    }
 
-bool Service::checkForMSearchAndSendResponse(std::chrono::milliseconds timeout)
-{
-    fd_set fs;
-    FD_ZERO(&fs);
-    FD_SET(_impl->_multicast_socket._socket, &fs);
-    struct timeval tv;
-    memset(&tv, 0, sizeof(tv));
-
-    auto begin_time = std::chrono::system_clock::now();
-    bool return_value = true;
-    bool go_ahead = true;
-    bool error_while_sending = false;
-
-    do
-    {
-        #ifdef WIN32
-        int used_socket_in_select = 0;
-        #else
-        int used_socket_in_select = _impl->_multicast_socket._socket + 1;
-        #endif
-        tv.tv_usec = 100 * 1000;   // 100 ms
-        int ret = select(used_socket_in_select, &fs, NULL, NULL, &tv);
-        if (ret < 0)
+    uint64_t getTick(std::chrono::steady_clock::time_point now) const
+    {
+        if (now <= _start)
         {
-            std::string error_msg = std::string("select on ") + _impl->_dicover_url
-                + " failed, errno = "
-                + getErrorAsString();
-            _impl->_send_errors[_impl->_dicover_url] = error_msg;
-            go_ahead = false;
-            return_value = false;
+            return 0;
         }
-        else if (ret == 0)
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(now - _start).count());
+    }
+
+    uint32_t add(std::string usn)
+    {
+        uint32_t entry;
+        if (!_free.empty())
         {
-            FD_SET(_impl->_multicast_socket._socket, &fs);
-            //we check for the overall timeout at the and of the loop
-            go_ahead = true;
+            entry = _free.back();
+            _free.pop_back();
         }
         else
         {
-            std::pair<bool, LSSDPPacket> packet = _impl->_multicast_socket.receivePacket();
-            if (packet.first)
+            entry = static_cast<uint32_t>(_entries.size());
+            _entries.emplace_back();
+            if (_keep_descriptions)
             {
-                if (strcmp(packet.second._method, LSSDP_MSEARCH) == 0)
-                {
-                    if (strcmp(packet.second._st, LSSDP_SEARCH_TARGET_ALL) == 0
-                        || strcmp(packet.second._st, _impl->getSearchTarget().c_str()) == 0)
-                    {
-                        if (!_impl->sendResponse(packet.second._received_from))
-                        {
-                            error_while_sending = true;
-                        }
-                    }
-                }
+                _descriptions.emplace_back();
             }
         }
+        _entries[entry] = Entry();
+        // the keys of an unordered_map stay in place on rehash
+        _entries[entry]._usn = &_index.emplace(std::move(usn), entry).first->first;
+        return entry;
+    }
 
-        //timeout check
-        if ((std::chrono::system_clock::now() - begin_time) >= timeout)
+    void release(uint32_t entry)
+    {
+        _wheel.cancel(entry);
+        if (_keep_descriptions)
         {
-            go_ahead = false;
+            _descriptions[entry] = ServiceDescription();
         }
+        // by the iterator, the key is the one of the erased element
+        _index.erase(_index.find(*_entries[entry]._usn));
+        _entries[entry] = Entry();
+        _free.push_back(entry);
+    }
 
-    } while (go_ahead);
-    return (return_value && !error_while_sending);
-}
-
-bool Service::operator==(const ServiceDescription& other) const
-{
-    return (other == *_impl.get());
-}
-
-ServiceDescription Service::getServiceDescription() const
-{
-    return *_impl;
-}
-
-std::string Service::getLastSendErrors() const
-{
-    return _impl->getSendErrors();
-}
-
-
-
+    std::chrono::steady_clock::time_point     _start;
+    TimingWheel                               _wheel;
+    std::unordered_map<std::string, uint32_t> _index;
+    std::vector<Entry>                        _entries;
+    // only with setKeepDescriptions
+    bool                                      _keep_descriptions = false;
+    std::vector<ServiceDescription>           _descriptions;
+    std::vector<uint32_t>                     _free;
+    std::vector<uint32_t>                     _expired;
+};
 
 /*****************************************************************************************/
-class ServiceFinder::Impl
+class ServiceFinder::Impl : public PollSource
 {
 public:
     Impl() = delete;
     virtual ~Impl()
     {
         closeSocket();
+        _send_sockets.clear();
     }
     
     Impl(const Impl& other)
@@ -1392,74 +5261,316 @@ public:
         _port = other._port;
     }
 
-    Impl(const std::string& discover_url,
-         const std::string& product_name,
-         const std::string& product_version,
-         const std::string& search_target,
-         const std::string& device_type_filter)
-        : _discover_url(discover_url),
-          _search_target(search_target),
-          _device_type_filter(device_type_filter),
-          _rcv_packetes_from_myself(true),
-          _send_to_localhost(true)
+    Impl(const std::string& discover_url,
+         const std::string& product_name,
+         const std::string& product_version,
+         const std::string& search_target,
+         const std::string& device_type_filter)
+        : _discover_url(discover_url),
+          _search_target(search_target),
+          _device_type_filter(device_type_filter),
+          _rcv_packetes_from_myself(true),
+          _send_to_localhost(true)
+    {
+         cxxurl::Url url(discover_url);
+
+         _port = static_cast<uint16_t>(std::stoi(url.port()));
+
+         //very important !! this must be an IP address ... we check that
+         if (url.ip_version() != 4)
+         {
+             throw std::runtime_error("The given url " + discover_url + " does not contain a IPv4 multicast address for host");
+         }
+         _address = inet_addr(url.host().c_str());
+         
+         //set to ssdp:all 
+         if (_search_target.empty())
+         {
+             _search_target = LSSDP_SEARCH_TARGET_ALL;
+         }
+
+         //preparing the message to prevent string memory allocation on each request m-search requaest
+         _m_search_message.add(LSSDP_HEADER_MSEARCH)
+                          .addHeader("HOST:", url.host() + ":" + url.port())
+                          .add("MAN:\"ssdp:discover\"\r\n")
+                          .add("MX:5\r\n")
+                          .addHeader("ST:", _search_target)
+                          .addHeader("USER-AGENT:", OSVersion::getOsVersion().getName() + "/" + OSVersion::getOsVersion().getVersion()
+                                                    + " " + product_name + "/" + product_version)
+                          .add("\r\n");
+
+         //open the socket NOW for the M SEARCH AND NOTIFY Messages 
+         _interface_watcher.update(_network_interfaces, _added_interfaces, _removed_interfaces);
+         _send_sockets.update(_added_interfaces, _removed_interfaces);
+         //the M-SEARCH leaves from the unicast sockets, they live as long as we do (or their interface)
+         updateUnicastSockets(_added_interfaces, _removed_interfaces);
+         //open socket
+         openSocket();
+         _poller.add(this);
+    }
+
+    void openSocket()
+    {
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+        if (_receive_worker_count > 1)
+        {
+            _receive_workers.reset(new ReceiveWorkers(_address,
+                                                      _port,
+                                                      _receive_worker_count,
+                                                      _receive_batch_size,
+                                                      _receive_worker_cpus,
+                                                      [this](const LSSDPPacket& packet, ServiceUpdateEvent& event) {
+                                                          return createEvent(packet, event);
+                                                      }));
+            _receive_workers->updateMemberships(_network_interfaces, std::vector<NetworkInterface>(), _send_errors);
+            ++_sockets_version;
+            return;
+        }
+#endif
+        _multicast_socket.open(_address, _port);
+        _multicast_socket.updateMemberships(_network_interfaces, std::vector<NetworkInterface>(), _send_errors);
+        ++_sockets_version;
+    }
+
+    bool setReceiveWorkers(size_t workers, const std::vector<unsigned int>& cpus)
+    {
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+        size_t previous_count = _receive_worker_count;
+        std::vector<unsigned int> previous_cpus = _receive_worker_cpus;
+        closeSocket();
+        _receive_worker_count = (workers == 0) ? 1 : workers;
+        _receive_worker_cpus = cpus;
+        try
+        {
+            openSocket();
+        }
+        catch (...)
+        {
+            // the finder keeps receiving in its previous mode, the caller gets the error
+            closeSocket();
+            _receive_worker_count = previous_count;
+            _receive_worker_cpus.swap(previous_cpus);
+            openSocket();
+            throw;
+        }
+        return true;
+#else
+        (void)cpus;
+        return (workers <= 1);
+#endif
+    }
+
+    uint64_t getSocketsVersion() const override
+    {
+        return _sockets_version;
+    }
+
+    void getSockets(std::vector<SOCKET_TYPE>& sockets) const override
+    {
+        sockets.clear();
+        for (const auto& current : _unicast_sockets)
+        {
+            sockets.push_back(current.second->getPollSocket());
+        }
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+        if (_receive_workers)
+        {
+            sockets.push_back(_receive_workers->getFd());
+            return;
+        }
+#endif
+        if (_multicast_socket._socket > 0)
+        {
+            sockets.push_back(_multicast_socket.getPollSocket());
+        }
+    }
+
+    void setUpdateCallback(const std::function<void(const ServiceUpdateEvent&)>* update_callback)
+    {
+        _update_callback = update_callback;
+    }
+
+    bool onReadable(SOCKET_TYPE socket) override
+    {
+        for (auto& current : _unicast_sockets)
+        {
+            if (socket == current.second->getPollSocket())
+            {
+                // the responses to our M-SEARCH
+                current.second->receivePackets(_received_packets,
+                                               _receive_batch_size,
+                                               _statistics._unicast_receive);
+                for (const auto& packet : _received_packets)
+                {
+                    handlePacket(packet);
+                }
+                return true;
+            }
+        }
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+        if (_receive_workers)
+        {
+            // the workers received and parsed already, we only deliver
+            std::string errors;
+            bool workers_ok = _receive_workers->takeEvents(_merged_events, errors);
+            for (const auto& event : _merged_events)
+            {
+                deliver(event);
+            }
+            if (!workers_ok)
+            {
+                _send_errors[_discover_url] = errors;
+            }
+            return workers_ok;
+        }
+#endif
+        _multicast_socket.receivePackets(_received_packets,
+                                         _receive_batch_size,
+                                         _statistics._receive);
+        for (const auto& packet : _received_packets)
+        {
+            handlePacket(packet);
+        }
+        return true;
+    }
+
+    std::chrono::steady_clock::time_point getNextTimeout() const override
     {
-         cxxurl::Url url(discover_url);
-
-         _port = static_cast<uint16_t>(std::stoi(url.port()));
+        if (!isServiceCacheActive())
+        {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        return _service_cache.getNextTimeout();
+    }
 
-         //very important !! this must be an IP address ... we check that
-         if (url.ip_version() != 4)
-         {
-             throw std::runtime_error("The given url " + discover_url + " does not contain a IPv4 multicast address for host");
-         }
-         _address = inet_addr(url.host().c_str());
-         
-         //set to ssdp:all 
-         if (_search_target.empty())
-         {
-             _search_target = LSSDP_SEARCH_TARGET_ALL;
-         }
+    bool onTimeout(std::chrono::steady_clock::time_point now) override
+    {
+        _expired_events.clear();
+        _service_cache.expire(now, _expired_events);
+        for (const auto& event : _expired_events)
+        {
+            (*_update_callback)(event);
+        }
+        return true;
+    }
 
-         //preparing the message to prevent string memory allocation on each request m-search requaest
-         _m_search_message =
-             std::string(LSSDP_HEADER_MSEARCH)
-             + "HOST:" + url.host() + ":" + url.port() + "\r\n"
-             + "MAN:\"ssdp:discover\"\r\n"
-             + "MX:5\r\n"
-             + "ST:" + _search_target + "\r\n"
-             + "USER-AGENT:" + OSVersion::getOsVersion().getName() + "/" + OSVersion::getOsVersion().getVersion()
-                             + " " + product_name + "/" + product_version + "\r\n"
-             + std::string("\r\n");
+    void setServiceCache(bool enabled)
+    {
+        _service_cache_enabled = enabled;
+        // the delta events only need the hashes
+        _service_cache.setKeepDescriptions(enabled);
+        if (!isServiceCacheActive())
+        {
+            _service_cache.clear();
+        }
+    }
 
-         //open the socket NOW for the M SEARCH AND NOTIFY Messages 
-         ::lssdp::updateNetworkInterfaces(_network_interfaces);
-         //open socket
-         openSocket();
+    void setDeltaEvents(bool enabled)
+    {
+        _delta_events = enabled;
+        if (!isServiceCacheActive())
+        {
+            _service_cache.clear();
+        }
     }
 
-    void openSocket()
+    // the delta events need the cache as their last seen state
+    bool isServiceCacheActive() const
     {
-        _multicast_socket.open(_address, _port);
+        return _service_cache_enabled || _delta_events;
     }
 
     void closeSocket()
     {
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+        if (_receive_workers)
+        {
+            // keep the counters of the workers
+            _receive_workers->addStatistics(_statistics._receive);
+            _receive_workers.reset();
+        }
+#endif
         _multicast_socket.close();
     }
 
     void updateNetworkInterfaces()
     {
-        bool updated = ::lssdp::updateNetworkInterfaces(_network_interfaces);
+        bool updated = _interface_watcher.update(_network_interfaces, _added_interfaces, _removed_interfaces);
         if (updated)
         {
-            closeSocket();
-            openSocket();
+            // the queued datagrams are for the old interfaces
+            flush();
+            // the sockets stay bound, no datagram queued in the kernel gets lost
+            _send_sockets.update(_added_interfaces, _removed_interfaces);
+            updateUnicastSockets(_added_interfaces, _removed_interfaces);
+            updateMemberships(_added_interfaces, _removed_interfaces);
         }
     }
 
-    bool sendMSearch()
+    /**
+     * with sendmmsg one unicast socket sends the M-SEARCH for all interfaces (IP_PKTINFO picks
+     * the interface of each datagram), otherwise each interface has its own with IP_MULTICAST_IF
+     * set once when it is opened: opens those of the @p added and closes those of the @p removed ones
+     */
+    void updateUnicastSockets(const std::vector<NetworkInterface>& added,
+                              const std::vector<NetworkInterface>& removed)
+    {
+#ifdef LSSDP_USE_SENDMMSG
+        (void)added;
+        (void)removed;
+        if (_unicast_sockets.empty())
+        {
+            openUnicastSocket(htonl(INADDR_ANY));
+            ++_sockets_version;
+        }
+#else
+        for (const auto& current : removed)
+        {
+            _send_sockets.setSource(current.getAddrIp4(), 0);
+            _unicast_sockets.erase(current.getAddrIp4());
+        }
+        for (const auto& current : added)
+        {
+            try
+            {
+                openUnicastSocket(current.getAddrIp4());
+            }
+            catch (const std::exception& ex)
+            {
+                // the M-SEARCH of this interface leaves from its send socket
+                _send_errors[current.getIp4()] = ex.what();
+            }
+        }
+        ++_sockets_version;
+#endif
+    }
+
+    void openUnicastSocket(uint32_t interface_address)
+    {
+        std::unique_ptr<NonBlockingMulticastSocket> unicast_socket(new NonBlockingMulticastSocket());
+        unicast_socket->openUnicast(interface_address);
+        _send_sockets.setSource(interface_address, unicast_socket->_socket);
+        _unicast_sockets[interface_address] = std::move(unicast_socket);
+    }
+
+    void updateMemberships(const std::vector<NetworkInterface>& added,
+                           const std::vector<NetworkInterface>& removed)
+    {
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+        if (_receive_workers)
+        {
+            _receive_workers->updateMemberships(added, removed, _send_errors);
+            return;
+        }
+#endif
+        _multicast_socket.updateMemberships(added, removed, _send_errors);
+    }
+
+    /**
+     * queues the M-SEARCH for all interfaces, it is sent with the next flush
+     */
+    void queueMSearch()
     {
-        bool error_occured = false;
         updateNetworkInterfaces();
         for (const auto& current_interface : _network_interfaces)
         {
@@ -1470,19 +5581,115 @@ public:
                     continue;
                 }
             }
-            try
+            _pending_datagrams.emplace_back(current_interface.getAddrIp4(), _address, _port, &_statistics._msearch);
+            auto& datagram = _pending_datagrams.back();
+            _m_search_message.fill(nullptr, datagram._segments, datagram._segment_count);
+        }
+    }
+
+    bool sendMSearch()
+    {
+        queueMSearch();
+        return flush();
+    }
+
+    /**
+     * sends all queued datagrams as one batch
+     */
+    bool flush()
+    {
+        if (_pending_datagrams.empty())
+        {
+            return true;
+        }
+        bool sent = _send_sockets.sendBatch(_pending_datagrams.data(),
+                                            _pending_datagrams.size(),
+                                            _send_errors);
+        _pending_datagrams.clear();
+        return sent;
+    }
+
+    void handlePacket(const LSSDPPacket& packet)
+    {
+        ServiceUpdateEvent event;
+        if (createEvent(packet, event))
+        {
+            deliver(event);
+        }
+    }
+
+    void deliver(const ServiceUpdateEvent& event)
+    {
+        if (isServiceCacheActive())
+        {
+            bool changed = _service_cache.update(event, std::chrono::steady_clock::now());
+            if (!changed && _delta_events)
             {
-                _multicast_socket.sendDataTo(_m_search_message.c_str(),
-                    current_interface.getAddrIp4(),
-                    _port);
+                ++_statistics._suppressed_events;
+                return;
             }
-            catch (const std::runtime_error& ex)
+        }
+        (*_update_callback)(event);
+    }
+
+    /**
+     * applies the filters and creates the event of @p packet,
+     * called by the receive workers concurrently (only reads the filters)
+     * @retval false the packet is not of interest
+     */
+    bool createEvent(const LSSDPPacket& packet, ServiceUpdateEvent& event) const
+    {
+        if (!_device_type_filter.empty())
+        {
+            if (packet._device_type != _device_type_filter)
             {
-                error_occured = true;
-                _send_errors[current_interface.getIp4()] = ex.what();
+                //its not out device looking for
+                return false;
             }
         }
-        return (!error_occured);
+        if (!_search_target.empty())
+        {
+            bool matches = (packet._method == LSSDPPacket::response)
+                               ? matchesResponseSearchTarget(_search_target, packet._st)
+                               : matchesSearchTarget(_search_target, packet._st, packet._usn);
+            if (!matches)
+            {
+                //its not our target looking for
+                return false;
+            }
+        }
+        if (packet._method == LSSDPPacket::notify)
+        {
+            event._event_id = ServiceUpdateEvent::notify_alive;
+            if (packet._nts == LSSDP_NOTIFY_NTS_ALIVE)
+            {
+                event._event_id = ServiceUpdateEvent::notify_alive;
+            }
+            else if (packet._nts == LSSDP_NOTIFY_NTS_BYEBYE)
+            {
+                event._event_id = ServiceUpdateEvent::notify_byebye;
+            }
+        }
+        else if (packet._method == LSSDPPacket::response)
+        {
+            event._event_id = ServiceUpdateEvent::response;
+        }
+        else
+        {
+            return false;
+        }
+        // the only copy of the fields, out of the receive buffer
+        event._service_description = ServiceDescription(packet._location.str(),
+            packet._usn.str(),
+            packet._st.str(),
+            "",
+            "",
+            packet._sm_id.str(),
+            packet._device_type.str());
+        event._max_age = std::chrono::seconds(packet._max_age);
+        // refers to the receive buffer, only a copy of the event copies the header lines
+        event._headers = packet.getHeaders();
+        return true;
     }
 
     std::string getSendErrors() 
@@ -1508,12 +5715,35 @@ private:
     std::string _search_target;
     std::string _device_type_filter;
 
-    std::string _m_search_message;
+    MessageTemplate _m_search_message;
 
     std::vector<NetworkInterface>   _network_interfaces;
+    NetworkInterfaceWatcher         _interface_watcher;
+    std::vector<NetworkInterface>   _added_interfaces;
+    std::vector<NetworkInterface>   _removed_interfaces;
     NonBlockingMulticastSocket      _multicast_socket;
+    std::map<uint32_t, std::unique_ptr<NonBlockingMulticastSocket>> _unicast_sockets;
+    uint64_t                        _sockets_version = 0;
+    SendSocketTable                 _send_sockets;
+    std::vector<SendSocketTable::Datagram> _pending_datagrams;
+    std::vector<LSSDPPacket>        _received_packets;
+    size_t                          _receive_batch_size = LSSDP_DEFAULT_RECEIVE_BATCH;
+    size_t                          _receive_worker_count = 1;
+    std::vector<unsigned int>       _receive_worker_cpus;
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+    std::unique_ptr<ReceiveWorkers> _receive_workers;
+    std::vector<ServiceUpdateEvent> _merged_events;
+#endif
+    Poller                          _poller;
+    // set by checkForServices or the Reactor before the sockets are polled
+    const std::function<void(const ServiceUpdateEvent&)>* _update_callback = nullptr;
+    bool                            _service_cache_enabled = false;
+    bool                            _delta_events = false;
+    ServiceCache                    _service_cache;
+    std::vector<ServiceUpdateEvent> _expired_events;
 
     std::map<std::string, std::string> _send_errors;
+    Statistics                      _statistics;
 };
 
 ServiceFinder::~ServiceFinder()
@@ -1543,6 +5773,16 @@ bool ServiceFinder::sendMSearch()
     return _impl->sendMSearch();
 }
 
+void ServiceFinder::queueMSearch()
+{
+    _impl->queueMSearch();
+}
+
+bool ServiceFinder::flush()
+{
+    return _impl->flush();
+}
+
 void ServiceFinder::checkNetworkChanges()
 {
     _impl->updateNetworkInterfaces();
@@ -1551,114 +5791,203 @@ void ServiceFinder::checkNetworkChanges()
 bool ServiceFinder::checkForServices(const std::function<void(const ServiceUpdateEvent& update_service)>& update_callback,
                                      std::chrono::milliseconds timeout)
 {
-    fd_set fs;
-    FD_ZERO(&fs);
-    FD_SET(_impl->_multicast_socket._socket, &fs);
-    struct timeval tv;
-    memset(&tv, 0, sizeof(tv));
-
-    auto begin_time = std::chrono::system_clock::now();
-    bool return_value = true;
-    bool go_ahead = true;
-    do
-    {
-        #ifdef WIN32
-        int used_socket_in_select = 0;
-        #else
-        int used_socket_in_select = _impl->_multicast_socket._socket + 1;
-        #endif
-        tv.tv_usec = 100 * 1000;   // 100 ms
-        int ret = select(used_socket_in_select, &fs, NULL, NULL, &tv);
-        if (ret < 0)
+    _impl->setUpdateCallback(&update_callback);
+    std::string error_msg;
+    bool return_value = _impl->_poller.waitUntil(std::chrono::steady_clock::now() + timeout, error_msg);
+    if (!error_msg.empty())
+    {
+        _impl->_send_errors[_impl->_discover_url] = std::string("wait on ") + _impl->_discover_url
+            + " failed: " + error_msg;
+    }
+    return return_value;
+}
+
+void ServiceFinder::setReceiveBatchSize(size_t max_datagrams)
+{
+    _impl->_receive_batch_size = (max_datagrams == 0) ? 1 : max_datagrams;
+}
+
+bool ServiceFinder::setReceiveWorkers(size_t workers, const std::vector<unsigned int>& cpus)
+{
+    return _impl->setReceiveWorkers(workers, cpus);
+}
+
+void ServiceFinder::setServiceCache(bool enabled)
+{
+    _impl->setServiceCache(enabled);
+}
+
+void ServiceFinder::setDeltaEvents(bool enabled)
+{
+    _impl->setDeltaEvents(enabled);
+}
+
+std::vector<ServiceDescription> ServiceFinder::getServices() const
+{
+    std::vector<ServiceDescription> services;
+    _impl->_service_cache.getServices(services);
+    return services;
+}
+
+std::string ServiceFinder::getLastSendErrors() const 
+{
+    return _impl->getSendErrors();
+}
+
+Statistics ServiceFinder::getStatistics() const
+{
+    Statistics statistics = _impl->_statistics;
+    _impl->_send_sockets.fillStatistics(statistics);
+#ifdef LSSDP_USE_RECEIVE_WORKERS
+    if (_impl->_receive_workers)
+    {
+        _impl->_receive_workers->addStatistics(statistics._receive);
+    }
+#endif
+    return statistics;
+}
+
+/*****************************************************************************************/
+struct Reactor::Impl
+{
+    // forwards to a Service or a ServiceHost
+    class ServiceSource : public PollSource
+    {
+    public:
+        explicit ServiceSource(PollSource* service) : _service(service)
         {
-            std::string error_msg = std::string("select on ") + _impl->_discover_url
-                + " failed, errno = "
-                + getErrorAsString();
-            _impl->_send_errors[_impl->_discover_url] = error_msg;
-            go_ahead = false;
-            return_value = false;
-        } 
-        else if (ret == 0)
+        }
+        uint64_t getSocketsVersion() const override
         {
-            FD_SET(_impl->_multicast_socket._socket, &fs);
-            //we check for the overall timeout at the and of the loop
-            go_ahead = true;
+            return _service->getSocketsVersion();
         }
-        else
+        void getSockets(std::vector<SOCKET_TYPE>& sockets) const override
         {
-            std::pair<bool, LSSDPPacket> packet = _impl->_multicast_socket.receivePacket();
-            if (packet.first)
-            {
-                bool package_interest = true;
-                if (!_impl->_device_type_filter.empty())
-                {
-                    if (strcmp(packet.second._device_type, _impl->_device_type_filter.c_str()) != 0)
-                    {
-                        //its not out device looking for
-                        package_interest = false;
-                    }
-                }
-                if (!_impl->_search_target.empty() && _impl->_search_target != std::string(LSSDP_SEARCH_TARGET_ALL))
-                {
-                    if (strcmp(packet.second._st, _impl->_search_target.c_str()) != 0)
-                    {
-                        //its not our target looking for
-                        package_interest = false;
-                    }
-                }
-                if (package_interest)
-                {
-                    if (strcmp(packet.second._method, LSSDP_NOTIFY) == 0)
-                    {
-                        ServiceUpdateEvent event;
-                        event._event_id = ServiceUpdateEvent::notify_alive;
-                        if (strcmp(packet.second._nts, LSSDP_NOTIFY_NTS_ALIVE) == 0)
-                        {
-                            event._event_id = ServiceUpdateEvent::notify_alive;
-                        }
-                        else if (strcmp(packet.second._nts, LSSDP_NOTIFY_NTS_BYEBYE) == 0)
-                        {
-                            event._event_id = ServiceUpdateEvent::notify_byebye;
-                        }
-                        event._service_description = ServiceDescription(packet.second._location,
-                            packet.second._usn,
-                            packet.second._st,
-                            "",
-                            "",
-                            packet.second._sm_id,
-                            packet.second._device_type);
-                        update_callback(event);
-                    }
-                    else if (strcmp(packet.second._method, LSSDP_RESPONSE) == 0)
-                    {
-                        ServiceUpdateEvent event;
-                        event._event_id = ServiceUpdateEvent::response;
-                        event._service_description = ServiceDescription(packet.second._location,
-                            packet.second._usn,
-                            packet.second._st,
-                            "",
-                            "",
-                            packet.second._sm_id,
-                            packet.second._device_type);
-                        update_callback(event);
-                    }
-                }
-            }
+            _service->getSockets(sockets);
         }
-        
-        //timeout check
-        if ((std::chrono::system_clock::now() - begin_time) >= timeout)
+        bool onReadable(SOCKET_TYPE socket) override
         {
-            go_ahead = false;
+            return _service->onReadable(socket);
         }
-        
-    } while (go_ahead);
-    return return_value;
+        std::chrono::steady_clock::time_point getNextTimeout() const override
+        {
+            return _service->getNextTimeout();
+        }
+        bool onTimeout(std::chrono::steady_clock::time_point now) override
+        {
+            return _service->onTimeout(now);
+        }
+        PollSource* _service;
+    };
+
+    class FinderSource : public PollSource
+    {
+    public:
+        FinderSource(ServiceFinder::Impl* finder,
+                     const std::function<void(const ServiceFinder::ServiceUpdateEvent&)>& update_callback) :
+            _finder(finder),
+            _update_callback(update_callback)
+        {
+        }
+        uint64_t getSocketsVersion() const override
+        {
+            return _finder->getSocketsVersion();
+        }
+        void getSockets(std::vector<SOCKET_TYPE>& sockets) const override
+        {
+            _finder->getSockets(sockets);
+        }
+        bool onReadable(SOCKET_TYPE socket) override
+        {
+            _finder->setUpdateCallback(&_update_callback);
+            return _finder->onReadable(socket);
+        }
+        std::chrono::steady_clock::time_point getNextTimeout() const override
+        {
+            return _finder->getNextTimeout();
+        }
+        bool onTimeout(std::chrono::steady_clock::time_point now) override
+        {
+            _finder->setUpdateCallback(&_update_callback);
+            return _finder->onTimeout(now);
+        }
+        ServiceFinder::Impl* _finder;
+        std::function<void(const ServiceFinder::ServiceUpdateEvent&)> _update_callback;
+    };
+
+    void add(const void* key, std::unique_ptr<PollSource> source)
+    {
+        remove(key);
+        _poller.add(source.get());
+        _sources[key] = std::move(source);
+    }
+
+    void remove(const void* key)
+    {
+        auto found = _sources.find(key);
+        if (found != _sources.end())
+        {
+            _poller.remove(found->second.get());
+            _sources.erase(found);
+        }
+    }
+
+    Poller _poller;
+    std::map<const void*, std::unique_ptr<PollSource>> _sources;
+    std::string _last_errors;
+};
+
+Reactor::Reactor() : _impl(std::make_unique<Impl>())
+{
 }
 
-std::string ServiceFinder::getLastSendErrors() const 
+Reactor::~Reactor()
 {
-    return _impl->getSendErrors();
+}
+
+void Reactor::add(Service& service)
+{
+    _impl->add(service._impl.get(),
+               std::unique_ptr<PollSource>(new Impl::ServiceSource(service._impl.get())));
+}
+
+void Reactor::remove(Service& service)
+{
+    _impl->remove(service._impl.get());
+}
+
+void Reactor::add(ServiceHost& host)
+{
+    _impl->add(host._impl.get(),
+               std::unique_ptr<PollSource>(new Impl::ServiceSource(host._impl.get())));
+}
+
+void Reactor::remove(ServiceHost& host)
+{
+    _impl->remove(host._impl.get());
+}
+
+void Reactor::add(ServiceFinder& finder,
+                  const std::function<void(const ServiceFinder::ServiceUpdateEvent&)>& update_callback)
+{
+    _impl->add(finder._impl.get(),
+               std::unique_ptr<PollSource>(new Impl::FinderSource(finder._impl.get(), update_callback)));
+}
+
+void Reactor::remove(ServiceFinder& finder)
+{
+    _impl->remove(finder._impl.get());
+}
+
+bool Reactor::run(std::chrono::milliseconds timeout)
+{
+    _impl->_last_errors.clear();
+    return _impl->_poller.waitUntil(std::chrono::steady_clock::now() + timeout, _impl->_last_errors);
+}
+
+std::string Reactor::getLastErrors() const
+{
+    return _impl->_last_errors;
 }
 
 } //namespace lssdp
@@ -22,6 +22,7 @@
 ******************************************************************************************/
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
@@ -38,6 +39,19 @@ namespace lssdp
  */
 constexpr static const char* const LSSDP_DEFAULT_URL = "http://239.255.255.250:1900";
 
+/**
+ * @brief Placeholder within a LOCATION URL for the address of the interface a message is sent on,
+ *        i.e. "http://{ip}:9090/description.xml"
+ * 
+ */
+constexpr static const char* const LSSDP_LOCATION_INTERFACE_IP = "{ip}";
+
+/**
+ * @brief Count of header lines indexed for each received message, see MessageHeaders
+ * 
+ */
+constexpr static const size_t LSSDP_MAX_HEADERS = 32;
+
 /**
  * @brief Convinience class for NetworkInterfaces 
  * @detail Usually this class must not be in the API,
@@ -159,6 +173,160 @@ private:
  */
 bool updateNetworkInterfaces(std::vector<NetworkInterface>& interfaces);
 
+/**
+ * @brief Counters of one send path (NOTIFY, response *OK* or *M-SEARCH*)
+ *
+ */
+struct SendStatistics
+{
+    /**
+     * @brief datagrams handed over to the network stack without error
+     *
+     */
+    uint64_t _datagrams_sent = 0;
+    /**
+     * @brief datagrams which could not be sent
+     *
+     */
+    uint64_t _send_failures = 0;
+    /**
+     * @brief socket syscalls issued by this path to send the datagrams
+     *
+     */
+    uint64_t _syscalls = 0;
+    /**
+     * @brief socket syscalls saved compared to open, bind, setup and close
+     *        a socket for each single datagram
+     *
+     */
+    uint64_t _syscalls_saved = 0;
+};
+
+/**
+ * @brief Counters of the receive path
+ *
+ */
+struct ReceiveStatistics
+{
+    /**
+     * @brief datagrams received from the socket
+     *
+     */
+    uint64_t _datagrams_received = 0;
+    /**
+     * @brief datagrams which were no valid SSDP messages
+     *
+     */
+    uint64_t _invalid_datagrams = 0;
+    /**
+     * @brief batches received, one batch for each wakeup of the socket
+     *
+     */
+    uint64_t _batches = 0;
+    /**
+     * @brief histogram of the batch sizes
+     * @detail _batch_sizes[n] is the count of batches which held n datagrams
+     *
+     */
+    std::vector<uint64_t> _batch_sizes;
+    /**
+     * @brief datagrams are received by a multishot receive of io_uring
+     * @detail see cmake option lssdpcpp_enable_io_uring, false after the fallback to recvmmsg
+     *
+     */
+    bool _io_uring = false;
+    /**
+     * @brief events dropped because a newer event of the same USN was already delivered
+     * @detail only with receive workers (see ServiceFinder::setReceiveWorkers)
+     *
+     */
+    uint64_t _stale_events = 0;
+    /**
+     * @brief valid datagrams per receiving interface
+     * @detail _interface_datagrams[n] is the count for the interface index n (IP_PKTINFO),
+     *         stays empty on platforms which do not tell the interface
+     *
+     */
+    std::vector<uint64_t> _interface_datagrams;
+};
+
+/**
+ * @brief Statistics of a Service or a ServiceFinder
+ *
+ */
+struct Statistics
+{
+    /**
+     * @brief received on the multicast socket: *M-SEARCH* (Service) or *NOTIFY* (ServiceFinder)
+     *
+     */
+    ReceiveStatistics _receive;
+    /**
+     * @brief response *OK* received on the unicast socket the *M-SEARCH* was sent from (ServiceFinder only)
+     *
+     */
+    ReceiveStatistics _unicast_receive;
+    /**
+     * @brief *NOTIFY* ssdp:alive and ssdp:byebye messages (Service only)
+     *
+     */
+    SendStatistics _notify;
+    /**
+     * @brief response *OK* messages (Service only)
+     *
+     */
+    SendStatistics _response;
+    /**
+     * @brief *M-SEARCH* messages (ServiceFinder only)
+     *
+     */
+    SendStatistics _msearch;
+    /**
+     * @brief send sockets opened for discovered network interfaces
+     *
+     */
+    uint64_t _send_sockets_opened = 0;
+    /**
+     * @brief send sockets closed because the network interface went away
+     *
+     */
+    uint64_t _send_sockets_closed = 0;
+    /**
+     * @brief socket syscalls issued to setup and close the send sockets
+     *
+     */
+    uint64_t _send_socket_syscalls = 0;
+    /**
+     * @brief datagrams are sent as io_uring submissions
+     * @detail see cmake option lssdpcpp_enable_io_uring, false after the fallback to sendmmsg
+     *
+     */
+    bool _send_io_uring = false;
+    /**
+     * @brief repeated announcements not informed (ServiceFinder::setDeltaEvents only)
+     *
+     */
+    uint64_t _suppressed_events = 0;
+    /**
+     * @brief responses to a repeated *M-SEARCH* merged into the pending response
+     *        to the same requester (Service and ServiceHost only)
+     *
+     */
+    uint64_t _merged_responses = 0;
+    /**
+     * @brief responses to an *M-SEARCH* not sent because too many responses were waiting
+     *        for their delay (Service and ServiceHost only)
+     *
+     */
+    uint64_t _dropped_responses = 0;
+    /**
+     * @brief *M-SEARCH* not responded because its requester exceeded the search rate limit
+     *        (Service and ServiceHost only)
+     *
+     */
+    uint64_t _suppressed_msearches = 0;
+};
+
 /**
  * @brief service description class
  *        which may contain all properties of a service
@@ -178,6 +346,8 @@ public:
      * @param location_url Address of the service as well-formed URL where
      *                     the service is located. In UPnP this is a link to the service 
      *                     or device schema (see chapter 2.8, 2.9, 2.11).
+     *                     LSSDP_LOCATION_INTERFACE_IP is replaced by the address of each
+     *                     interface the messages are sent on.
      * @param unique_service_name Unique name of that service
      * @param search_target The notification type (NT) and search target (ST)
      * @param product_name Product name of the device (usually some vendor device name)
@@ -284,6 +454,146 @@ private:
     std::string _product_version;
 };
 
+/**
+ * @brief the header lines of a received SSDP message, looked up by name
+ * @detail The parser indexes each header line once as offsets into the received datagram,
+ *         a header is only copied if it is read. Within the update callback the headers refer
+ *         to the receive buffer, a copy of them (i.e. of the *ServiceUpdateEvent*) owns the bytes
+ *         in one buffer which the further copies share.
+ *         The names are case insensitive, at most LSSDP_MAX_HEADERS lines are indexed.
+ * 
+ */
+class MessageHeaders
+{
+public:
+    /**
+     * @brief a header line within the datagram
+     * 
+     */
+    struct Entry
+    {
+        uint16_t _name_offset;
+        uint16_t _value_offset;
+        uint16_t _value_size;
+        uint8_t  _name_size;
+        /* id of a known SSDP header, 0 for any other */
+        uint8_t  _id;
+    };
+
+    /**
+     * @brief Default CTOR, no headers
+     * 
+     */
+    MessageHeaders() = default;
+    /**
+     * @brief CTOR which refers to the datagram and its index, both must outlive the headers
+     * 
+     * @param data the received datagram
+     * @param entries the header lines within @p data
+     * @param count count of @p entries
+     */
+    MessageHeaders(const char* data, const Entry* entries, size_t count);
+    /**
+     * @brief copy CTOR, the copy owns the header lines
+     * @detail the first copy of the received headers copies them into one buffer,
+     *         the copies of a copy share that buffer
+     * 
+     * @param other the headers to copy
+     */
+    MessageHeaders(const MessageHeaders& other);
+    /**
+     * @brief copy operator, the copy owns the header lines
+     * 
+     * @param other the headers to copy
+     * @return the copied headers
+     */
+    MessageHeaders& operator=(const MessageHeaders& other);
+    /**
+     * @brief move CTOR
+     * 
+     */
+    MessageHeaders(MessageHeaders&& other);
+    /**
+     * @brief move operator
+     * 
+     * @return the moved headers
+     */
+    MessageHeaders& operator=(MessageHeaders&& other);
+
+    /**
+     * @brief Get the count of header lines
+     * 
+     * @return the count of header lines
+     */
+    size_t size() const;
+    /**
+     * @brief Get the name of a header line as it was received
+     * 
+     * @param index index of the header line, less than size()
+     * @return the name
+     */
+    std::string getName(size_t index) const;
+    /**
+     * @brief Get the value of a header line
+     * 
+     * @param index index of the header line, less than size()
+     * @return the value without the leading and trailing spaces
+     */
+    std::string getValue(size_t index) const;
+    /**
+     * @brief Get the value of the first header line with the name @p name
+     * 
+     * @param name case insensitive name, i.e. "SERVER" or "X-User-Agent"
+     * @param value the value if found
+     * @retval true the header was received
+     * @retval false the header was not received
+     */
+    bool getHeader(const std::string& name, std::string& value) const;
+    /**
+     * @brief Get the value of the first header line with the name @p name
+     * 
+     * @param name case insensitive name, i.e. "SERVER" or "X-User-Agent"
+     * @return the value, empty if the header was not received
+     */
+    std::string getHeader(const std::string& name) const;
+    /**
+     * @brief Get the *max-age* directive of *CACHE-CONTROL*
+     * 
+     * @param max_age the max-age if valid
+     * @retval true received with a valid max-age
+     * @retval false not received or invalid
+     */
+    bool getMaxAge(std::chrono::seconds& max_age) const;
+    /**
+     * @brief Get the *MX* of an *M-SEARCH*, the maximum seconds to wait for the response
+     * 
+     * @param mx the MX if valid
+     * @retval true received with a valid number
+     * @retval false not received or invalid
+     */
+    bool getMx(std::chrono::seconds& mx) const;
+    /**
+     * @brief Get the *BOOTID.UPNP.ORG* of UPnP 1.1, increased on each boot of the device
+     * 
+     * @param boot_id the boot id if valid
+     * @retval true received with a valid number
+     * @retval false not received or invalid
+     */
+    bool getBootId(uint32_t& boot_id) const;
+
+private:
+    const Entry* find(const std::string& name) const;
+    void copyFrom(const MessageHeaders& other);
+
+    const char*                 _data = nullptr;
+    const Entry*                _entries = nullptr;
+    size_t                      _count = 0;
+    // only set for a copy: the index and the header lines in one buffer, shared by its copies
+    std::shared_ptr<const char> _owned;
+};
+
+class Reactor;
+
 /**
  * Service class to setup a discoverable service.
  * 
@@ -306,7 +616,8 @@ public:
      *                     Unfortunately, it is not yet checked wether you give a valid
      *                     multicast address or not. So beware of that! 
      * @param max_age The UPnP specification recommends a value greater than or equal to 1800 seconds.
-     * @param location_url  Address of the service as well-formed URL where the service is located
+     * @param location_url  Address of the service as well-formed URL where the service is located,
+     *                      LSSDP_LOCATION_INTERFACE_IP is replaced by the address of each interface
      * @param unique_service_name Unique name of that service
      * @param search_target The notification type. The service will notify with this type and 
      *                      will only response to search requests containing this 
@@ -376,11 +687,31 @@ public:
      * @retval false sent notify with errors, check with getLastSendErrors
      */
     bool sendNotifyByeBye();
+    /**
+     * @brief Queues the *NOTIFY* "ssdp:alive" for all networks, it is sent by flush
+     * @detail The queued messages of all types are sent together as one batch
+     *         (one sendmmsg on Linux), i.e. a byebye followed by an alive after a restart.
+     *         The queue is flushed before a network change or setBootId alters the messages.
+     */
+    void queueNotifyAlive();
+    /**
+     * @brief Queues the *NOTIFY* "ssdp:byebye" for all networks, it is sent by flush
+     */
+    void queueNotifyByeBye();
+    /**
+     * @brief Sends all queued messages as one batch
+     * @retval true sent without errors (or nothing was queued)
+     * @retval false sent with errors, check with getLastSendErrors
+     */
+    bool flush();
     /**
      * @brief check for a *M-SEARCH* messages and response if *search target (ST)* 
      *        and optionally *device type (DEV_TYPE)* matches
      * 
-     * @param timeout Timeout in milliseconds (min wait time is 100 ms for now)
+     * @detail The response is sent after a random delay within the *MX* of the *M-SEARCH*,
+     *         see setMaxResponseDelay. It is sent by this or a later call (or by the Reactor).
+     * 
+     * @param timeout Timeout in milliseconds, the function returns when it is reached
      * @retval true receiving from and responding to socket okay, timeout reached 
      * @retval false receiving from failed
      * 
@@ -388,6 +719,41 @@ public:
      *         as version within the *SERVER:* tag!
      */
     bool checkForMSearchAndSendResponse(std::chrono::milliseconds timeout);
+    /**
+     * @brief Set the upper bound of the random response delay
+     * @detail Each response is delayed by a random time within the *MX* of the *M-SEARCH*
+     *         and this bound, so many control points searching at once do not get all responses
+     *         at the same instant. A repeated *M-SEARCH* of the same requester is merged into
+     *         the pending response. An *M-SEARCH* without *MX* is responded immediately.
+     *         The default is 5 seconds, the upper bound of *MX* (UDA 1.1), 0 responds immediately.
+     *
+     * @param max_delay the upper bound of the delay
+     */
+    void setMaxResponseDelay(std::chrono::milliseconds max_delay);
+    /**
+     * @brief Set the search rate limit of each requester
+     * @detail Each requester IP address has a token bucket: a matching *M-SEARCH* takes a token,
+     *         the bucket refills with @p searches_per_second up to @p burst tokens. An *M-SEARCH*
+     *         of an empty bucket is not responded and counted in Statistics::_suppressed_msearches.
+     *         The buckets are a fixed table, the least recently searching requester is evicted,
+     *         so the memory stays bounded for any count of source addresses. A new requester
+     *         starts with a full bucket once it is admitted by the bucket of all new requesters
+     *         (50 per second with a burst of 100).
+     *         The default is 10 searches per second with a burst of 20.
+     *
+     * @param searches_per_second the refill rate, 0 responds to each M-SEARCH
+     * @param burst the tokens of a full bucket
+     */
+    void setSearchRateLimit(double searches_per_second, uint32_t burst);
+    /**
+     * @brief Set the boot id sent as *BOOTID.UPNP.ORG* with the *NOTIFY* and responses (UDA 1.1)
+     * @detail Increase it each time the service restarts or its description changes, so the
+     *         control points know to refetch it. The header is a slot of the prepared messages,
+     *         changing it does not rebuild them.
+     *
+     * @param boot_id the boot id, 0 (the default) sends no *BOOTID.UPNP.ORG*
+     */
+    void setBootId(uint32_t boot_id);
 
     /**
      * @brief Convinience equality operator
@@ -411,7 +777,176 @@ public:
      */
     std::string getLastSendErrors() const;
 
+    /**
+     * @brief Get the send statistics of this service
+     *
+     * @return the statistics
+     */
+    Statistics getStatistics() const;
+
+private:
+    friend class Reactor;
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+/*********************************************************************************************************/
+/**
+ * ServiceHost class to host many discoverable services behind one socket.
+ * 
+ * Each received *M-SEARCH* is parsed once and answered for all hosted services whose 
+ * *search target (ST)* matches (or all services for *ssdp:all*).
+ * 
+ */
+class ServiceHost
+{
+public:
+    /**
+     * Default CTOR is deleted
+     * 
+     */
+    ServiceHost() = delete;
+    /**
+     * @brief CTOR
+     * @detail The *ServiceHost* will immediately discover all lssdp::NetworkInterface s and 
+     *         open the socket for the given *discover_url*.
+     * 
+     * @param discover_url well-formed URL with the multicast address and port.
+     * @param max_age The UPnP specification recommends a value greater than or equal to 1800 seconds.
+     *                It is used for all hosted services.
+     */
+    ServiceHost(std::string discover_url,
+                std::chrono::seconds max_age);
+    /**
+     * @brief DTOR
+     * 
+     */
+    ~ServiceHost();
+    /**
+     * @brief Default move CTOR
+     * 
+     */
+    ServiceHost(ServiceHost&&) = default;
+    /**
+     * @brief Default move operator
+     * 
+     * @return reference of this service host
+     */
+    ServiceHost& operator=(ServiceHost&&) = default;
+    /**
+     * @brief Default copy CTOR is deleted
+     * 
+     */
+    ServiceHost(const ServiceHost& other) = delete;
+    /**
+     * @brief Default copy operator is deleted
+     * 
+     * @return reference of this service host
+     */
+    ServiceHost& operator=(const ServiceHost& other) = delete;
+
+    /**
+     * @brief Hosts the service, the service is answered from now on
+     * 
+     * @param service the service to host, see Service for its properties
+     * @retval true the service is hosted
+     * @retval false a service with the same search target and unique service name is already hosted
+     */
+    bool addService(const ServiceDescription& service);
+    /**
+     * @brief Stops hosting the service (without sending *NOTIFY* ssdp:byebye)
+     * 
+     * @param service the service to remove, compared by search target and unique service name
+     * @retval true the service was removed
+     * @retval false the service is not hosted
+     */
+    bool removeService(const ServiceDescription& service);
+    /**
+     * @brief Get the hosted services
+     * 
+     * @return the hosted services
+     */
+    std::vector<ServiceDescription> getServices() const;
+
+    /**
+     * @brief Will send a *NOTIFY* ssdp:alive message of each hosted service to all
+     *        networks, all messages are sent as one batch.
+     * 
+     * @retval true sent notify without errors
+     * @retval false sent notify with errors, check with getLastSendErrors
+     */
+    bool sendNotifyAlive();
+    /**
+     * @brief Will send a *NOTIFY* ssdp:byebye message of each hosted service to all
+     *        networks, all messages are sent as one batch.
+     * 
+     * @retval true sent notify without errors
+     * @retval false sent notify with errors, check with getLastSendErrors
+     */
+    bool sendNotifyByeBye();
+    /**
+     * @brief Queues the *NOTIFY* ssdp:alive of each hosted service, see Service::queueNotifyAlive
+     */
+    void queueNotifyAlive();
+    /**
+     * @brief Queues the *NOTIFY* ssdp:byebye of each hosted service, see Service::queueNotifyAlive
+     */
+    void queueNotifyByeBye();
+    /**
+     * @brief Sends all queued messages as one batch
+     * @detail The queue is also flushed before a network change, setBootId or a change
+     *         of the hosted services alters the messages.
+     * @retval true sent without errors (or nothing was queued)
+     * @retval false sent with errors, check with getLastSendErrors
+     */
+    bool flush();
+    /**
+     * @brief check for *M-SEARCH* messages and respond for all matching hosted services
+     * @detail The responses are sent after a random delay within the *MX* of the *M-SEARCH*,
+     *         see setMaxResponseDelay. They are sent by this or a later call (or by the Reactor).
+     * 
+     * @param timeout Timeout in milliseconds, the function returns when it is reached
+     * @retval true receiving from and responding to socket okay, timeout reached 
+     * @retval false receiving from failed
+     */
+    bool checkForMSearchAndSendResponse(std::chrono::milliseconds timeout);
+    /**
+     * @brief Set the upper bound of the random response delay, see Service::setMaxResponseDelay
+     *
+     * @param max_delay the upper bound of the delay, the default is 5 seconds, 0 responds immediately
+     */
+    void setMaxResponseDelay(std::chrono::milliseconds max_delay);
+    /**
+     * @brief Set the search rate limit of each requester, see Service::setSearchRateLimit
+     * @detail One *M-SEARCH* takes one token, however many hosted services it matches.
+     *
+     * @param searches_per_second the refill rate, the default is 10, 0 responds to each M-SEARCH
+     * @param burst the tokens of a full bucket, the default is 20
+     */
+    void setSearchRateLimit(double searches_per_second, uint32_t burst);
+    /**
+     * @brief Set the boot id of all hosted services, see Service::setBootId
+     *
+     * @param boot_id the boot id, 0 (the default) sends no *BOOTID.UPNP.ORG*
+     */
+    void setBootId(uint32_t boot_id);
+
+    /**
+     * @brief Get send errors if sending fails to one of the networkinterfaces
+     *
+     * @return the send errors
+     */
+    std::string getLastSendErrors() const;
+
+    /**
+     * @brief Get the statistics of this service host
+     *
+     * @return the statistics
+     */
+    Statistics getStatistics() const;
+
 private:
+    friend class Reactor;
     struct Impl;
     std::unique_ptr<Impl> _impl;
 };
@@ -451,7 +986,14 @@ public:
              * response *OK* message was received
              * 
              */
-            response
+            response,
+            /**
+             * the max-age of the last announcement passed without a ssdp:byebye
+             * (only with ServiceFinder::setServiceCache or ServiceFinder::setDeltaEvents,
+             * with the delta events only the description has the USN only)
+             *
+             */
+            expired
         };
         /**
          * @brief The service information within the message
@@ -466,6 +1008,17 @@ public:
          * 
          */
         UpdateEvent        _event_id;
+        /**
+         * @brief *CACHE-CONTROL: max-age* of the message, 0 if it has none
+         *
+         */
+        std::chrono::seconds _max_age = std::chrono::seconds(0);
+        /**
+         * @brief all header lines of the message, i.e. *SERVER*, *BOOTID.UPNP.ORG* or vendor *X-* headers
+         *        (none for *expired*)
+         *
+         */
+        MessageHeaders     _headers;
     };
 
 public:
@@ -540,6 +1093,17 @@ public:
      * @retval false sent notify with errors, check with getLastSendErrors
      */
     bool sendMSearch();
+    /**
+     * @brief Queues a *M-SEARCH* for all networks, it is sent by flush.
+     *        The queued searches are sent together as one batch (one sendmmsg on Linux).
+     */
+    void queueMSearch();
+    /**
+     * @brief Sends all queued *M-SEARCH* messages as one batch
+     * @retval true sent without errors (or nothing was queued)
+     * @retval false sent with errors, check with getLastSendErrors
+     */
+    bool flush();
     /**
      * @brief check for network interface changes explicitely.
      *        sendMSearch will usually check for that, but if you do not want to
@@ -553,7 +1117,7 @@ public:
      *        informed via ServiceUpdateEvent in @p update_callback
      * 
      * @param update_callback function to inform notification and response events to.
-     * @param timeout overall timeout of this function (min timeout is 100 ms)
+     * @param timeout overall timeout of this function
      * @retval true receiving from the socket okay, timeout reached 
      * @retval false receiving from failed
      * 
@@ -561,6 +1125,73 @@ public:
     bool checkForServices(const std::function<void(const ServiceUpdateEvent&)>& update_callback,
                           std::chrono::milliseconds timeout);
 
+    /**
+     * @brief Set the count of datagrams drained from the socket on each wakeup
+     *        within checkForServices. All datagrams of the batch are parsed before
+     *        the socket is polled again.
+     *
+     * @param max_datagrams max datagrams of one batch (at least 1, 1 receives one datagram per wakeup)
+     */
+    void setReceiveBatchSize(size_t max_datagrams);
+
+    /**
+     * @brief Receive and parse on @p workers threads instead of the calling thread (Linux only).
+     * @detail Each worker owns a socket bound with SO_REUSEPORT to the discovery port.
+     *         A socket filter shares the multicast datagrams among the sockets by their source address.
+     *         The events are merged and the update_callback is still called within checkForServices
+     *         (or Reactor::run) on the calling thread.
+     *         Ordering: the events of one USN are delivered in the order the kernel received them,
+     *         an event overtaken by a newer event of the same USN is dropped
+     *         (see ReceiveStatistics::_stale_events). The receive order of a USN without events
+     *         for 10 seconds is forgotten, so the memory stays bounded by the active USNs.
+     *         The sockets are reopened, call it before checkForServices.
+     *
+     * @param workers count of worker threads, 0 or 1 receives on the calling thread again
+     * @param cpus worker i is pinned to the CPU cpus[i % cpus.size()], empty (the default) leaves
+     *        the placement to the scheduler. Throws a std::runtime_error if a CPU can not be used,
+     *        the finder keeps receiving as before the call.
+     * @retval true the workers are running
+     * @retval false the platform does not support receive workers, receiving stays on the calling thread
+     */
+    bool setReceiveWorkers(size_t workers, const std::vector<unsigned int>& cpus = std::vector<unsigned int>());
+
+    /**
+     * @brief Keep the discovered services by their USN.
+     * @detail Each *NOTIFY* ssdp:alive and response *OK* (re)starts the max-age of its service,
+     *         a ssdp:byebye removes it. If the max-age passes without a new announcement
+     *         the service is removed and an *expired* event is sent to the update_callback
+     *         within checkForServices (or Reactor::run).
+     *         The max-ages are kept on a timing wheel with 1 second ticks, so many
+     *         services cost no more than a few on each wakeup.
+     *
+     * @param enabled true to keep the services, false drops the cache
+     */
+    void setServiceCache(bool enabled);
+
+    /**
+     * @brief Inform only the changes of the services instead of each received message.
+     * @detail An event is informed if the service is new, its LOCATION, ST, SM_ID or DEV_TYPE
+     *         changed, it says ssdp:byebye (once, not on each interface, also if it was
+     *         not seen before) or it expired.
+     *         The repetitions of an announcement (periodic ssdp:alive, the same message on
+     *         several interfaces, responses to our *M-SEARCH*) only restart its max-age and
+     *         are counted in Statistics::_suppressed_events.
+     *         The last seen state is a 64 bit hash of these fields per USN in the service cache,
+     *         so the delta events use the service cache even without setServiceCache, the
+     *         descriptions are only kept with setServiceCache. A change whose fields hash like
+     *         the last seen ones (a chance of about 2^-64) is not informed.
+     *
+     * @param enabled true informs the changes only, false informs each message again
+     */
+    void setDeltaEvents(bool enabled);
+
+    /**
+     * @brief Get the services of the cache
+     *
+     * @return the services not yet expired, empty without setServiceCache
+     */
+    std::vector<ServiceDescription> getServices() const;
+
     /**
      * @brief Get the discovery Url 
      * 
@@ -575,11 +1206,127 @@ public:
      */
     std::string getLastSendErrors() const;
 
+    /**
+     * @brief Get the send statistics of this service finder
+     *
+     * @return the statistics
+     */
+    Statistics getStatistics() const;
+
 private:
+    friend class Reactor;
     class Impl;
     std::unique_ptr<Impl> _impl;
 };
 
+/*********************************************************************************************************/
+/**
+ * Reactor to wait for the sockets of many Services, ServiceHosts and ServiceFinders in one wait call.
+ * It uses epoll on Linux and select otherwise.
+ * 
+ * @remark Like Service and ServiceFinder the Reactor is NOT thread-safe.
+ *         The added Services and ServiceFinders must be removed before they are destroyed.
+ */
+class Reactor
+{
+public:
+    /**
+     * @brief CTOR
+     * 
+     */
+    Reactor();
+    /**
+     * @brief DTOR
+     * 
+     */
+    ~Reactor();
+    /**
+     * @brief Default move CTOR
+     * 
+     */
+    Reactor(Reactor&&) = default;
+    /**
+     * @brief Default move operator
+     * 
+     * @return reference to the moved object
+     */
+    Reactor& operator=(Reactor&&) = default;
+    /**
+     * @brief Default copy CTOR is deleted
+     * 
+     */
+    Reactor(const Reactor&) = delete;
+    /**
+     * @brief Default copy operator is deleted
+     * 
+     * @return reference to the copied object
+     */
+    Reactor& operator=(const Reactor&) = delete;
+
+    /**
+     * @brief Watch the service, received *M-SEARCH* messages are responded like in
+     *        Service::checkForMSearchAndSendResponse
+     * 
+     * @param service the service to watch
+     */
+    void add(Service& service);
+    /**
+     * @brief Stop watching the service
+     * 
+     * @param service the service to remove
+     */
+    void remove(Service& service);
+    /**
+     * @brief Watch the service host, received *M-SEARCH* messages are responded like in
+     *        ServiceHost::checkForMSearchAndSendResponse
+     * 
+     * @param host the service host to watch
+     */
+    void add(ServiceHost& host);
+    /**
+     * @brief Stop watching the service host
+     * 
+     * @param host the service host to remove
+     */
+    void remove(ServiceHost& host);
+    /**
+     * @brief Watch the service finder, received notifications and responses are informed
+     *        like in ServiceFinder::checkForServices
+     * 
+     * @param finder the service finder to watch
+     * @param update_callback function to inform notification and response events to.
+     */
+    void add(ServiceFinder& finder,
+             const std::function<void(const ServiceFinder::ServiceUpdateEvent&)>& update_callback);
+    /**
+     * @brief Stop watching the service finder
+     * 
+     * @param finder the service finder to remove
+     */
+    void remove(ServiceFinder& finder);
+
+    /**
+     * @brief Waits until the @p timeout is reached and handles each readable socket immediately.
+     * 
+     * @param timeout overall timeout of this function
+     * @retval true waiting and handling the sockets okay, timeout reached
+     * @retval false waiting failed (see getLastErrors) or a Service or ServiceFinder failed
+     *               (see their getLastSendErrors)
+     */
+    bool run(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Get the errors of the last run
+     *
+     * @return the errors
+     */
+    std::string getLastErrors() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
 } //namespace lssdp
 
 /**
@@ -621,6 +1368,10 @@ inline std::ostream& operator <<(std::ostream& stream, const lssdp::ServiceFinde
     {
         stream << std::string("response OK ");
     }
+    else if (event._event_id == event.expired)
+    {
+        stream << std::string("expired ");
+    }
     stream << event._service_description;
     
     return stream;
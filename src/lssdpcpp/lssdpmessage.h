@@ -0,0 +1,270 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*  
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#pragma once
+
+/*
+ * Internal header of lssdpcpp, it is not installed.
+ * The message template and the date are shared by the library and its benchmarks.
+ */
+
+#include <lssdpcpp/lssdppacket.h>
+
+#include <cassert>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace
+{
+    //"Sun, 06 Nov 1994 08:49:37 GMT"
+    constexpr size_t LSSDP_HTTP_DATE_LEN = 29;
+}
+
+namespace lssdp
+{
+
+/**
+ * an SSDP message of static segments and slots: the static text is built once, a send
+ * points the segments of its datagram at the text and at the slot values of this send,
+ * nothing is copied or allocated for a LOCATION, DATE, BOOTID or ST which varies per send
+ */
+class MessageTemplate
+{
+public:
+    enum Slot : uint8_t
+    {
+        //the LOCATION URL of the interface
+        slot_location,
+        //the date of the DATE header
+        slot_date,
+        //the whole BOOTID.UPNP.ORG header line, empty if there is no boot id
+        slot_boot_id,
+        //the ST of a response, it echoes the searched ST
+        slot_search_target,
+        slot_count,
+        no_slot = 0xff
+    };
+
+    //each slot is added once and the static text between two slots is one part,
+    //so a template has at most one static part before, and one after each slot
+    static constexpr size_t max_parts = 2 * slot_count + 1;
+    static_assert(slot_count <= 32, "the slots added are a 32 bit mask");
+
+    void clear()
+    {
+        _text.clear();
+        _part_count = 0;
+        _used_slots = 0;
+    }
+
+    /**
+     * appends @p text to the static segment
+     */
+    MessageTemplate& add(const char* text)
+    {
+        return add(text, strlen(text));
+    }
+
+    MessageTemplate& add(const std::string& text)
+    {
+        return add(text.data(), text.size());
+    }
+
+    /**
+     * appends the header line "@p name @p value\r\n"
+     */
+    MessageTemplate& addHeader(const char* name, const std::string& value)
+    {
+        return add(name).add(value).add("\r\n");
+    }
+
+    /**
+     * appends the value of @p slot which is given on each send
+     */
+    MessageTemplate& addSlot(Slot slot)
+    {
+        assert(slot < slot_count && (_used_slots & (1u << slot)) == 0);
+        _used_slots |= (1u << slot);
+        Part& part = addPart();
+        part._slot = slot;
+        return *this;
+    }
+
+    /**
+     * points @p segments (max_parts) at the static text and @p slot_values (slot_count values),
+     * an empty slot is left out
+     */
+    void fill(const StringRef* slot_values, StringRef* segments, size_t& segment_count) const
+    {
+        segment_count = 0;
+        for (size_t index = 0; index < _part_count; ++index)
+        {
+            const Part& part = _parts[index];
+            if (part._slot == no_slot)
+            {
+                segments[segment_count++] = StringRef(&_text[part._offset], part._size);
+            }
+            else if (!slot_values[part._slot].empty())
+            {
+                segments[segment_count++] = slot_values[part._slot];
+            }
+        }
+    }
+
+private:
+    struct Part
+    {
+        uint32_t _offset = 0;
+        uint32_t _size = 0;
+        Slot     _slot = no_slot;
+    };
+
+    MessageTemplate& add(const char* text, size_t size)
+    {
+        if (_part_count == 0 || _parts[_part_count - 1]._slot != no_slot)
+        {
+            addPart()._offset = static_cast<uint32_t>(_text.size());
+        }
+        _parts[_part_count - 1]._size += static_cast<uint32_t>(size);
+        _text.append(text, size);
+        return *this;
+    }
+
+    Part& addPart()
+    {
+        _parts[_part_count] = Part();
+        return _parts[_part_count++];
+    }
+
+    // the static text is referred by offsets, the template may move
+    std::string _text;
+    Part        _parts[max_parts];
+    size_t      _part_count = 0;
+    uint32_t    _used_slots = 0;
+};
+
+} //namespace lssdp
+
+namespace
+{
+    //max segments (iovecs) of a datagram, the parts of a message template
+    constexpr size_t LSSDP_MAX_SEGMENTS = lssdp::MessageTemplate::max_parts;
+}
+
+namespace lssdp
+{
+
+/**
+ * the RFC 1123 date of the DATE header ("Sun, 06 Nov 1994 08:49:37 GMT"),
+ * each thread formats it at most once per second
+ */
+class HttpDate
+{
+public:
+    HttpDate()
+    {
+        format(_seconds, _text);
+    }
+
+    /**
+     * the date of this thread for now, it refers to a buffer of the thread which is
+     * overwritten with the date of the same length when the second changes
+     */
+    static StringRef now()
+    {
+        static thread_local HttpDate date;
+        return date.get(std::time(nullptr));
+    }
+
+    StringRef get(std::time_t seconds)
+    {
+        if (seconds != _seconds)
+        {
+            _seconds = seconds;
+            format(seconds, _text);
+        }
+        return StringRef(_text, LSSDP_HTTP_DATE_LEN);
+    }
+
+    /**
+     * formats @p seconds since the epoch (UTC) into LSSDP_HTTP_DATE_LEN chars of @p text,
+     * independent of the locale and without gmtime (days to the civil date by H. Hinnant)
+     */
+    static void format(std::time_t seconds, char* text)
+    {
+        static const char* const week_days = "ThuFriSatSunMonTueWed";
+        static const char* const months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+        int64_t days = static_cast<int64_t>(seconds) / 86400;
+        int64_t day_seconds = static_cast<int64_t>(seconds) % 86400;
+        if (day_seconds < 0)
+        {
+            day_seconds += 86400;
+            --days;
+        }
+        // 1. the week day, the epoch was a thursday
+        const int64_t week_day = ((days % 7) + 7) % 7;
+
+        // 2. the civil date of the days since the epoch
+        const int64_t shifted = days + 719468;
+        const int64_t era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+        const int64_t day_of_era = shifted - era * 146097;
+        const int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+        const int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        const int64_t month_index = (5 * day_of_year + 2) / 153;
+        const int64_t day = day_of_year - (153 * month_index + 2) / 5 + 1;
+        const int64_t month = month_index < 10 ? month_index + 3 : month_index - 9;
+        const int64_t year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+
+        memcpy(&text[0], &week_days[week_day * 3], 3);
+        text[3] = ',';
+        text[4] = ' ';
+        writeDigits(&text[5], day, 2);
+        text[7] = ' ';
+        memcpy(&text[8], &months[(month - 1) * 3], 3);
+        text[11] = ' ';
+        writeDigits(&text[12], year, 4);
+        text[16] = ' ';
+        writeDigits(&text[17], day_seconds / 3600, 2);
+        text[19] = ':';
+        writeDigits(&text[20], (day_seconds / 60) % 60, 2);
+        text[22] = ':';
+        writeDigits(&text[23], day_seconds % 60, 2);
+        memcpy(&text[25], " GMT", 4);
+    }
+
+private:
+    static void writeDigits(char* text, int64_t value, size_t digits)
+    {
+        for (size_t index = digits; index > 0; --index)
+        {
+            text[index - 1] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    std::time_t _seconds = 0;
+    char        _text[LSSDP_HTTP_DATE_LEN];
+};
+
+} //namespace lssdp
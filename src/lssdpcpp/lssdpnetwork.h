@@ -0,0 +1,100 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*  
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#pragma once
+
+/*
+ * Internal header of lssdpcpp, it is not installed.
+ * The network interface watcher is shared by the library and its tests.
+ */
+
+#include <lssdpcpp/lssdpcpp.h>
+
+#include <memory>
+#include <vector>
+
+namespace lssdp
+{
+
+/**
+ * @brief Keeps a vector of NetworkInterface s current and reports the changes as deltas
+ * @detail On Linux the interfaces are enumerated once, after that the rtnetlink address
+ *         events (RTM_NEWADDR/RTM_DELADDR) are applied, so update costs one non-blocking
+ *         receive while nothing changes. On other platforms each update enumerates
+ *         like updateNetworkInterfaces.
+ * 
+ */
+class NetworkInterfaceWatcher
+{
+public:
+    /**
+     * @brief CTOR
+     * 
+     */
+    NetworkInterfaceWatcher();
+    /**
+     * @brief DTOR
+     * 
+     */
+    ~NetworkInterfaceWatcher();
+    /**
+     * @brief Default move CTOR
+     * 
+     */
+    NetworkInterfaceWatcher(NetworkInterfaceWatcher&&) = default;
+    /**
+     * @brief Default move operator
+     * 
+     * @return the reference to the moved 
+     */
+    NetworkInterfaceWatcher& operator=(NetworkInterfaceWatcher&&) = default;
+    /**
+     * @brief Default copy CTOR is deleted
+     * 
+     */
+    NetworkInterfaceWatcher(const NetworkInterfaceWatcher&) = delete;
+    /**
+     * @brief Default copy operator is deleted
+     * 
+     * @return the reference to the copied 
+     */
+    NetworkInterfaceWatcher& operator=(const NetworkInterfaceWatcher&) = delete;
+
+    /**
+     * @brief updates the vector of NetworkInterface s
+     * 
+     * @param interfaces the vector to keep current, pass the same vector on each call
+     * @param added the interfaces which appeared since the last call
+     * @param removed the interfaces which went away since the last call
+     * @retval true the given interfaces has been changed
+     * @retval false the given interfaces has not been changed
+     */
+    bool update(std::vector<NetworkInterface>& interfaces,
+                std::vector<NetworkInterface>& added,
+                std::vector<NetworkInterface>& removed);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+} //namespace lssdp
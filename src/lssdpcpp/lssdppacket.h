@@ -0,0 +1,587 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*  
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#pragma once
+
+/*
+ * Internal header of lssdpcpp, it is not installed.
+ * The SSDP packet parser is shared by the library and its benchmarks.
+ */
+
+#include <lssdpcpp/lssdpcpp.h>
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <string.h>
+#include <ctype.h>
+
+// the line scanner uses the widest vector unit the compiler targets, i.e. -mavx2 or -march=native for AVX2
+#if defined(__AVX2__)
+#define LSSDP_USE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LSSDP_USE_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // SSDP Header
+    constexpr static const char* const LSSDP_HEADER_MSEARCH = "M-SEARCH * HTTP/1.1\r\n";
+    constexpr static const char* const LSSDP_HEADER_NOTIFY = "NOTIFY * HTTP/1.1\r\n";
+    constexpr static const char* const LSSDP_HEADER_RESPONSE = "HTTP/1.1 200 OK\r\n";
+}
+
+namespace lssdp
+{
+
+/**
+ * the SSDP header fields known to the parser
+ */
+enum HeaderId : uint8_t
+{
+    header_unknown,
+    header_host,
+    header_cache_control,
+    header_location,
+    header_nt,
+    header_nts,
+    header_server,
+    header_usn,
+    header_st,
+    header_man,
+    header_mx,
+    header_ext,
+    header_date,
+    header_user_agent,
+    header_bootid,
+    header_configid,
+    header_searchport,
+    header_sm_id,
+    header_dev_type,
+    header_count
+};
+
+// the helpers of the inline parser functions below, named so that each translation unit
+// refers to the same functions
+namespace detail
+{
+    struct HeaderName
+    {
+        const char*     _name;
+        size_t          _size;
+    };
+
+    constexpr size_t header_name_length(const char* name)
+    {
+        return *name == '\0' ? 0 : 1 + header_name_length(name + 1);
+    }
+
+    // lower case names in the order of lssdp::HeaderId
+    constexpr HeaderName LSSDP_HEADER_NAMES[lssdp::header_count] = {
+        { "", 0 },
+        { "host", header_name_length("host") },
+        { "cache-control", header_name_length("cache-control") },
+        { "location", header_name_length("location") },
+        { "nt", header_name_length("nt") },
+        { "nts", header_name_length("nts") },
+        { "server", header_name_length("server") },
+        { "usn", header_name_length("usn") },
+        { "st", header_name_length("st") },
+        { "man", header_name_length("man") },
+        { "mx", header_name_length("mx") },
+        { "ext", header_name_length("ext") },
+        { "date", header_name_length("date") },
+        { "user-agent", header_name_length("user-agent") },
+        { "bootid.upnp.org", header_name_length("bootid.upnp.org") },
+        { "configid.upnp.org", header_name_length("configid.upnp.org") },
+        { "searchport.upnp.org", header_name_length("searchport.upnp.org") },
+        { "sm_id", header_name_length("sm_id") },
+        { "dev_type", header_name_length("dev_type") }
+    };
+    constexpr size_t LSSDP_HEADER_NAME_MAX_LEN = 19;
+    constexpr uint32_t LSSDP_HEADER_SLOTS = 32;
+
+    constexpr unsigned char ascii_lower(unsigned char c)
+    {
+        return static_cast<unsigned char>(static_cast<unsigned char>(c - 'A') < 26 ? c + ('a' - 'A') : c);
+    }
+
+    // the first @p size characters of @p data are @p lower, case insensitive and without the locale lookup
+    inline bool equals_lower(const char* data, const char* lower, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (ascii_lower(static_cast<unsigned char>(data[i])) != static_cast<unsigned char>(lower[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // perfect for the known names: length, first and last character select one slot each
+    constexpr uint32_t header_name_hash(const char* name, size_t size)
+    {
+        return static_cast<uint32_t>(size * 2
+                                     + ascii_lower(static_cast<unsigned char>(name[0])) * 14
+                                     + ascii_lower(static_cast<unsigned char>(name[size - 1])))
+               & (LSSDP_HEADER_SLOTS - 1);
+    }
+
+    struct HeaderSlots
+    {
+        uint8_t         _ids[LSSDP_HEADER_SLOTS];
+    };
+
+    constexpr HeaderSlots create_header_slots()
+    {
+        HeaderSlots slots{};
+        for (uint8_t id = lssdp::header_unknown + 1; id < lssdp::header_count; ++id)
+        {
+            slots._ids[header_name_hash(LSSDP_HEADER_NAMES[id]._name, LSSDP_HEADER_NAMES[id]._size)] = id;
+        }
+        return slots;
+    }
+
+    constexpr HeaderSlots LSSDP_HEADER_SLOT_IDS = create_header_slots();
+
+    constexpr bool header_slots_are_perfect()
+    {
+        for (uint8_t id = lssdp::header_unknown + 1; id < lssdp::header_count; ++id)
+        {
+            const HeaderName& name = LSSDP_HEADER_NAMES[id];
+            if (name._size > LSSDP_HEADER_NAME_MAX_LEN
+                || LSSDP_HEADER_SLOT_IDS._ids[header_name_hash(name._name, name._size)] != id)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(header_slots_are_perfect(), "two SSDP header names share a slot, change header_name_hash");
+
+    // positions of '\n' and ':' within 64 bytes as bit masks
+    struct LineMarks
+    {
+        uint64_t        _newlines;
+        uint64_t        _colons;
+    };
+
+    inline LineMarks scan_line_marks_scalar(const char* block)
+    {
+        LineMarks marks{ 0, 0 };
+        for (unsigned int i = 0; i < 64; ++i)
+        {
+            marks._newlines |= static_cast<uint64_t>(block[i] == '\n') << i;
+            marks._colons |= static_cast<uint64_t>(block[i] == ':') << i;
+        }
+        return marks;
+    }
+
+#if defined(LSSDP_USE_AVX2)
+    inline LineMarks scan_line_marks_avx2(const char* block)
+    {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        const __m256i colon = _mm256_set1_epi8(':');
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+        LineMarks marks;
+        marks._newlines = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline)))
+                          | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)))) << 32;
+        marks._colons = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, colon)))
+                        | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, colon)))) << 32;
+        return marks;
+    }
+#endif
+
+#if defined(LSSDP_USE_AVX2) || defined(LSSDP_USE_SSE2)
+    inline LineMarks scan_line_marks_sse2(const char* block)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i colon = _mm_set1_epi8(':');
+        LineMarks marks{ 0, 0 };
+        for (unsigned int i = 0; i < 64; i += 16)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            marks._newlines |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)))) << i;
+            marks._colons |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, colon)))) << i;
+        }
+        return marks;
+    }
+#endif
+
+    inline unsigned int lowest_bit(uint64_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return static_cast<unsigned int>(index);
+#else
+        return static_cast<unsigned int>(__builtin_ctzll(mask));
+#endif
+    }
+
+    // isprint and isspace of the "C" locale without the locale lookup
+    inline bool is_trimmed(char c)
+    {
+        return static_cast<unsigned char>(c) <= ' ' || static_cast<unsigned char>(c) >= 0x7f;
+    }
+} //namespace detail
+
+/**
+ * @brief the id of the known SSDP header @p name, case insensitive.
+ * @detail one slot of a perfect hash table and one compare, header_unknown for any other name
+ */
+inline HeaderId findHeader(const char* name, size_t size)
+{
+    if (size == 0 || size > detail::LSSDP_HEADER_NAME_MAX_LEN)
+    {
+        return header_unknown;
+    }
+    const uint8_t id = detail::LSSDP_HEADER_SLOT_IDS._ids[detail::header_name_hash(name, size)];
+    const detail::HeaderName& known = detail::LSSDP_HEADER_NAMES[id];
+    if (known._size != size)
+    {
+        return header_unknown;
+    }
+    if (!detail::equals_lower(name, known._name, size))
+    {
+        return header_unknown;
+    }
+    return static_cast<HeaderId>(id);
+}
+
+/**
+ * @brief a decimal number of up to 9 digits at the begin of @p value
+ */
+inline bool parseNumber(const char* value, size_t value_len, uint32_t& number)
+{
+    uint32_t parsed = 0;
+    size_t digits = 0;
+    for (; digits < value_len && isdigit(static_cast<unsigned char>(value[digits])) && digits < 9; digits++) {
+        parsed = parsed * 10 + static_cast<uint32_t>(value[digits] - '0');
+    }
+    if (digits == 0) {
+        return false;
+    }
+    number = parsed;
+    return true;
+}
+
+/**
+ * @brief "max-age = 1800" within the directives of a CACHE-CONTROL value
+ */
+inline bool parseMaxAge(const char* value, size_t value_len, uint32_t& max_age)
+{
+    const size_t directive_len = strlen("max-age");
+    for (size_t i = 0; i + directive_len <= value_len; i++) {
+        if (!detail::equals_lower(&value[i], "max-age", directive_len)) {
+            continue;
+        }
+        size_t j = i + directive_len;
+        while (j < value_len && value[j] == ' ') j++;
+        if (j == value_len || value[j] != '=') {
+            return false;
+        }
+        j++;
+        while (j < value_len && value[j] == ' ') j++;
+        return parseNumber(&value[j], value_len - j, max_age);
+    }
+    return false;
+}
+
+/**
+ * characters within the received datagram, like std::string_view of C++17
+ */
+struct StringRef
+{
+    const char* _data = nullptr;
+    size_t      _size = 0;
+
+    StringRef() = default;
+    StringRef(const char* data, size_t size) : _data(data), _size(size)
+    {
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    bool operator==(const char* other) const
+    {
+        return strlen(other) == _size && memcmp(_data, other, _size) == 0;
+    }
+
+    bool operator==(const std::string& other) const
+    {
+        return other.size() == _size && memcmp(_data, other.data(), _size) == 0;
+    }
+
+    bool operator!=(const char* other) const
+    {
+        return !(*this == other);
+    }
+
+    bool operator!=(const std::string& other) const
+    {
+        return !(*this == other);
+    }
+
+    std::string str() const
+    {
+        return std::string(_data, _size);
+    }
+};
+
+/**
+ * a received SSDP message, the fields refer to the receive buffer:
+ * nothing is copied during the parse and a field which is not read costs nothing,
+ * the receive buffer must outlive the packet.
+ * Each header line is indexed as offsets, any header is found by name through getHeaders()
+ */
+struct LSSDPPacket 
+{
+    enum Method
+    {
+        unknown,
+        msearch,
+        notify,
+        response
+    };
+
+    Method          _method = unknown;                 // M-SEARCH, NOTIFY, RESPONSE
+    StringRef       _st;                               // Search Target
+    StringRef       _usn;                              // Unique Service Name
+    StringRef       _location;                         // Location
+    StringRef       _nts;                              // nts 
+
+    /* Additional SSDP Header Fields */
+    StringRef       _sm_id;
+    StringRef       _device_type;
+
+    std::chrono::system_clock::time_point _update_time;
+    
+    uint32_t        _received_from = 0;
+    /* source port in network byte order, a unicast response goes there */
+    uint16_t        _received_from_port = 0;
+    /* Interface the packet was received on (IP_PKTINFO), 0 if unknown */
+    unsigned int    _interface_index = 0;
+    uint32_t        _local_address = 0;
+    /* CACHE-CONTROL max-age in seconds, 0 if not set */
+    uint32_t        _max_age = 0;
+
+    /* the parsed datagram and its header lines, the index is not initialized beyond the count */
+    const char*     _data = nullptr;
+    size_t          _header_count = 0;
+    MessageHeaders::Entry _headers[LSSDP_MAX_HEADERS];
+
+    /**
+     * all header lines, they refer to the receive buffer like the packet
+     */
+    MessageHeaders getHeaders() const
+    {
+        return MessageHeaders(_data, _headers, _header_count);
+    }
+
+    /**
+     * validates @p data and sets the fields in one pass over it, @p data must outlive the packet.
+     * The parse is driven by @p data_len only: @p data needs no terminating zero and
+     * a zero byte within the datagram is a character like any other.
+     * It scans with the widest vector unit the library is compiled for, defined in lssdpcpp.cpp
+     * so that a user compiled with other flags (i.e. -mavx2) calls the same scanner
+     */
+    bool parse(const char * data, size_t data_len);
+
+    /**
+     * parse with the line scanner @p scan, the tests compare the scalar and the vector scanners
+     */
+    template <detail::LineMarks (*scan)(const char*)>
+    bool parseWith(const char * data, size_t data_len)
+    {
+        if (data == NULL)
+        {
+            return false;
+        }
+        _data = data;
+        _header_count = 0;
+
+        // 1. compare SSDP Method Header: M-SEARCH, NOTIFY, RESPONSE
+        size_t i;
+        if ((i = strlen(LSSDP_HEADER_MSEARCH)) < data_len && memcmp(data, LSSDP_HEADER_MSEARCH, i) == 0) {
+            _method = msearch;
+        }
+        else if ((i = strlen(LSSDP_HEADER_NOTIFY)) < data_len && memcmp(data, LSSDP_HEADER_NOTIFY, i) == 0) {
+            _method = notify;
+        }
+        else if ((i = strlen(LSSDP_HEADER_RESPONSE)) < data_len && memcmp(data, LSSDP_HEADER_RESPONSE, i) == 0) {
+            _method = response;
+        }
+        else
+        {
+            return false;
+        }
+
+        // 2. parse each field line, the CRLF and colon positions of 64 bytes are found at once
+        size_t start = i;
+        size_t colon = NO_COLON;
+        char tail[64];
+        for (size_t block = start; block < data_len; block += 64)
+        {
+            detail::LineMarks marks;
+            if (data_len - block >= 64)
+            {
+                marks = scan(&data[block]);
+            }
+            else
+            {
+                memset(tail, 0, sizeof(tail));
+                memcpy(tail, &data[block], data_len - block);
+                marks = scan(tail);
+            }
+            for (uint64_t found = marks._newlines | marks._colons; found != 0; found &= found - 1)
+            {
+                const unsigned int bit = detail::lowest_bit(found);
+                const size_t position = block + bit;
+                if ((marks._colons >> bit) & 1)
+                {
+                    if (colon == NO_COLON)
+                    {
+                        colon = position;
+                    }
+                }
+                else if (position - 1 > start && data[position - 1] == '\r')
+                {
+                    parse_field_line(data, start, position - 2, colon);
+                    start = position + 1;
+                    colon = NO_COLON;
+                }
+            }
+        }
+        return true;
+    }
+
+    private:
+    constexpr static size_t NO_COLON = static_cast<size_t>(-1);
+
+    // @p colon is the first colon at or after @p start, NO_COLON if the line has none
+    bool parse_field_line(const char * data, size_t start, size_t end, size_t colon) {
+        // 1. the colon, the field name is not empty
+        if (colon == NO_COLON || colon == start)
+        {
+            return false;
+        }
+
+        // 2. get field, field_len
+        size_t i = start;
+        size_t j = colon - 1;
+        if (trim_spaces(data, &i, &j) == -1)
+        {
+            return false;
+        }
+        const char * field = &data[i];
+        size_t field_len = j - i + 1;
+        const HeaderId id = findHeader(field, field_len);
+
+
+        // 3. get value, value_len, a header like EXT has none
+        StringRef value(&data[colon + 1], 0);
+        i = colon + 1;
+        j = end;
+        if (colon != end && trim_spaces(data, &i, &j) == 0)
+        {
+            value = StringRef(&data[i], j - i + 1);
+        }
+        index_header(data, field, field_len, id, value);
+        if (value.empty())
+        {
+            return true;
+        }
+
+
+        // 4. refer to each field's value
+        switch (id)
+        {
+        case header_st:
+        case header_nt:
+            _st = value;
+            return true;
+        case header_usn:
+            _usn = value;
+            return true;
+        case header_location:
+            _location = value;
+            return true;
+        case header_sm_id:
+            _sm_id = value;
+            return true;
+        case header_dev_type:
+            _device_type = value;
+            return true;
+        case header_nts:
+            _nts = value;
+            return true;
+        case header_cache_control:
+            return parseMaxAge(value._data, value._size, _max_age);
+        default:
+            // the field is not in the struct packet, it is found through the header index
+            return false;
+        }
+    }
+
+    void index_header(const char * data, const char * field, size_t field_len, HeaderId id, const StringRef& value) {
+        const size_t value_offset = static_cast<size_t>(value._data - data);
+        if (_header_count == LSSDP_MAX_HEADERS || field_len > UINT8_MAX
+            || value_offset + value._size > UINT16_MAX) {
+            return;
+        }
+        MessageHeaders::Entry& entry = _headers[_header_count++];
+        entry._name_offset = static_cast<uint16_t>(field - data);
+        entry._value_offset = static_cast<uint16_t>(value_offset);
+        entry._value_size = static_cast<uint16_t>(value._size);
+        entry._name_size = static_cast<uint8_t>(field_len);
+        entry._id = id;
+    }
+
+    int trim_spaces(const char * string, size_t * start, size_t * end) {
+        int i = static_cast<int>(*start);
+        int j = static_cast<int>(*end);
+
+        while (i <= static_cast<int>(*end) && detail::is_trimmed(string[i])) i++;
+        while (j >= static_cast<int>(*start) && detail::is_trimmed(string[j])) j--;
+
+        if (i > j) {
+            return -1;
+        }
+
+        *start = i;
+        *end = j;
+        return 0;
+    }
+};
+
+} //namespace lssdp
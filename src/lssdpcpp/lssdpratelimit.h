@@ -0,0 +1,161 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*  
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#pragma once
+
+/*
+ * Internal header of lssdpcpp, it is not installed.
+ * The search rate limiter is shared by the library and its tests, which pass their own time.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    //M-SEARCH responded per second and requester, a control point repeats its search up to 3 times
+    constexpr double LSSDP_DEFAULT_SEARCH_RATE = 10.0;
+    constexpr uint32_t LSSDP_DEFAULT_SEARCH_BURST = 20;
+    //token buckets of the requesters (a power of 2) and the slots probed for one requester
+    constexpr size_t LSSDP_SEARCH_RATE_BUCKETS = 512;
+    constexpr size_t LSSDP_SEARCH_RATE_PROBES = 8;
+    //requesters without a bucket admitted per second over all addresses, and at once
+    constexpr double LSSDP_SEARCH_NEWCOMER_RATE = 50.0;
+    constexpr uint32_t LSSDP_SEARCH_NEWCOMER_BURST = 100;
+}
+
+namespace lssdp
+{
+
+/**********************************************************************************/
+/* Token bucket of each requester address which caps the M-SEARCH responded per   */
+/* second. The buckets are a fixed table with open addressing: a requester is     */
+/* found within LSSDP_SEARCH_RATE_PROBES slots of its hash, a new one takes a free */
+/* slot there or evicts the least recently used. The memory stays bounded for any */
+/* count of source addresses.                                                     */
+/* A requester without a bucket first takes a token of the one newcomer bucket of */
+/* all addresses and then starts with a full bucket of its own: cycling through   */
+/* source addresses is capped by the newcomer rate and does not evict the known    */
+/* requesters while the newcomer bucket is empty.                                 */
+/**********************************************************************************/
+class SearchRateLimiter
+{
+public:
+    SearchRateLimiter() : _buckets(LSSDP_SEARCH_RATE_BUCKETS)
+    {
+    }
+
+    /**
+     * @p searches_per_second of 0 or less responds to each M-SEARCH
+     */
+    void setLimit(double searches_per_second, uint32_t burst)
+    {
+        _rate = searches_per_second;
+        _burst = static_cast<float>(std::max<uint32_t>(burst, 1));
+        std::fill(_buckets.begin(), _buckets.end(), Bucket());
+        _newcomers = Bucket();
+    }
+
+    /**
+     * takes a token of @p requester
+     * @retval false the bucket of @p requester (or of the newcomers) is empty, its M-SEARCH is not responded
+     */
+    bool allow(uint32_t requester, std::chrono::steady_clock::time_point now)
+    {
+        if (_rate <= 0.0)
+        {
+            return true;
+        }
+        size_t first = static_cast<size_t>((requester * 0x9E3779B1u) >> 16) & (LSSDP_SEARCH_RATE_BUCKETS - 1);
+        Bucket* victim = nullptr;
+        for (size_t probe = 0; probe < LSSDP_SEARCH_RATE_PROBES; ++probe)
+        {
+            Bucket& bucket = _buckets[(first + probe) & (LSSDP_SEARCH_RATE_BUCKETS - 1)];
+            if (!bucket._used)
+            {
+                // slots are never freed, a requester behind a free slot does not exist
+                victim = &bucket;
+                break;
+            }
+            if (bucket._address == requester)
+            {
+                return take(bucket, now, _rate, _burst);
+            }
+            if (victim == nullptr || bucket._last_search < victim->_last_search)
+            {
+                victim = &bucket;
+            }
+        }
+        if (!_newcomers._used)
+        {
+            fill(_newcomers, now, static_cast<float>(LSSDP_SEARCH_NEWCOMER_BURST));
+        }
+        if (!take(_newcomers, now, LSSDP_SEARCH_NEWCOMER_RATE, static_cast<float>(LSSDP_SEARCH_NEWCOMER_BURST)))
+        {
+            return false;
+        }
+        fill(*victim, now, _burst);
+        victim->_address = requester;
+        return take(*victim, now, _rate, _burst);
+    }
+
+private:
+    struct Bucket
+    {
+        std::chrono::steady_clock::time_point _last_search;
+        float                                 _tokens = 0.0f;
+        uint32_t                              _address = 0;
+        bool                                  _used = false;
+    };
+
+    static void fill(Bucket& bucket, std::chrono::steady_clock::time_point now, float burst)
+    {
+        bucket._used = true;
+        bucket._tokens = burst;
+        bucket._last_search = now;
+    }
+
+    static bool take(Bucket& bucket, std::chrono::steady_clock::time_point now, double rate, float burst)
+    {
+        double elapsed = std::chrono::duration<double>(now - bucket._last_search).count();
+        if (elapsed > 0.0)
+        {
+            bucket._tokens = static_cast<float>(std::min<double>(burst, bucket._tokens + elapsed * rate));
+        }
+        bucket._last_search = now;
+        if (bucket._tokens < 1.0f)
+        {
+            return false;
+        }
+        bucket._tokens -= 1.0f;
+        return true;
+    }
+
+    double              _rate = LSSDP_DEFAULT_SEARCH_RATE;
+    float               _burst = static_cast<float>(LSSDP_DEFAULT_SEARCH_BURST);
+    std::vector<Bucket> _buckets;
+    Bucket              _newcomers;
+};
+
+} //namespace lssdp
@@ -0,0 +1,364 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*  
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#pragma once
+
+/*
+ * Internal header of lssdpcpp, it is not installed.
+ * The search target index is shared by the library and its benchmarks.
+ */
+
+#include <lssdpcpp/lssdppacket.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    constexpr static const char* const LSSDP_SEARCH_TARGET_ALL = "ssdp:all";
+    constexpr static const char* const LSSDP_SEARCH_TARGET_ROOT_DEVICE = "upnp:rootdevice";
+    constexpr static const char* const LSSDP_USN_ROOT_DEVICE_SUFFIX = "::upnp:rootdevice";
+    constexpr static const char* const LSSDP_UUID_PREFIX = "uuid:";
+    constexpr static const char* const LSSDP_URN_PREFIX = "urn:";
+}
+
+namespace lssdp
+{
+
+/**
+ * the device "uuid:device-UUID" of the USN "uuid:device-UUID::...", empty if it has none
+ */
+inline StringRef getDeviceOfUsn(const StringRef& unique_service_name)
+{
+    const size_t prefix_size = strlen(LSSDP_UUID_PREFIX);
+    if (unique_service_name._size <= prefix_size
+        || memcmp(unique_service_name._data, LSSDP_UUID_PREFIX, prefix_size) != 0)
+    {
+        return StringRef();
+    }
+    size_t device_size = prefix_size;
+    while (device_size < unique_service_name._size
+           && !(unique_service_name._data[device_size] == ':'
+                && device_size + 1 < unique_service_name._size
+                && unique_service_name._data[device_size + 1] == ':'))
+    {
+        ++device_size;
+    }
+    return StringRef(unique_service_name._data, device_size);
+}
+
+/**
+ * "urn:domain:device:type:ver" has the type "urn:domain:device:type" of @p type_size and the version ver
+ */
+inline bool parseUrnVersion(const char* search_target, size_t size, size_t& type_size, uint32_t& version)
+{
+    const size_t prefix_size = strlen(LSSDP_URN_PREFIX);
+    if (size <= prefix_size || !detail::equals_lower(search_target, LSSDP_URN_PREFIX, prefix_size))
+    {
+        return false;
+    }
+    size_t colon = size;
+    while (colon > prefix_size && search_target[colon - 1] != ':')
+    {
+        --colon;
+    }
+    if (colon == prefix_size || colon == size || size - colon > 9)
+    {
+        return false;
+    }
+    for (size_t index = colon; index < size; ++index)
+    {
+        if (!isdigit(static_cast<unsigned char>(search_target[index])))
+        {
+            return false;
+        }
+    }
+    type_size = colon - 1;
+    return parseNumber(&search_target[colon], size - colon, version);
+}
+
+/**
+ * the rules of SearchTargetIndex for a single message of @p search_target and @p unique_service_name,
+ * used to filter the NOTIFY received for the search target @p searched
+ */
+inline bool matchesSearchTarget(const std::string& searched,
+                                const StringRef& search_target,
+                                const StringRef& unique_service_name)
+{
+    if (searched == LSSDP_SEARCH_TARGET_ALL || search_target == searched)
+    {
+        return true;
+    }
+    size_t type_size = 0;
+    uint32_t version = 0;
+    if (parseUrnVersion(searched.data(), searched.size(), type_size, version))
+    {
+        size_t found_type_size = 0;
+        uint32_t found_version = 0;
+        return parseUrnVersion(search_target._data, search_target._size, found_type_size, found_version)
+               && found_type_size == type_size
+               && memcmp(search_target._data, searched.data(), type_size) == 0
+               && found_version >= version;
+    }
+    if (searched == LSSDP_SEARCH_TARGET_ROOT_DEVICE)
+    {
+        const size_t suffix_size = strlen(LSSDP_USN_ROOT_DEVICE_SUFFIX);
+        return unique_service_name._size > suffix_size
+               && memcmp(unique_service_name._data + unique_service_name._size - suffix_size,
+                         LSSDP_USN_ROOT_DEVICE_SUFFIX, suffix_size) == 0;
+    }
+    auto device = getDeviceOfUsn(unique_service_name);
+    return !device.empty() && device == searched;
+}
+
+/**
+ * the ST of a response to an M-SEARCH, it echoes the searched ST (UDA 1.1):
+ *   ssdp:all or the ST of the service    the ST of the service
+ *   urn:domain:device:type:ver           the type of the service with the searched version ver
+ *   upnp:rootdevice                      upnp:rootdevice
+ *   uuid:device-UUID                     the device of the USN of the service
+ */
+struct MatchedSearchTarget
+{
+    enum Kind : uint8_t
+    {
+        own,
+        urn_version,
+        root_device,
+        device
+    };
+
+    Kind     _kind = own;
+    uint32_t _version = 0;   // the searched version of urn_version
+
+    bool operator==(const MatchedSearchTarget& other) const
+    {
+        return _kind == other._kind && _version == other._version;
+    }
+};
+
+/**
+ * the ST to respond with to the M-SEARCH for @p searched which matched a service of @p search_target
+ */
+inline MatchedSearchTarget matchSearchTarget(const StringRef& searched, const std::string& search_target)
+{
+    MatchedSearchTarget matched;
+    if (searched == LSSDP_SEARCH_TARGET_ALL || searched == search_target)
+    {
+        return matched;
+    }
+    size_t type_size = 0;
+    uint32_t version = 0;
+    if (parseUrnVersion(searched._data, searched._size, type_size, version))
+    {
+        matched._kind = MatchedSearchTarget::urn_version;
+        matched._version = version;
+    }
+    else if (searched == LSSDP_SEARCH_TARGET_ROOT_DEVICE)
+    {
+        matched._kind = MatchedSearchTarget::root_device;
+    }
+    else
+    {
+        matched._kind = MatchedSearchTarget::device;
+    }
+    return matched;
+}
+
+/**
+ * a response to the M-SEARCH for @p searched carries the searched ST, unlike a NOTIFY
+ * which announces the later version of a urn type (see matchesSearchTarget)
+ */
+inline bool matchesResponseSearchTarget(const std::string& searched, const StringRef& search_target)
+{
+    return searched == LSSDP_SEARCH_TARGET_ALL || search_target == searched;
+}
+
+/**
+ * the services which match the search target (ST) of an M-SEARCH:
+ *   ssdp:all              every service
+ *   upnp:rootdevice       the services with this ST or a USN ending with ::upnp:rootdevice
+ *   uuid:device-UUID      the services with this ST or the USN of this device (uuid:device-UUID::...)
+ *   urn:domain:device:type:ver, urn:domain:service:type:ver
+ *                         the services of this type with the version ver or a later one
+ *   any other             the services with exactly this ST
+ * and with the DEV_TYPE of the M-SEARCH if it has one.
+ * One hash lookup for each M-SEARCH, the services of a urn type are sorted by their version.
+ */
+class SearchTargetIndex
+{
+public:
+    void add(uint32_t service,
+             const std::string& search_target,
+             const std::string& unique_service_name,
+             const std::string& device_type)
+    {
+        _all.push_back(service);
+        if (_device_types.size() <= service)
+        {
+            _device_types.resize(service + 1);
+        }
+        _device_types[service] = device_type;
+
+        // 1. the ST itself, also for the duplicate check of the owner
+        _exact[search_target].push_back(service);
+
+        // 2. a urn type with its version
+        size_t type_size = 0;
+        uint32_t version = 0;
+        if (parseUrnVersion(search_target.data(), search_target.size(), type_size, version))
+        {
+            auto& versions = _types[search_target.substr(0, type_size)];
+            Versioned versioned{ version, service };
+            versions.insert(std::upper_bound(versions.begin(), versions.end(), versioned,
+                                             [](const Versioned& left, const Versioned& right)
+                                             {
+                                                 return left._version < right._version;
+                                             }),
+                            versioned);
+        }
+
+        // 3. the device of the USN, unless its ST is found by the exact lookup already
+        auto device = getDeviceOfUsn(StringRef(unique_service_name.data(), unique_service_name.size()));
+        if (!device.empty() && device != search_target)
+        {
+            _devices[device.str()].push_back(service);
+        }
+        const size_t suffix_size = strlen(LSSDP_USN_ROOT_DEVICE_SUFFIX);
+        if (search_target != LSSDP_SEARCH_TARGET_ROOT_DEVICE
+            && unique_service_name.size() > suffix_size
+            && unique_service_name.compare(unique_service_name.size() - suffix_size, suffix_size,
+                                           LSSDP_USN_ROOT_DEVICE_SUFFIX) == 0)
+        {
+            _root_devices.push_back(service);
+        }
+    }
+
+    void clear()
+    {
+        _all.clear();
+        _device_types.clear();
+        _exact.clear();
+        _types.clear();
+        _devices.clear();
+        _root_devices.clear();
+    }
+
+    size_t size() const
+    {
+        return _all.size();
+    }
+
+    /**
+     * the services with exactly @p search_target, nullptr if there is none
+     */
+    const std::vector<uint32_t>* findExact(const std::string& search_target) const
+    {
+        auto found = _exact.find(search_target);
+        return (found == _exact.end()) ? nullptr : &found->second;
+    }
+
+    /**
+     * appends the services which match @p search_target and @p device_type (if not empty) to @p matching
+     */
+    void match(const StringRef& search_target, const StringRef& device_type, std::vector<uint32_t>& matching)
+    {
+        const size_t first = matching.size();
+        size_t type_size = 0;
+        uint32_t version = 0;
+        if (search_target == LSSDP_SEARCH_TARGET_ALL)
+        {
+            matching.insert(matching.end(), _all.begin(), _all.end());
+        }
+        else if (parseUrnVersion(search_target._data, search_target._size, type_size, version))
+        {
+            // reuses the capacity of the key
+            _key.assign(search_target._data, type_size);
+            auto found = _types.find(_key);
+            if (found != _types.end())
+            {
+                auto compatible = std::lower_bound(found->second.begin(), found->second.end(), version,
+                                                   [](const Versioned& left, uint32_t right)
+                                                   {
+                                                       return left._version < right;
+                                                   });
+                for (; compatible != found->second.end(); ++compatible)
+                {
+                    matching.push_back(compatible->_service);
+                }
+            }
+        }
+        else
+        {
+            _key.assign(search_target._data, search_target._size);
+            append(_exact, matching);
+            if (search_target == LSSDP_SEARCH_TARGET_ROOT_DEVICE)
+            {
+                matching.insert(matching.end(), _root_devices.begin(), _root_devices.end());
+            }
+            else if (search_target._size > strlen(LSSDP_UUID_PREFIX)
+                     && memcmp(search_target._data, LSSDP_UUID_PREFIX, strlen(LSSDP_UUID_PREFIX)) == 0)
+            {
+                append(_devices, matching);
+            }
+        }
+
+        if (!device_type.empty())
+        {
+            auto filtered = std::remove_if(matching.begin() + first, matching.end(),
+                                           [this, &device_type](uint32_t service)
+                                           {
+                                               return device_type != _device_types[service];
+                                           });
+            matching.erase(filtered, matching.end());
+        }
+    }
+
+private:
+    struct Versioned
+    {
+        uint32_t _version;
+        uint32_t _service;
+    };
+
+    void append(const std::unordered_map<std::string, std::vector<uint32_t>>& index, std::vector<uint32_t>& matching) const
+    {
+        auto found = index.find(_key);
+        if (found != index.end())
+        {
+            matching.insert(matching.end(), found->second.begin(), found->second.end());
+        }
+    }
+
+    std::vector<uint32_t>                                   _all;
+    std::vector<std::string>                                _device_types;
+    std::unordered_map<std::string, std::vector<uint32_t>>  _exact;
+    std::unordered_map<std::string, std::vector<Versioned>> _types;
+    std::unordered_map<std::string, std::vector<uint32_t>>  _devices;
+    std::vector<uint32_t>                                   _root_devices;
+    std::string                                             _key;
+};
+
+} //namespace lssdp
@@ -23,7 +23,74 @@
 #define CATCH_CONFIG_MAIN
 #include "./../../catch/catch.hpp"
 
-#include <lssdpcpp/lssdpcpp.h>
+#include <lssdpcpp/lssdpnetwork.h>
+
+#ifdef __linux__
+#include <net/if.h>     // if_nametoindex
+#include <arpa/inet.h>  // inet_addr
+#include <stdlib.h>     // system
+#include <stdio.h>      // snprintf
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+
+/**
+ * the multicast group @p group is joined on the interface @p name by any socket (/proc/net/igmp)
+ */
+bool isGroupJoined(const std::string& name, const char* group)
+{
+    char group_hex[9];
+    snprintf(group_hex, sizeof(group_hex), "%08X", static_cast<unsigned int>(inet_addr(group)));
+    std::ifstream igmp("/proc/net/igmp");
+    std::string line;
+    bool in_interface = false;
+    while (std::getline(igmp, line))
+    {
+        if (!line.empty() && line[0] != '\t')
+        {
+            // "<index>\t<name>:..." starts the groups of an interface
+            in_interface = (line.find("\t" + name + ":") != std::string::npos);
+        }
+        else if (in_interface && line.find(group_hex) != std::string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * the veth pair lssdptest0/lssdptest1, it is deleted with its addresses when the guard goes out of
+ * scope, also if a REQUIRE failed (needs CAP_NET_ADMIN and iproute2)
+ */
+class VethPair
+{
+public:
+    VethPair()
+    {
+        system("ip link del lssdptest0 2>/dev/null");
+        _created = (system("ip link add lssdptest0 type veth peer name lssdptest1 2>/dev/null") == 0);
+    }
+    ~VethPair()
+    {
+        if (_created)
+        {
+            system("ip link del lssdptest0");
+        }
+    }
+    VethPair(const VethPair&) = delete;
+    VethPair& operator=(const VethPair&) = delete;
+
+    bool isCreated() const
+    {
+        return _created;
+    }
+
+private:
+    bool _created = false;
+};
+#endif
 
 TEST_CASE("TestNetworkInterfaces", "update")
 {
@@ -42,5 +109,124 @@ TEST_CASE("TestNetworkInterfaces", "update")
         updated = lssdp::updateNetworkInterfaces(interfaces);
         REQUIRE_FALSE(updated);
     }
+    SECTION("test watcher deltas")
+    {
+        std::vector<NetworkInterface> interfaces;
+        std::vector<NetworkInterface> added;
+        std::vector<NetworkInterface> removed;
+        NetworkInterfaceWatcher watcher;
+        //the first update reports all interfaces as added
+        REQUIRE(watcher.update(interfaces, added, removed));
+        REQUIRE(added.size() == interfaces.size());
+        REQUIRE(removed.empty());
+
+        //usually this does not change within this short time ;-) 
+        REQUIRE_FALSE(watcher.update(interfaces, added, removed));
+        REQUIRE(added.empty());
+        REQUIRE(removed.empty());
+
+        //the watched interfaces are the enumerated ones
+        std::vector<NetworkInterface> enumerated;
+        lssdp::updateNetworkInterfaces(enumerated);
+        REQUIRE(enumerated.size() == interfaces.size());
+    }
+}
+
+#ifdef __linux__
+//hidden, they change the host networking: only run by the ctest label privileged
+//(cmake variable lssdpcpp_enable_privileged_tests) or with the tag [privileged]
+TEST_CASE("TestNetworkInterfacesVeth", "[.][privileged]")
+{
+    using namespace lssdp;
+    SECTION("test membership stays while the interface has an address")
+    {
+        using namespace std::chrono;
+        //a veth pair with two addresses on one end
+        VethPair veth;
+        REQUIRE(veth.isCreated());
+        REQUIRE(system("ip link set lssdptest1 up") == 0);
+        REQUIRE(system("ip link set lssdptest0 up") == 0);
+        REQUIRE(system("ip addr add 10.201.0.1/32 dev lssdptest0") == 0);
+        REQUIRE(system("ip addr add 10.201.0.2/32 dev lssdptest0") == 0);
+        const unsigned int interface_index = if_nametoindex("lssdptest0");
+        REQUIRE(interface_index > 0);
+
+        //the finder joins the group once for both addresses of lssdptest0
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "membership_target");
+        std::unique_ptr<Service> service(new Service(lssdp::LSSDP_DEFAULT_URL,
+                                                 seconds(1800),
+                                                 "http://localhost::9090",
+                                                 "membership_service",
+                                                 "membership_target",
+                                                 "MyTest",
+                                                 "1.1"));
+
+        //the address the group was joined through goes away, the other one remains
+        REQUIRE(system("ip addr del 10.201.0.1/32 dev lssdptest0") == 0);
+        auto received_on_interface = [&]() -> uint64_t
+        {
+            auto statistics = finder.getStatistics();
+            return (statistics._receive._interface_datagrams.size() > interface_index)
+                ? statistics._receive._interface_datagrams[interface_index]
+                : 0;
+        };
+        finder.checkNetworkChanges();
+        REQUIRE(finder.checkForServices([](const ServiceFinder::ServiceUpdateEvent&) {}, milliseconds(10)));
+        const uint64_t received_before = received_on_interface();
+
+        //the NOTIFY sent through 10.201.0.2 is looped back on lssdptest0
+        REQUIRE(service->sendNotifyAlive());
+        for (int loop = 0; loop < 5 && received_on_interface() == received_before; ++loop)
+        {
+            REQUIRE(finder.checkForServices([](const ServiceFinder::ServiceUpdateEvent&) {}, milliseconds(100)));
+        }
+        REQUIRE(received_on_interface() > received_before);
+
+        //the group is left with the last address of lssdptest0
+        service.reset();
+        REQUIRE(isGroupJoined("lssdptest0", "239.255.255.250"));
+        REQUIRE(system("ip addr del 10.201.0.2/32 dev lssdptest0") == 0);
+        finder.checkNetworkChanges();
+        REQUIRE_FALSE(isGroupJoined("lssdptest0", "239.255.255.250"));
+    }
+    SECTION("test no LOCATION template is sent on an interface it is not rendered for")
+    {
+        using namespace std::chrono;
+        VethPair veth;
+        REQUIRE(veth.isCreated());
+        REQUIRE(system("ip link set lssdptest1 up") == 0);
+        REQUIRE(system("ip link set lssdptest0 up") == 0);
+
+        //the service renders its location for the interfaces before lssdptest0 has an address
+        Service service(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1800),
+                        "http://{ip}:9090/description.xml",
+                        "unrendered_service",
+                        "unrendered_target",
+                        "MyTest",
+                        "1.1");
+        service.setMaxResponseDelay(milliseconds(0));
+        REQUIRE(service.sendNotifyAlive());
+        REQUIRE(system("ip addr add 10.201.0.3/32 dev lssdptest0") == 0);
+
+        std::set<std::string> locations;
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "unrendered_target");
+        REQUIRE(finder.sendMSearch());
+        for (int loop = 0; loop < 3; ++loop)
+        {
+            //false after a send failure
+            service.checkForMSearchAndSendResponse(milliseconds(50));
+            REQUIRE(finder.checkForServices([&](const ServiceFinder::ServiceUpdateEvent& update_event)
+                                            {
+                                                locations.insert(update_event._service_description.getLocationURL());
+                                            },
+                                            milliseconds(50)));
+        }
+
+        //the response to the M-SEARCH from 10.201.0.3 is dropped and counted, not sent with {ip}
+        REQUIRE(service.getStatistics()._response._send_failures > 0);
+        REQUIRE(locations.count("http://{ip}:9090/description.xml") == 0);
+    }
 }
+#endif
    
@@ -0,0 +1,293 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#define CATCH_CONFIG_MAIN
+#include "./../../catch/catch.hpp"
+
+#include <lssdpcpp/lssdppacket.h>
+
+#include <string>
+#include <vector>
+
+#if defined(LSSDP_TEST_AVX2) && !defined(LSSDP_USE_AVX2)
+#error "test_packet_parser_avx2 must be compiled with AVX2 enabled"
+#endif
+
+namespace
+{
+    using namespace lssdp;
+
+    using detail::LineMarks;
+
+    template <LineMarks (*scan)(const char*)>
+    bool parseWith(LSSDPPacket& packet, const char* data, size_t size)
+    {
+        return packet.parseWith<scan>(data, size);
+    }
+
+    /**
+     * one line scanner of the parser, the scalar one is the reference
+     */
+    struct Scanner
+    {
+        const char* _name;
+        bool      (*_parse)(LSSDPPacket&, const char*, size_t);
+    };
+
+    std::vector<Scanner> getScanners()
+    {
+        std::vector<Scanner> scanners;
+        scanners.push_back(Scanner{ "scalar", &parseWith<detail::scan_line_marks_scalar> });
+#if defined(LSSDP_USE_AVX2) || defined(LSSDP_USE_SSE2)
+        scanners.push_back(Scanner{ "sse2", &parseWith<detail::scan_line_marks_sse2> });
+#endif
+#if defined(LSSDP_USE_AVX2)
+        scanners.push_back(Scanner{ "avx2", &parseWith<detail::scan_line_marks_avx2> });
+#endif
+        return scanners;
+    }
+
+    // the widest scanner this test is compiled for, chosen here and not in the header
+    LineMarks scanWidest(const char* block)
+    {
+#if defined(LSSDP_USE_AVX2)
+        return detail::scan_line_marks_avx2(block);
+#elif defined(LSSDP_USE_SSE2)
+        return detail::scan_line_marks_sse2(block);
+#else
+        return detail::scan_line_marks_scalar(block);
+#endif
+    }
+
+    bool sameRef(const StringRef& left, const StringRef& right)
+    {
+        return left._data == right._data && left._size == right._size;
+    }
+
+    bool samePacket(bool left_parsed, const LSSDPPacket& left, bool right_parsed, const LSSDPPacket& right)
+    {
+        if (left_parsed != right_parsed
+            || left._method != right._method
+            || !sameRef(left._st, right._st)
+            || !sameRef(left._usn, right._usn)
+            || !sameRef(left._location, right._location)
+            || !sameRef(left._nts, right._nts)
+            || !sameRef(left._sm_id, right._sm_id)
+            || !sameRef(left._device_type, right._device_type)
+            || left._max_age != right._max_age
+            || left._header_count != right._header_count)
+        {
+            return false;
+        }
+        for (size_t index = 0; index < left._header_count; ++index)
+        {
+            const MessageHeaders::Entry& left_entry = left._headers[index];
+            const MessageHeaders::Entry& right_entry = right._headers[index];
+            if (left_entry._name_offset != right_entry._name_offset
+                || left_entry._name_size != right_entry._name_size
+                || left_entry._value_offset != right_entry._value_offset
+                || left_entry._value_size != right_entry._value_size
+                || left_entry._id != right_entry._id)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * parses @p datagram and each of its truncations with all scanners,
+     * the vector scanners must yield what the scalar one yields
+     */
+    void requireScannersAgree(const std::string& datagram)
+    {
+        const auto scanners = getScanners();
+        for (size_t size = 0; size <= datagram.size(); ++size)
+        {
+            LSSDPPacket reference;
+            const bool reference_parsed = scanners[0]._parse(reference, datagram.data(), size);
+            for (size_t index = 1; index < scanners.size(); ++index)
+            {
+                LSSDPPacket packet;
+                const bool parsed = scanners[index]._parse(packet, datagram.data(), size);
+                INFO("scanner " << scanners[index]._name << ", " << size << " of " << datagram.size() << " bytes");
+                REQUIRE(samePacket(reference_parsed, reference, parsed, packet));
+            }
+        }
+    }
+
+    LSSDPPacket parseFully(const std::string& datagram)
+    {
+        LSSDPPacket packet;
+        REQUIRE(packet.parse(datagram.data(), datagram.size()));
+        return packet;
+    }
+}
+
+TEST_CASE("TestPacketParser", "scanners")
+{
+    SECTION("the vector scanners find what the scalar one finds")
+    {
+        const auto scanners = getScanners();
+#if defined(LSSDP_TEST_AVX2)
+        REQUIRE(scanners.size() == 3);
+#endif
+        // every byte value at every position of a block
+        std::vector<char> block(64);
+        for (unsigned int value = 0; value < 256; ++value)
+        {
+            for (size_t position = 0; position < block.size(); ++position)
+            {
+                std::fill(block.begin(), block.end(), 'a');
+                block[position] = static_cast<char>(value);
+                block[(position * 7) % block.size()] = (value & 1) ? '\n' : ':';
+                const LineMarks reference = detail::scan_line_marks_scalar(block.data());
+                const LineMarks marks = scanWidest(block.data());
+                REQUIRE(marks._newlines == reference._newlines);
+                REQUIRE(marks._colons == reference._colons);
+            }
+        }
+    }
+    SECTION("a complete NOTIFY")
+    {
+        const std::string datagram =
+            "NOTIFY * HTTP/1.1\r\n"
+            "HOST: 239.255.255.250:1900\r\n"
+            "CACHE-CONTROL: max-age=1800\r\n"
+            "LOCATION: http://192.168.1.2:8080/description.xml\r\n"
+            "NT: urn:schemas-upnp-org:device:Basic:1\r\n"
+            "NTS: ssdp:alive\r\n"
+            "SERVER: Linux/5.4 UPnP/1.1 MyTest/1.1\r\n"
+            "USN: uuid:2fac1234-31f8-11b4-a222-08002b34c003::urn:schemas-upnp-org:device:Basic:1\r\n"
+            "SM_ID: 42\r\n"
+            "DEV_TYPE: test\r\n"
+            "\r\n";
+        requireScannersAgree(datagram);
+        LSSDPPacket packet = parseFully(datagram);
+        REQUIRE(packet._method == LSSDPPacket::notify);
+        REQUIRE(packet._nts == "ssdp:alive");
+        REQUIRE(packet._max_age == 1800);
+        REQUIRE(packet._header_count == 9);
+    }
+    SECTION("a bare LF does not end a line")
+    {
+        const std::string datagram =
+            "NOTIFY * HTTP/1.1\r\n"
+            "HOST: 239.255.255.250:1900\nNT: bare_lf\r\n"
+            "USN: bare_lf_usn\n"
+            "NTS: ssdp:alive\r\n"
+            "\n\r\n";
+        requireScannersAgree(datagram);
+        LSSDPPacket packet = parseFully(datagram);
+        REQUIRE(packet._st.empty());
+        REQUIRE(packet._usn == "bare_lf_usn\nNTS: ssdp:alive");
+        REQUIRE(packet._header_count == 2);
+    }
+    SECTION("empty values and an empty line")
+    {
+        const std::string datagram =
+            "HTTP/1.1 200 OK\r\n"
+            "EXT:\r\n"
+            "ST:    \r\n"
+            "LOCATION:\t\r\n"
+            ": no name\r\n"
+            "\r\n"
+            "USN: after_the_empty_line\r\n"
+            "\r\n";
+        requireScannersAgree(datagram);
+        LSSDPPacket packet = parseFully(datagram);
+        REQUIRE(packet._method == LSSDPPacket::response);
+        REQUIRE(packet._st.empty());
+        REQUIRE(packet._location.empty());
+        REQUIRE(packet._usn == "after_the_empty_line");
+        REQUIRE(packet._header_count == 4);
+        REQUIRE(packet._headers[0]._value_size == 0);
+    }
+    SECTION("an embedded zero byte")
+    {
+        const char raw[] =
+            "NOTIFY * HTTP/1.1\r\n"
+            "USN: uuid:zero\0byte\r\n"
+            "NT: zero\0:colon\r\n"
+            "\r\n";
+        const std::string datagram(raw, sizeof(raw) - 1);
+        requireScannersAgree(datagram);
+        LSSDPPacket packet = parseFully(datagram);
+        REQUIRE(packet._usn == std::string("uuid:zero\0byte", 14));
+        REQUIRE(packet._st == std::string("zero\0:colon", 11));
+    }
+    SECTION("long lines and lines crossing a block")
+    {
+        const std::string header = "M-SEARCH * HTTP/1.1\r\n";
+        // the CRLF and the colon of the second line move over each position of a block
+        for (size_t padding = 0; padding < 130; ++padding)
+        {
+            const std::string location = "http://host/" + std::string(padding, 'p');
+            const std::string datagram = header
+                + "LOCATION: " + location + "\r\n"
+                + std::string(padding % 67, 'X') + ": padding\r\n"
+                + "ST: ssdp:all\r\n"
+                + "\r\n";
+            requireScannersAgree(datagram);
+            LSSDPPacket packet = parseFully(datagram);
+            REQUIRE(packet._location == location);
+            REQUIRE(packet._st == "ssdp:all");
+        }
+        const std::string server(300, 's');
+        const std::string datagram = header + "SERVER: " + server + "\r\nST: ssdp:all\r\n\r\n";
+        requireScannersAgree(datagram);
+        LSSDPPacket packet = parseFully(datagram);
+        REQUIRE(packet.getHeaders().getHeader("server") == server);
+    }
+    SECTION("more header lines than indexed")
+    {
+        std::string datagram = "NOTIFY * HTTP/1.1\r\n";
+        for (size_t line = 0; line < LSSDP_MAX_HEADERS + 8; ++line)
+        {
+            datagram += "X-HEADER-" + std::to_string(line) + ": " + std::to_string(line) + "\r\n";
+        }
+        datagram += "USN: beyond_the_index\r\n\r\n";
+        requireScannersAgree(datagram);
+        LSSDPPacket packet = parseFully(datagram);
+        REQUIRE(packet._header_count == LSSDP_MAX_HEADERS);
+        // the fields are still parsed
+        REQUIRE(packet._usn == "beyond_the_index");
+    }
+    SECTION("truncated datagrams")
+    {
+        const std::string datagram =
+            "HTTP/1.1 200 OK\r\n"
+            "ST: truncated\r\n"
+            "USN: truncated_usn\r\n";
+        // each truncation is compared by requireScannersAgree as well
+        requireScannersAgree(datagram);
+        LSSDPPacket packet;
+        REQUIRE_FALSE(packet.parse(datagram.data(), 10));
+        LSSDPPacket cut_in_line;
+        REQUIRE(cut_in_line.parse(datagram.data(), datagram.size() - 4));
+        REQUIRE(cut_in_line._st == "truncated");
+        REQUIRE(cut_in_line._usn.empty());
+        LSSDPPacket cut_in_crlf;
+        REQUIRE(cut_in_crlf.parse(datagram.data(), datagram.size() - 1));
+        REQUIRE(cut_in_crlf._usn.empty());
+    }
+}
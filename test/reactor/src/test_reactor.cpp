@@ -0,0 +1,127 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#define CATCH_CONFIG_MAIN
+#include "./../../catch/catch.hpp"
+
+#include <lssdpcpp/lssdpcpp.h>
+
+TEST_CASE("TestReactor", "run")
+{
+    using namespace lssdp;
+    using namespace std::chrono;
+    SECTION("wait until the deadline")
+    {
+        Service service(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1800),
+                        "http://localhost::9090",
+                        "reactor_deadline_service",
+                        "reactor_deadline_target",
+                        "MyTest",
+                        "1.1");
+        Reactor reactor;
+        reactor.add(service);
+
+        auto begin_time = steady_clock::now();
+        REQUIRE(reactor.run(milliseconds(250)));
+        auto waited = steady_clock::now() - begin_time;
+        REQUIRE(waited >= milliseconds(250));
+        REQUIRE(waited < milliseconds(350));
+
+        begin_time = steady_clock::now();
+        REQUIRE(service.checkForMSearchAndSendResponse(milliseconds(30)));
+        waited = steady_clock::now() - begin_time;
+        REQUIRE(waited >= milliseconds(30));
+        REQUIRE(waited < milliseconds(100));
+
+        reactor.remove(service);
+    }
+    SECTION("services and finder in one wait")
+    {
+        Service service1(lssdp::LSSDP_DEFAULT_URL,
+                         seconds(1800),
+                         "http://localhost::9090",
+                         "reactor_service1",
+                         "reactor_search_target",
+                         "MyTest",
+                         "1.1");
+        Service service2(lssdp::LSSDP_DEFAULT_URL,
+                         seconds(1800),
+                         "http://localhost::9090",
+                         "reactor_service2",
+                         "reactor_search_target",
+                         "MyTest",
+                         "1.1");
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "reactor_search_target");
+        //does not search, the responses are sent by unicast to the finder only
+        ServiceFinder bystander(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "reactor_search_target");
+
+        //the responses are spread within 100 ms instead of the MX of 5 seconds
+        service1.setMaxResponseDelay(milliseconds(100));
+        service2.setMaxResponseDelay(milliseconds(100));
+
+        int count_alive = 0;
+        int count_response = 0;
+        int count_bystander_response = 0;
+        Reactor reactor;
+        reactor.add(service1);
+        reactor.add(service2);
+        reactor.add(finder,
+            [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+            {
+                if (update_event._event_id == ServiceFinder::ServiceUpdateEvent::notify_alive)
+                {
+                    ++count_alive;
+                }
+                else if (update_event._event_id == ServiceFinder::ServiceUpdateEvent::response)
+                {
+                    ++count_response;
+                }
+            });
+        reactor.add(bystander,
+            [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+            {
+                if (update_event._event_id == ServiceFinder::ServiceUpdateEvent::response)
+                {
+                    ++count_bystander_response;
+                }
+            });
+
+        REQUIRE(service1.sendNotifyAlive());
+        REQUIRE(service2.sendNotifyAlive());
+        REQUIRE(finder.sendMSearch());
+        //the reactor wakes for the delayed responses
+        for (int loop = 0; loop < 5 && (count_alive < 2 || count_response < 2); ++loop)
+        {
+            REQUIRE(reactor.run(milliseconds(200)));
+        }
+        REQUIRE(count_alive >= 2);
+        REQUIRE(count_response >= 2);
+        REQUIRE(count_bystander_response == 0);
+        REQUIRE(finder.getStatistics()._unicast_receive._datagrams_received >= 2);
+
+        reactor.remove(bystander);
+        reactor.remove(finder);
+        reactor.remove(service2);
+        reactor.remove(service1);
+    }
+}
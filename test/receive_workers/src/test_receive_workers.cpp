@@ -0,0 +1,116 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#define CATCH_CONFIG_MAIN
+#include "./../../catch/catch.hpp"
+
+#include <lssdpcpp/lssdpcpp.h>
+
+#include <thread>
+
+TEST_CASE("TestReceiveWorkers", "checkForServices")
+{
+    using namespace lssdp;
+    using namespace std::chrono;
+
+    Service service(lssdp::LSSDP_DEFAULT_URL,
+                    seconds(1800),
+                    "http://localhost::9090",
+                    "receive_workers_service",
+                    "receive_workers_target",
+                    "MyTest",
+                    "1.1");
+    ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "receive_workers_target");
+    if (!finder.setReceiveWorkers(4))
+    {
+        WARN("receive workers are not supported on this platform");
+        return;
+    }
+
+    int count_alive = 0;
+    int count_byebye = 0;
+    ServiceFinder::ServiceUpdateEvent::UpdateEvent last_event = ServiceFinder::ServiceUpdateEvent::response;
+    auto update_callback = [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+    {
+        REQUIRE(update_event._service_description.getUniqueServiceName() == "receive_workers_service");
+        if (update_event._event_id == ServiceFinder::ServiceUpdateEvent::notify_alive)
+        {
+            ++count_alive;
+        }
+        else if (update_event._event_id == ServiceFinder::ServiceUpdateEvent::notify_byebye)
+        {
+            ++count_byebye;
+        }
+        last_event = update_event._event_id;
+    };
+
+    for (int loop = 0; loop < 10; ++loop)
+    {
+        REQUIRE(service.sendNotifyAlive());
+    }
+    std::this_thread::sleep_for(milliseconds(50));
+    REQUIRE(service.sendNotifyByeBye());
+    for (int loop = 0; loop < 5 && count_byebye == 0; ++loop)
+    {
+        REQUIRE(finder.checkForServices(update_callback, milliseconds(200)));
+    }
+
+    //the events of one USN are delivered in receive order, byebye was the last one sent
+    REQUIRE(count_alive > 0);
+    REQUIRE(count_byebye > 0);
+    REQUIRE(last_event == ServiceFinder::ServiceUpdateEvent::notify_byebye);
+
+    auto statistics = finder.getStatistics();
+    REQUIRE(statistics._receive._batches > 0);
+    REQUIRE(statistics._receive._datagrams_received >= static_cast<uint64_t>(count_alive + count_byebye));
+
+    //back to receiving on the calling thread
+    REQUIRE(finder.setReceiveWorkers(1));
+    REQUIRE(service.sendNotifyAlive());
+    count_alive = 0;
+    for (int loop = 0; loop < 5 && count_alive == 0; ++loop)
+    {
+        REQUIRE(finder.checkForServices(update_callback, milliseconds(200)));
+    }
+    REQUIRE(count_alive > 0);
+
+    //the workers pinned to the first CPU, a CPU out of range is refused
+    REQUIRE(finder.setReceiveWorkers(2, std::vector<unsigned int>{ 0 }));
+    REQUIRE(service.sendNotifyAlive());
+    count_alive = 0;
+    for (int loop = 0; loop < 5 && count_alive == 0; ++loop)
+    {
+        REQUIRE(finder.checkForServices(update_callback, milliseconds(200)));
+    }
+    REQUIRE(count_alive > 0);
+    REQUIRE_THROWS(finder.setReceiveWorkers(2, std::vector<unsigned int>{ 1u << 20 }));
+
+    //the refused call keeps the workers of before, the finder still receives
+    REQUIRE(service.sendNotifyAlive());
+    count_alive = 0;
+    for (int loop = 0; loop < 5 && count_alive == 0; ++loop)
+    {
+        REQUIRE(finder.checkForServices(update_callback, milliseconds(200)));
+    }
+    REQUIRE(count_alive > 0);
+    REQUIRE(finder.setReceiveWorkers(1));
+}
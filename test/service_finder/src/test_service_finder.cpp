@@ -25,6 +25,8 @@
 
 #include <lssdpcpp/lssdpcpp.h>
 
+#include <set>
+
 struct EventCounter
 {
     void countFor(const lssdp::Service& service,
@@ -148,6 +150,358 @@ TEST_CASE("TestServiceFinder", "checkForServices")
         REQUIRE(service2_counter._count_byebye > 0);
         REQUIRE(service2_counter._count_response > 0);
 
+        //the send sockets are reused for each datagram
+        auto service1_statistics = service1.getStatistics();
+        REQUIRE(service1_statistics._notify._datagrams_sent > 0);
+        REQUIRE(service1_statistics._notify._syscalls_saved > 0);
+        REQUIRE(service1_statistics._send_sockets_opened > 0);
+        auto finder_statistics = finder.getStatistics();
+        REQUIRE(finder_statistics._msearch._datagrams_sent > 0);
+        REQUIRE(finder_statistics._msearch._syscalls_saved > 0);
+        //each wakeup drains a batch of datagrams
+        REQUIRE(finder_statistics._receive._batches > 0);
+        REQUIRE(finder_statistics._receive._datagrams_received > 0);
+#ifdef __linux__
+        //IP_PKTINFO attributes each datagram to its interface
+        uint64_t attributed = 0;
+        for (auto count : finder_statistics._receive._interface_datagrams)
+        {
+            attributed += count;
+        }
+        REQUIRE(attributed > 0);
+        //the responses went out on the interface the M-SEARCH came in on
+        REQUIRE(service1.getStatistics()._response._send_failures == 0);
+#endif
+
+    }
+    SECTION("queued messages are flushed as one batch")
+    {
+        Service service(lssdp::LSSDP_DEFAULT_URL,
+                        std::chrono::seconds(1800),
+                        "http://localhost::9090",
+                        "queued_service",
+                        "queued_search_target",
+                        "MyTest",
+                        "1.1");
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "queued_search_target");
+
+        //nothing leaves before the flush
+        service.queueNotifyByeBye();
+        service.queueNotifyAlive();
+        REQUIRE(service.getStatistics()._notify._datagrams_sent == 0);
+        REQUIRE(service.flush());
+        auto notify_statistics = service.getStatistics()._notify;
+        REQUIRE(notify_statistics._datagrams_sent >= 2);
+        REQUIRE(notify_statistics._datagrams_sent % 2 == 0);
+        REQUIRE(notify_statistics._send_failures == 0);
+        //an empty queue sends nothing
+        REQUIRE(service.flush());
+        REQUIRE(service.getStatistics()._notify._datagrams_sent == notify_statistics._datagrams_sent);
+
+        finder.queueMSearch();
+        finder.queueMSearch();
+        REQUIRE(finder.getStatistics()._msearch._datagrams_sent == 0);
+        REQUIRE(finder.flush());
+        auto msearch_statistics = finder.getStatistics()._msearch;
+        REQUIRE(msearch_statistics._datagrams_sent >= 2);
+        REQUIRE(msearch_statistics._datagrams_sent % 2 == 0);
+#ifdef __linux__
+        //byebye and alive (both searches) of all interfaces in one sendmmsg
+        REQUIRE(notify_statistics._syscalls < notify_statistics._datagrams_sent);
+        REQUIRE(msearch_statistics._syscalls < msearch_statistics._datagrams_sent);
+#endif
+    }
+    SECTION("service cache expires the max-age")
+    {
+        using namespace std::chrono;
+        Service short_lived(lssdp::LSSDP_DEFAULT_URL,
+                            seconds(1),
+                            "http://localhost::9090",
+                            "cache_short_lived",
+                            "cache_search_target",
+                            "MyTest",
+                            "1.1");
+        Service leaving(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1800),
+                        "http://localhost::9090",
+                        "cache_leaving",
+                        "cache_search_target",
+                        "MyTest",
+                        "1.1");
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "cache_search_target");
+        finder.setServiceCache(true);
+
+        std::vector<ServiceFinder::ServiceUpdateEvent> service_events;
+        auto collect = [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+        {
+            service_events.push_back(update_event);
+        };
+        REQUIRE(short_lived.sendNotifyAlive());
+        REQUIRE(leaving.sendNotifyAlive());
+        REQUIRE(finder.checkForServices(collect, milliseconds(200)));
+        REQUIRE(finder.getServices().size() == 2);
+
+        //the byebye removes the service without an expired event
+        REQUIRE(leaving.sendNotifyByeBye());
+        int count_expired = 0;
+        auto first_time = steady_clock::now();
+        while (count_expired == 0 && steady_clock::now() - first_time < seconds(5))
+        {
+            REQUIRE(finder.checkForServices(collect, milliseconds(100)));
+            count_expired = 0;
+            for (const auto& current_event : service_events)
+            {
+                if (current_event._event_id == ServiceFinder::ServiceUpdateEvent::expired)
+                {
+                    REQUIRE(short_lived == current_event._service_description);
+                    ++count_expired;
+                }
+            }
+        }
+        //expires within the max-age and the 1 second tick
+        REQUIRE(count_expired == 1);
+        REQUIRE(steady_clock::now() - first_time < seconds(3));
+        REQUIRE(finder.getServices().empty());
+        //CACHE-CONTROL is parsed
+        for (const auto& current_event : service_events)
+        {
+            if (current_event._event_id == ServiceFinder::ServiceUpdateEvent::notify_alive)
+            {
+                REQUIRE(current_event._max_age == (short_lived == current_event._service_description ? seconds(1) : seconds(1800)));
+            }
+        }
+    }
+    SECTION("delta events suppress repeated announcements")
+    {
+        using namespace std::chrono;
+        Service service(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1800),
+                        "http://localhost::9090",
+                        "delta_service",
+                        "delta_search_target",
+                        "MyTest",
+                        "1.1");
+        //same USN, the LOCATION moved
+        Service moved(lssdp::LSSDP_DEFAULT_URL,
+                      seconds(1800),
+                      "http://localhost::9191",
+                      "delta_service",
+                      "delta_search_target",
+                      "MyTest",
+                      "1.1");
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "delta_search_target");
+        finder.setDeltaEvents(true);
+
+        std::vector<ServiceFinder::ServiceUpdateEvent> service_events;
+        auto collect = [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+        {
+            service_events.push_back(update_event);
+        };
+        for (int repeat = 0; repeat < 5; ++repeat)
+        {
+            REQUIRE(service.sendNotifyAlive());
+            REQUIRE(finder.checkForServices(collect, milliseconds(50)));
+        }
+        REQUIRE(service_events.size() == 1);
+        REQUIRE(service_events.back()._event_id == ServiceFinder::ServiceUpdateEvent::notify_alive);
+        REQUIRE(finder.getStatistics()._suppressed_events >= 4);
+
+        REQUIRE(moved.sendNotifyAlive());
+        REQUIRE(finder.checkForServices(collect, milliseconds(200)));
+        REQUIRE(service_events.size() == 2);
+        REQUIRE(service_events.back()._service_description.getLocationURL() == "http://localhost::9191");
+
+        //the byebye of each interface is informed once
+        REQUIRE(moved.sendNotifyByeBye());
+        REQUIRE(finder.checkForServices(collect, milliseconds(200)));
+        REQUIRE(service_events.size() == 3);
+        REQUIRE(service_events.back()._event_id == ServiceFinder::ServiceUpdateEvent::notify_byebye);
+        //without setServiceCache only the hashes are kept
+        REQUIRE(finder.getServices().empty());
+
+        //the byebye of a service not seen before passes, once
+        Service unknown(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1800),
+                        "http://localhost::9292",
+                        "delta_unknown_service",
+                        "delta_search_target",
+                        "MyTest",
+                        "1.1");
+        REQUIRE(unknown.sendNotifyByeBye());
+        REQUIRE(finder.checkForServices(collect, milliseconds(200)));
+        REQUIRE(service_events.size() == 4);
+        REQUIRE(service_events.back()._event_id == ServiceFinder::ServiceUpdateEvent::notify_byebye);
+        REQUIRE(service_events.back()._service_description.getUniqueServiceName() == "delta_unknown_service");
+    }
+    SECTION("all headers are found by name")
+    {
+        using namespace std::chrono;
+        Service service(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1200),
+                        "http://localhost::9090",
+                        "headers_service",
+                        "headers_search_target",
+                        "MyTest",
+                        "1.1");
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "headers_search_target");
+        //the response is sent within the wait of the service
+        service.setMaxResponseDelay(milliseconds(50));
+
+        std::vector<ServiceFinder::ServiceUpdateEvent> service_events;
+        int count_in_callback = 0;
+        auto collect = [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+        {
+            //refers to the receive buffer within the callback
+            REQUIRE(update_event._headers.getHeader("server").find("MyTest/1.1") != std::string::npos);
+            ++count_in_callback;
+            service_events.push_back(update_event);
+        };
+        REQUIRE(service.sendNotifyAlive());
+        REQUIRE(finder.sendMSearch());
+        REQUIRE(service.checkForMSearchAndSendResponse(milliseconds(200)));
+        REQUIRE(finder.checkForServices(collect, milliseconds(200)));
+        REQUIRE(count_in_callback > 0);
+
+        //the copies own the header lines
+        bool found_alive = false;
+        bool found_response = false;
+        for (const auto& current_event : service_events)
+        {
+            const MessageHeaders& headers = current_event._headers;
+            seconds max_age;
+            REQUIRE(headers.getMaxAge(max_age));
+            REQUIRE(max_age == seconds(1200));
+            REQUIRE(headers.getHeader("Cache-Control") == "max-age=1200");
+            REQUIRE(headers.getHeader("USN") == "headers_service");
+            REQUIRE(headers.getHeader("SERVER").find("MyTest/1.1") != std::string::npos);
+            std::string value;
+            REQUIRE_FALSE(headers.getHeader("X-Not-Sent", value));
+            seconds mx;
+            REQUIRE_FALSE(headers.getMx(mx));
+            uint32_t boot_id;
+            REQUIRE_FALSE(headers.getBootId(boot_id));
+            for (size_t index = 0; index < headers.size(); ++index)
+            {
+                REQUIRE_FALSE(headers.getName(index).empty());
+            }
+            if (current_event._event_id == ServiceFinder::ServiceUpdateEvent::notify_alive)
+            {
+                found_alive = true;
+                REQUIRE(headers.getHeader("nts") == "ssdp:alive");
+            }
+            else if (current_event._event_id == ServiceFinder::ServiceUpdateEvent::response)
+            {
+                found_response = true;
+                //EXT has no value
+                REQUIRE(headers.getHeader("ext", value));
+                REQUIRE(value.empty());
+                REQUIRE(headers.getName(0) == "CACHE-CONTROL");
+                //the RFC 1123 date of the send, i.e. "Sun, 06 Nov 1994 08:49:37 GMT"
+                std::string date = headers.getHeader("date");
+                REQUIRE(date.size() == 29);
+                REQUIRE(date.substr(25) == " GMT");
+            }
+        }
+        REQUIRE(found_alive);
+        REQUIRE(found_response);
+
+        //a copy of a copy shares its header lines and outlives the first copy
+        MessageHeaders shared;
+        {
+            std::vector<ServiceFinder::ServiceUpdateEvent> copied = service_events;
+            service_events.clear();
+            shared = copied.front()._headers;
+        }
+        REQUIRE(shared.getHeader("USN") == "headers_service");
+        REQUIRE(shared.getHeader("cache-control") == "max-age=1200");
+    }
+    SECTION("LOCATION is rendered for each interface")
+    {
+        using namespace std::chrono;
+        Service service(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1800),
+                        "http://{ip}:9090/description.xml",
+                        "location_service",
+                        "location_search_target",
+                        "MyTest",
+                        "1.1");
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "location_search_target");
+        service.setMaxResponseDelay(milliseconds(50));
+
+        std::vector<NetworkInterface> interfaces;
+        lssdp::updateNetworkInterfaces(interfaces);
+        std::set<std::string> expected_locations;
+        for (const auto& current_interface : interfaces)
+        {
+            expected_locations.insert("http://" + current_interface.getIp4() + ":9090/description.xml");
+        }
+
+        std::set<std::string> locations;
+        auto collect = [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+        {
+            locations.insert(update_event._service_description.getLocationURL());
+        };
+        REQUIRE(service.sendNotifyAlive());
+        REQUIRE(finder.sendMSearch());
+        REQUIRE(service.checkForMSearchAndSendResponse(milliseconds(200)));
+        REQUIRE(finder.checkForServices(collect, milliseconds(200)));
+
+        //each NOTIFY and response carries the address of the interface it was sent on
+        REQUIRE_FALSE(locations.empty());
+        for (const auto& location : locations)
+        {
+            REQUIRE(expected_locations.count(location) == 1);
+        }
+    }
+    SECTION("the boot id is filled into the prepared messages")
+    {
+        using namespace std::chrono;
+        Service service(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1800),
+                        "http://localhost::9090",
+                        "boot_id_service",
+                        "boot_id_search_target",
+                        "MyTest",
+                        "1.1");
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "boot_id_search_target");
+        service.setMaxResponseDelay(milliseconds(0));
+
+        std::set<uint32_t> boot_ids;
+        int count_without_boot_id = 0;
+        auto collect = [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+        {
+            uint32_t boot_id = 0;
+            if (update_event._headers.getBootId(boot_id))
+            {
+                boot_ids.insert(boot_id);
+            }
+            else
+            {
+                ++count_without_boot_id;
+            }
+            //the slots are spliced between the static segments
+            REQUIRE(update_event._headers.getHeader("USN") == "boot_id_service");
+            if (update_event._event_id != ServiceFinder::ServiceUpdateEvent::notify_byebye)
+            {
+                REQUIRE(update_event._service_description.getLocationURL() == "http://localhost::9090");
+            }
+        };
+        service.setBootId(7);
+        REQUIRE(service.sendNotifyAlive());
+        REQUIRE(finder.sendMSearch());
+        REQUIRE(service.checkForMSearchAndSendResponse(milliseconds(100)));
+        REQUIRE(finder.checkForServices(collect, milliseconds(100)));
+        REQUIRE(boot_ids == std::set<uint32_t>({ 7 }));
+
+        service.setBootId(8);
+        REQUIRE(service.sendNotifyByeBye());
+        REQUIRE(finder.checkForServices(collect, milliseconds(100)));
+        REQUIRE(boot_ids == std::set<uint32_t>({ 7, 8 }));
+
+        service.setBootId(0);
+        REQUIRE(service.sendNotifyAlive());
+        REQUIRE(finder.checkForServices(collect, milliseconds(100)));
+        REQUIRE(count_without_boot_id > 0);
     }
 }
    
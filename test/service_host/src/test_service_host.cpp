@@ -0,0 +1,376 @@
+/******************************************************************************************
+*
+*  Copyright 2020 Pierre Voigtlaender(jeanreP)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this
+* software and associated documentation files(the "Software"), to deal in the Software
+* without restriction, including without limitation the rights to use, copy, modify,
+* merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies
+* or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+* PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************************/
+#define CATCH_CONFIG_MAIN
+#include "./../../catch/catch.hpp"
+
+#include <lssdpcpp/lssdpcpp.h>
+#include <lssdpcpp/lssdpratelimit.h>
+
+#ifdef __linux__
+#include <arpa/inet.h>  // inet_addr, htons
+#include <sys/socket.h>
+#include <sys/time.h>   // timeval
+#include <unistd.h>     // close
+#include <string.h>     // memset
+#endif
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+
+TEST_CASE("TestServiceHost", "checkForMSearchAndSendResponse")
+{
+    using namespace lssdp;
+    using namespace std::chrono;
+    SECTION("add and remove services")
+    {
+        ServiceHost host(lssdp::LSSDP_DEFAULT_URL, seconds(1800));
+        ServiceDescription service("http://localhost::9090", "host_service", "host_target", "MyTest", "1.1");
+        REQUIRE(host.addService(service));
+        REQUIRE_FALSE(host.addService(service));
+        REQUIRE(host.getServices().size() == 1);
+        REQUIRE(host.removeService(service));
+        REQUIRE_FALSE(host.removeService(service));
+        REQUIRE(host.getServices().empty());
+    }
+    SECTION("one M-SEARCH answered for all matching services")
+    {
+        ServiceHost host(lssdp::LSSDP_DEFAULT_URL, seconds(1800));
+        for (int index = 0; index < 40; ++index)
+        {
+            REQUIRE(host.addService(ServiceDescription("http://localhost::9090",
+                                                       "host_service_a" + std::to_string(index),
+                                                       "host_target_a",
+                                                       "MyTest",
+                                                       "1.1")));
+        }
+        for (int index = 0; index < 10; ++index)
+        {
+            REQUIRE(host.addService(ServiceDescription("http://localhost::9090",
+                                                       "host_service_b" + std::to_string(index),
+                                                       "host_target_b",
+                                                       "MyTest",
+                                                       "1.1")));
+        }
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "host_target_a");
+        host.setMaxResponseDelay(milliseconds(300));
+
+        std::set<std::string> responded;
+        Reactor reactor;
+        reactor.add(host);
+        reactor.add(finder,
+            [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+            {
+                if (update_event._event_id == ServiceFinder::ServiceUpdateEvent::response)
+                {
+                    responded.insert(update_event._service_description.getUniqueServiceName());
+                }
+            });
+
+        REQUIRE(finder.sendMSearch());
+        for (int loop = 0; loop < 5 && responded.size() < 40; ++loop)
+        {
+            REQUIRE(reactor.run(milliseconds(200)));
+        }
+        REQUIRE(responded.size() == 40);
+        //the responses to the M-SEARCH of the other interfaces are still pending
+        REQUIRE(reactor.run(milliseconds(400)));
+
+        //only the services of the search target were answered
+        auto statistics = host.getStatistics();
+        REQUIRE(statistics._response._datagrams_sent > 0);
+        REQUIRE(statistics._response._datagrams_sent % 40 == 0);
+        REQUIRE(statistics._response._send_failures == 0);
+
+        REQUIRE(host.sendNotifyAlive());
+        REQUIRE(host.sendNotifyByeBye());
+
+        reactor.remove(finder);
+        reactor.remove(host);
+    }
+    SECTION("responses are spread within the MX and merged")
+    {
+        ServiceHost host(lssdp::LSSDP_DEFAULT_URL, seconds(1800));
+        for (int index = 0; index < 40; ++index)
+        {
+            REQUIRE(host.addService(ServiceDescription("http://localhost::9090",
+                                                       "spread_service" + std::to_string(index),
+                                                       "spread_target",
+                                                       "MyTest",
+                                                       "1.1")));
+        }
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "spread_target");
+        host.setMaxResponseDelay(milliseconds(500));
+
+        //the time of the first response of each service since the M-SEARCH
+        std::map<std::string, steady_clock::duration> responded;
+        auto search_time = steady_clock::now();
+        Reactor reactor;
+        reactor.add(host);
+        reactor.add(finder,
+            [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+            {
+                if (update_event._event_id == ServiceFinder::ServiceUpdateEvent::response)
+                {
+                    responded.emplace(update_event._service_description.getUniqueServiceName(),
+                                      steady_clock::now() - search_time);
+                }
+            });
+
+        //a control point repeats its M-SEARCH
+        search_time = steady_clock::now();
+        REQUIRE(finder.sendMSearch());
+        REQUIRE(finder.sendMSearch());
+        REQUIRE(finder.sendMSearch());
+        REQUIRE(reactor.run(milliseconds(20)));
+        //not all at the same instant
+        REQUIRE(responded.size() < 40);
+        for (int loop = 0; loop < 10 && responded.size() < 40; ++loop)
+        {
+            REQUIRE(reactor.run(milliseconds(100)));
+        }
+        REQUIRE(responded.size() == 40);
+
+        //all within the MX (and the slack of the timer tick), spread over it
+        auto first = steady_clock::duration::max();
+        auto last = steady_clock::duration::zero();
+        for (const auto& response : responded)
+        {
+            first = (std::min)(first, response.second);
+            last = (std::max)(last, response.second);
+        }
+        REQUIRE(last < milliseconds(650));
+        REQUIRE(last - first >= milliseconds(100));
+
+        //the repeated M-SEARCH was merged into the pending responses
+        REQUIRE(reactor.run(milliseconds(600)));
+        auto statistics = host.getStatistics();
+        REQUIRE(statistics._merged_responses > 0);
+        REQUIRE(statistics._dropped_responses == 0);
+
+        reactor.remove(finder);
+        reactor.remove(host);
+    }
+    SECTION("a requester searching too often is not responded")
+    {
+        ServiceHost host(lssdp::LSSDP_DEFAULT_URL, seconds(1800));
+        REQUIRE(host.addService(ServiceDescription("http://localhost::9090",
+                                                   "limited_service",
+                                                   "limited_target",
+                                                   "MyTest",
+                                                   "1.1")));
+        ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", "limited_target");
+        host.setMaxResponseDelay(milliseconds(0));
+        host.setSearchRateLimit(1.0, 2);
+
+        Reactor reactor;
+        reactor.add(host);
+        reactor.add(finder, [](const ServiceFinder::ServiceUpdateEvent&) {});
+
+        //a control point in a tight loop
+        for (int search = 0; search < 10; ++search)
+        {
+            REQUIRE(finder.sendMSearch());
+        }
+        for (int loop = 0; loop < 5; ++loop)
+        {
+            REQUIRE(reactor.run(milliseconds(50)));
+        }
+
+        //at most two of the ten M-SEARCH of each requester address were responded
+        auto statistics = host.getStatistics();
+        REQUIRE(statistics._response._datagrams_sent > 0);
+        REQUIRE(statistics._response._datagrams_sent * 5 <= statistics._receive._datagrams_received);
+        REQUIRE(statistics._suppressed_msearches >= 4 * statistics._response._datagrams_sent);
+
+        reactor.remove(finder);
+        reactor.remove(host);
+    }
+    SECTION("the search rate limit refills and admits newcomers by their own bucket")
+    {
+        SearchRateLimiter limiter;
+        limiter.setLimit(1.0, 2);
+        const auto start = steady_clock::time_point();
+
+        //a requester has its burst, then one search per second
+        REQUIRE(limiter.allow(1, start));
+        REQUIRE(limiter.allow(1, start));
+        REQUIRE_FALSE(limiter.allow(1, start));
+        REQUIRE_FALSE(limiter.allow(1, start + milliseconds(900)));
+        REQUIRE(limiter.allow(1, start + milliseconds(1900)));
+        REQUIRE_FALSE(limiter.allow(1, start + milliseconds(1900)));
+
+        //cycling through source addresses: each admitted newcomer starts with a full bucket,
+        //the newcomers are capped by their bucket and do not take over the tokens of the evicted
+        uint32_t allowed = 0;
+        for (uint32_t requester = 2; requester < 10000; ++requester)
+        {
+            allowed += limiter.allow(requester, start + seconds(2)) ? 1 : 0;
+            allowed += limiter.allow(requester, start + seconds(2)) ? 1 : 0;
+        }
+        REQUIRE(allowed == 2 * LSSDP_SEARCH_NEWCOMER_BURST);
+
+        //the newcomer bucket refills with its rate
+        allowed = 0;
+        for (uint32_t requester = 10000; requester < 20000; ++requester)
+        {
+            allowed += limiter.allow(requester, start + seconds(3)) ? 1 : 0;
+        }
+        REQUIRE(allowed == static_cast<uint32_t>(LSSDP_SEARCH_NEWCOMER_RATE));
+
+        //0 responds to each
+        limiter.setLimit(0.0, 2);
+        for (int search = 0; search < 10; ++search)
+        {
+            REQUIRE(limiter.allow(1, start));
+        }
+    }
+    SECTION("urn versions, devices and root devices are matched")
+    {
+        ServiceHost host(lssdp::LSSDP_DEFAULT_URL, seconds(1800));
+        for (int version = 1; version <= 3; ++version)
+        {
+            REQUIRE(host.addService(ServiceDescription("http://localhost::9090",
+                                                       "uuid:printer" + std::to_string(version)
+                                                           + "::urn:host-test:device:Printer:" + std::to_string(version),
+                                                       "urn:host-test:device:Printer:" + std::to_string(version),
+                                                       "MyTest",
+                                                       "1.1")));
+        }
+        REQUIRE(host.addService(ServiceDescription("http://localhost::9090",
+                                                   "uuid:printer2::upnp:rootdevice",
+                                                   "host_test_root",
+                                                   "MyTest",
+                                                   "1.1")));
+        host.setMaxResponseDelay(milliseconds(0));
+
+        Reactor reactor;
+        reactor.add(host);
+        auto search = [&reactor](const std::string& search_target)
+        {
+            ServiceFinder finder(lssdp::LSSDP_DEFAULT_URL, "MyTest", "1.1", search_target);
+            //the USN of each response with its ST
+            std::map<std::string, std::string> responded;
+            reactor.add(finder,
+                [&](const ServiceFinder::ServiceUpdateEvent& update_event)
+                {
+                    if (update_event._event_id == ServiceFinder::ServiceUpdateEvent::response)
+                    {
+                        responded[update_event._service_description.getUniqueServiceName()]
+                            = update_event._service_description.getSearchTarget();
+                    }
+                });
+            REQUIRE(finder.sendMSearch());
+            for (int loop = 0; loop < 3; ++loop)
+            {
+                REQUIRE(reactor.run(milliseconds(50)));
+            }
+            reactor.remove(finder);
+            return responded;
+        };
+
+        //the version and the later ones, each response echoes the searched version
+        REQUIRE(search("urn:host-test:device:Printer:2")
+                == std::map<std::string, std::string>({
+                       { "uuid:printer2::urn:host-test:device:Printer:2", "urn:host-test:device:Printer:2" },
+                       { "uuid:printer3::urn:host-test:device:Printer:3", "urn:host-test:device:Printer:2" } }));
+        REQUIRE(search("urn:host-test:device:Printer:4").empty());
+        //all services of the device, with the ST of the device
+        REQUIRE(search("uuid:printer2")
+                == std::map<std::string, std::string>({
+                       { "uuid:printer2::urn:host-test:device:Printer:2", "uuid:printer2" },
+                       { "uuid:printer2::upnp:rootdevice", "uuid:printer2" } }));
+        REQUIRE(search("upnp:rootdevice")
+                == std::map<std::string, std::string>({
+                       { "uuid:printer2::upnp:rootdevice", "upnp:rootdevice" } }));
+        //ssdp:all is responded with the ST of each service
+        auto all = search("ssdp:all");
+        REQUIRE(all.size() >= 4);
+        REQUIRE(all["uuid:printer1::urn:host-test:device:Printer:1"] == "urn:host-test:device:Printer:1");
+        REQUIRE(all["uuid:printer2::upnp:rootdevice"] == "host_test_root");
+
+        reactor.remove(host);
+    }
+#ifdef __linux__
+    SECTION("the response leaves from the SSDP port")
+    {
+        Service service(lssdp::LSSDP_DEFAULT_URL,
+                        seconds(1800),
+                        "http://localhost::9090",
+                        "source_port_service",
+                        "source_port_target",
+                        "MyTest",
+                        "1.1");
+        ServiceHost host(lssdp::LSSDP_DEFAULT_URL, seconds(1800));
+        REQUIRE(host.addService(ServiceDescription("http://localhost::9090",
+                                                   "source_port_hosted",
+                                                   "source_port_target",
+                                                   "MyTest",
+                                                   "1.1")));
+        Reactor reactor;
+        reactor.add(service);
+        reactor.add(host);
+
+        //a control point with a plain socket on an ephemeral port, the M-SEARCH without MX is responded at once
+        int requester = socket(AF_INET, SOCK_DGRAM, 0);
+        REQUIRE(requester >= 0);
+        struct timeval receive_timeout = { 0, 100000 };
+        REQUIRE(setsockopt(requester, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout)) == 0);
+        const std::string msearch = "M-SEARCH * HTTP/1.1\r\n"
+                                    "HOST:239.255.255.250:1900\r\n"
+                                    "MAN:\"ssdp:discover\"\r\n"
+                                    "ST:source_port_target\r\n"
+                                    "\r\n";
+        struct sockaddr_in group;
+        memset(&group, 0, sizeof(group));
+        group.sin_family = AF_INET;
+        group.sin_port = htons(1900);
+        group.sin_addr.s_addr = inet_addr("239.255.255.250");
+        REQUIRE(sendto(requester, msearch.data(), msearch.size(), 0,
+                       reinterpret_cast<struct sockaddr*>(&group), sizeof(group)) == static_cast<ssize_t>(msearch.size()));
+
+        std::set<std::string> responded;
+        for (int loop = 0; loop < 5 && responded.size() < 2; ++loop)
+        {
+            REQUIRE(reactor.run(milliseconds(50)));
+            char buffer[2048];
+            struct sockaddr_in from;
+            socklen_t from_size = sizeof(from);
+            ssize_t received = 0;
+            while ((received = recvfrom(requester, buffer, sizeof(buffer), MSG_DONTWAIT,
+                                        reinterpret_cast<struct sockaddr*>(&from), &from_size)) > 0)
+            {
+                const std::string response(buffer, static_cast<size_t>(received));
+                REQUIRE(ntohs(from.sin_port) == 1900);
+                responded.insert(response.find("USN:source_port_hosted") != std::string::npos
+                                 ? "hosted" : "service");
+            }
+        }
+        close(requester);
+        REQUIRE(responded == std::set<std::string>({ "hosted", "service" }));
+
+        reactor.remove(host);
+        reactor.remove(service);
+    }
+#endif
+}